@@ -0,0 +1,65 @@
+#include "ofMain.h"
+#include "ofxRTLSAssociationBenchmark.h"
+
+// Run null system scenarios through the postprocessor without a window, 
+// reporting throughput and association accuracy.
+//
+// Usage:
+//		example_benchmark [-c settings.json] [-n frames] [-o results.json] scenario.json [...]
+//
+// Results for all scenarios are printed and optionally written as json.
+
+// --------------------------------------------------------------
+void printUsage() {
+	cout << "Usage: example_benchmark [-c settings.json] [-n frames] [-o results.json] <scenario.json> ..." << endl;
+}
+
+// --------------------------------------------------------------
+int main(int argc, char* argv[]) {
+
+	string settingsPath = "configs/benchmark-postprocess.json";
+	string outputPath = "";
+	uint64_t maxFrames = 0;
+	vector<string> scenarioPaths;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if ((arg == "-c" || arg == "-o" || arg == "-n") && i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+		if (arg == "-c") settingsPath = argv[++i];
+		else if (arg == "-o") outputPath = argv[++i];
+		else if (arg == "-n") maxFrames = ofToInt64(argv[++i]);
+		else if (arg == "-h" || arg == "--help") {
+			printUsage();
+			return 0;
+		}
+		else scenarioPaths.push_back(arg);
+	}
+	if (scenarioPaths.empty()) {
+		printUsage();
+		return 1;
+	}
+
+	ofJson results;
+	bool bSuccess = true;
+	for (auto& path : scenarioPaths) {
+		ofxRTLSAssociationBenchmark benchmark;
+		if (!benchmark.setup(path, settingsPath)) {
+			bSuccess = false;
+			continue;
+		}
+		ofJson js = benchmark.run(maxFrames).toJson();
+		js["scenario"] = path;
+		cout << js.dump(4) << endl;
+		results.push_back(js);
+	}
+
+	if (!outputPath.empty()) {
+		ofFile file(outputPath, ofFile::WriteOnly);
+		file << results.dump(4);
+	}
+
+	return bSuccess ? 0 : 1;
+}
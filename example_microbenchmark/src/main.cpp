@@ -0,0 +1,87 @@
+#include "ofMain.h"
+#include "ofxRTLSMicrobenchmark.h"
+
+// Measure the per-frame hot paths of ofxRTLS without a window.
+//
+// Usage:
+//		example_microbenchmark [-b benchmark] [-m 10,100,1000,10000] [-t seconds] [-l label] [-o results.jsonl]
+//
+// Each result is printed as a line of json. Results can be appended to a file
+// and labeled (e.g. with a commit hash), so they can be compared across commits.
+
+// Count every heap allocation made by the process
+static std::atomic<uint64_t> nAllocations(0);
+
+// --------------------------------------------------------------
+void* operator new(std::size_t size) {
+	nAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+	throw std::bad_alloc();
+}
+
+// --------------------------------------------------------------
+void* operator new[](std::size_t size) {
+	nAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+	throw std::bad_alloc();
+}
+
+// --------------------------------------------------------------
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// --------------------------------------------------------------
+void printUsage() {
+	cout << "Usage: example_microbenchmark [-b benchmark] [-m 10,100,1000,10000] [-t seconds] [-l label] [-o results.jsonl]" << endl;
+	cout << "Benchmarks: " << ofJoinString(ofxRTLSMicrobenchmark::getBenchmarks(), ", ") << endl;
+}
+
+// --------------------------------------------------------------
+int main(int argc, char* argv[]) {
+
+	string filter = "";
+	string label = "";
+	string outputPath = "";
+	vector<int> markerCounts = { 10, 100, 1000, 10000 };
+	float minDurationSec = 0.5;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if ((arg == "-b" || arg == "-m" || arg == "-t" || arg == "-l" || arg == "-o") && i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+		if (arg == "-b") filter = argv[++i];
+		else if (arg == "-m") {
+			markerCounts.clear();
+			for (auto& s : ofSplitString(argv[++i], ",", true, true)) markerCounts.push_back(ofToInt(s));
+		}
+		else if (arg == "-t") minDurationSec = ofToFloat(argv[++i]);
+		else if (arg == "-l") label = argv[++i];
+		else if (arg == "-o") outputPath = argv[++i];
+		else {
+			printUsage();
+			return (arg == "-h" || arg == "--help") ? 0 : 1;
+		}
+	}
+
+	ofxRTLSMicrobenchmark benchmark;
+	benchmark.setMarkerCounts(markerCounts);
+	benchmark.setMinDuration(minDurationSec);
+	benchmark.setAllocationCounter([]() { return nAllocations.load(std::memory_order_relaxed); });
+
+	ofstream output;
+	if (!outputPath.empty()) output.open(ofToDataPath(outputPath), ios::app);
+
+	benchmark.run(filter, [&](const ofxRTLSMicrobenchmark::Result& r) {
+		ofJson js = r.toJson();
+		if (!label.empty()) js["label"] = label;
+		string line = js.dump();
+		cout << line << endl;
+		if (output.is_open()) output << line << endl;
+	});
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include "ofMain.h"
+#include "ofxRTLSBatchProcessor.h"
+
+// Reprocess recorded takes through the postprocessor without a window.
+//
+// Usage:
+//		example_reprocess [-c settings.json] [-o outputFolder] [-j threads] take.c3d [folder ...]
+//
+// Folders are searched (non-recursively) for .c3d files.
+
+// --------------------------------------------------------------
+void printUsage() {
+	cout << "Usage: example_reprocess [-c settings.json] [-o outputFolder] [-j threads] <take.c3d | folder> ..." << endl;
+}
+
+// --------------------------------------------------------------
+int main(int argc, char* argv[]) {
+
+	string settingsPath = "configs/reprocess-config.json";
+	string outputFolder = "";
+	int nThreads = 0;
+	vector<string> takePaths;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if ((arg == "-c" || arg == "-o" || arg == "-j") && i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+		if (arg == "-c") settingsPath = argv[++i];
+		else if (arg == "-o") outputFolder = argv[++i];
+		else if (arg == "-j") nThreads = ofToInt(argv[++i]);
+		else if (arg == "-h" || arg == "--help") {
+			printUsage();
+			return 0;
+		}
+		else {
+			ofFile file(arg);
+			if (file.isDirectory()) {
+				ofDirectory dir(arg);
+				dir.allowExt("c3d");
+				dir.listDir();
+				dir.sort();
+				for (int j = 0; j < dir.size(); j++) takePaths.push_back(dir.getPath(j));
+			}
+			else {
+				takePaths.push_back(arg);
+			}
+		}
+	}
+	if (takePaths.empty()) {
+		printUsage();
+		return 1;
+	}
+
+	ofxRTLSBatchProcessor processor;
+	if (!processor.setup(settingsPath)) return 1;
+
+	uint64_t startTime = ofGetElapsedTimeMillis();
+	int nSucceeded = processor.process(takePaths, outputFolder, nThreads);
+	cout << "Processed " << nSucceeded << " of " << takePaths.size() << " takes in "
+		<< (ofGetElapsedTimeMillis() - startTime) / 1000.0 << " seconds" << endl;
+
+	return nSucceeded == int(takePaths.size()) ? 0 : 1;
+}
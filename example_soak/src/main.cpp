@@ -0,0 +1,100 @@
+#include "ofMain.h"
+#include "ofxRTLS.h"
+#include "ofxRTLSSoakMonitor.h"
+
+// Run ofxRTLS for hours without a window, monitoring memory and the sizes of 
+// internal structures, and fail if they keep growing once warmed up.
+//
+// Usage:
+//		example_soak [-c soak-config.json] [-d hours]
+//
+// Systems are enabled in configs/rtls-config.json. The null system is 
+// configured with RemoteUI (its settings are loaded from the saved RemoteUI 
+// settings file); enable "NuS- Send Fake Data" and set the frame rate and 
+// number of points to production values.
+// Returns 0 if no metric grew faster than its threshold.
+
+// --------------------------------------------------------------
+void printUsage() {
+	cout << "Usage: example_soak [-c soak-config.json] [-d hours]" << endl;
+}
+
+// --------------------------------------------------------------
+int main(int argc, char* argv[]) {
+
+	string configPath = "configs/soak-config.json";
+	float durationHours = -1;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if ((arg == "-c" || arg == "-d") && i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+		if (arg == "-c") configPath = argv[++i];
+		else if (arg == "-d") durationHours = ofToFloat(argv[++i]);
+		else {
+			printUsage();
+			return (arg == "-h" || arg == "--help") ? 0 : 1;
+		}
+	}
+
+	ofJson config = ofLoadJson(configPath);
+	if (!config.is_object()) {
+		ofLogError("example_soak") << "Could not load soak config \"" << configPath << "\"";
+		return 1;
+	}
+	if (durationHours < 0) durationHours = config.value("durationHours", 24.0f);
+	bool bFailFast = config.value("failFast", false);
+	string reportPath = config.value("reportPath", string("soak-report.json"));
+	float recordPeriodSec = config.value("recordPeriodSec", 0.0f);
+	float recordDurationSec = config.value("recordDurationSec", 60.0f);
+
+	RUI_SETUP();
+	RUI_LOAD_FROM_XML();
+
+	ofxRTLS tracker;
+	tracker.setup();
+	tracker.start();
+
+	ofxRTLSSoakMonitor monitor;
+	monitor.setup(config.value("monitor", ofJson::object()));
+
+	// Periodically record takes, so takes are also created and saved
+	float nextRecordSec = recordPeriodSec;
+	float stopRecordSec = 0;
+
+	while (monitor.getElapsedSec() < durationHours * 3600.0) {
+
+		ofSleepMillis(100);
+
+		if (monitor.update(tracker.getDiagnostics())) {
+			cout << "[" << ofToString(monitor.getElapsedSec() / 3600.0, 3) << " h] "
+				<< "memory " << ofToString(ofxRTLSSoakMonitor::getProcessMemoryBytes() / 1048576.0, 1) << " MB, "
+				<< "fps " << ofToString(tracker.getFPS(), 1)
+				<< (monitor.isFailing() ? ", FAILING" : "") << endl;
+			if (bFailFast && monitor.isFailing()) break;
+		}
+
+		if (recordPeriodSec > 0) {
+			float elapsed = monitor.getElapsedSec();
+			if (!tracker.isRecording() && elapsed >= nextRecordSec) {
+				tracker.toggleRecording();
+				stopRecordSec = elapsed + recordDurationSec;
+				nextRecordSec += recordPeriodSec;
+			}
+			else if (tracker.isRecording() && elapsed >= stopRecordSec) {
+				tracker.toggleRecording();
+			}
+		}
+	}
+
+	if (tracker.isRecording()) tracker.toggleRecording();
+	tracker.stop();
+
+	ofJson report = monitor.getReport();
+	ofSaveJson(reportPath, report);
+	cout << report.dump(4) << endl;
+
+	return report["failing"].get<bool>() ? 1 : 0;
+}
@@ -6,64 +6,334 @@ IDDictionary::IDDictionary() {
 
 // --------------------------------------------------------------
 IDDictionary::~IDDictionary() {
+
+	// Stop the reload thread, if it is running
+	{
+		std::lock_guard<std::mutex> lk(reloadMutex);
+		bAutoReload = false;
+		stopThread();
+	}
+	reloadCV.notify_one();
+	waitForThread(false);
 }
 
 // --------------------------------------------------------------
 bool IDDictionary::setup(string _filepath) {
-	bValid = false;
-	dict.clear();
+
+	atomic_store(&table, shared_ptr<const Table>());
+	nReloads = 0;
+	{
+		std::lock_guard<std::mutex> lk(reloadMutex);
+		filepath = _filepath;
+		stamp = FileStamp();
+	}
 
 	// Attempt to load from file
 	if (_filepath.empty()) {
 		ofLogError("IDDictionary") << "Dictionary path is empty. Cannot load from file.";
-		return bValid;
+		return false;
+	}
+
+	FileStamp newStamp;
+	shared_ptr<Table> loaded = load(_filepath, newStamp);
+	{
+		std::lock_guard<std::mutex> lk(reloadMutex);
+		stamp = newStamp;
+	}
+	if (!loaded) return false;
+	atomic_store(&table, shared_ptr<const Table>(loaded));
+	ofLogNotice("IDDictionary") << "Dictionary successfully loaded from " << filepath;
+	return true;
+}
+
+// --------------------------------------------------------------
+int IDDictionary::lookup(int value) {
+
+	shared_ptr<const Table> t = getTable();
+	if (!t) return value;
+	return t->lookup(value);
+}
+
+// --------------------------------------------------------------
+int IDDictionary::getNumBits() {
+
+	shared_ptr<const Table> t = getTable();
+	return t ? t->nBits : 0;
+}
+
+// --------------------------------------------------------------
+size_t IDDictionary::getNumEntries() {
+
+	shared_ptr<const Table> t = getTable();
+	return t ? t->values.size() : 0;
+}
+
+// --------------------------------------------------------------
+int IDDictionary::Table::lookup(int value) const {
+
+	if (value < 0) return -1;
+	if (!dense.empty()) return value < dense.size() ? dense[value] : -1;
+	auto it = lower_bound(values.begin(), values.end(), uint32_t(value));
+	if (it == values.end() || *it != uint32_t(value)) return -1;
+	return ids[it - values.begin()];
+}
+
+// --------------------------------------------------------------
+bool IDDictionary::getFileStamp(string path, FileStamp& _stamp) {
+
+	try {
+		std::filesystem::path p(path);
+		if (!std::filesystem::exists(p)) return false;
+		_stamp.size = uint64_t(std::filesystem::file_size(p));
+		_stamp.modified = int64_t(std::filesystem::last_write_time(p).time_since_epoch().count());
+	}
+	catch (const std::exception& e) {
+		return false;
 	}
-	filepath = _filepath;
+	return true;
+}
+
+// --------------------------------------------------------------
+shared_ptr<IDDictionary::Table> IDDictionary::load(string path, FileStamp& _stamp) {
+
+	string absPath = ofToDataPath(path, true);
+	if (!getFileStamp(absPath, _stamp)) {
+		ofLogError("IDDictionary") << "Dictionary file appears to be missing: " << path;
+		return nullptr;
+	}
+
+	// Prefer the cache, which is much faster to load
+	shared_ptr<Table> out = loadCache(getCachePath(absPath), _stamp);
+	if (out) return out;
 
-	// Attempt to load the file
-	ofFile file(ofToDataPath(filepath));
-	if (!file.exists()) {
-		ofLogError("IDDictionary") << "Dictionary file appears to be missing: " << filepath;
-		return bValid;
+	out = loadJson(absPath);
+	if (!out) return nullptr;
+	if (!saveCache(getCachePath(absPath), _stamp, *out)) {
+		ofLogWarning("IDDictionary") << "Could not cache the dictionary " << path;
 	}
+	return out;
+}
+
+// --------------------------------------------------------------
+shared_ptr<IDDictionary::Table> IDDictionary::loadJson(string path) {
+
+	ofFile file(path);
 	ofJson js;
-	file >> js;
+	try {
+		file >> js;
+	}
+	catch (const std::exception& e) {
+		ofLogError("IDDictionary") << "Dictionary is not valid json: " << e.what();
+		return nullptr;
+	}
 	if (js.find("nBits") == js.end()) {
 		ofLogError("IDDictionary") << "JSON must contain a variable \"nBits\"";
-		return bValid;
+		return nullptr;
+	}
+	shared_ptr<Table> out = make_shared<Table>();
+	out->nBits = js["nBits"];
+	if (out->nBits < 1 || out->nBits > 31) {
+		ofLogError("IDDictionary") << "Dictionary values must have between 1 and 31 bits.";
+		return nullptr;
 	}
-	int nBits = js["nBits"];
 	if (js.find("dict") == js.end()) {
 		ofLogError("IDDictionary") << "JSON dictionary must be mapped to key \"dict\"";
-		return bValid;
+		return nullptr;
 	}
-	if (js["dict"].size() != pow(2, nBits)) {
-		ofLogError("IDDictionary") << "Dict must contain all values, even invalid ones";
-		return bValid;
+	uint64_t nValues = uint64_t(1) << out->nBits;
+	ofJson& dict = js["dict"];
+
+	if (dict.is_array()) {
+		// Every value is listed, in order
+		if (dict.size() != nValues) {
+			ofLogError("IDDictionary") << "Dict must contain all values, even invalid ones";
+			return nullptr;
+		}
+		for (uint64_t i = 0; i < nValues; i++) {
+			int ID = dict[i];
+			if (ID < 0) continue;
+			out->values.push_back(uint32_t(i));
+			out->ids.push_back(ID);
+		}
 	}
-	dict.resize(pow(2, nBits), -1);
-	for (int i = 0; i < dict.size(); i++) {
-		dict[i] = js["dict"][i];
+	else if (dict.is_object()) {
+		// Only mapped values are listed, by their decimal strings
+		vector<pair<uint32_t, int>> entries;
+		entries.reserve(dict.size());
+		for (auto it = dict.begin(); it != dict.end(); it++) {
+			char* end = NULL;
+			uint64_t value = strtoull(it.key().c_str(), &end, 10);
+			if (it.key().empty() || *end != '\0' || value >= nValues || !it.value().is_number_integer()) {
+				ofLogError("IDDictionary") << "Dict entry \"" << it.key() << "\" is not a value of " << out->nBits << " bits mapped to an ID";
+				return nullptr;
+			}
+			int ID = it.value();
+			if (ID < 0) continue;
+			entries.push_back(make_pair(uint32_t(value), ID));
+		}
+		sort(entries.begin(), entries.end());
+		for (size_t i = 0; i < entries.size(); i++) {
+			if (i > 0 && entries[i].first == entries[i - 1].first) {
+				ofLogError("IDDictionary") << "Dict maps the value " << entries[i].first << " more than once";
+				return nullptr;
+			}
+			out->values.push_back(entries[i].first);
+			out->ids.push_back(entries[i].second);
+		}
 	}
-	ofLogNotice("IDDictionary") << "Dictionary successfully loaded from " << filepath;
-	bValid = true;
-	return bValid;
+	else {
+		ofLogError("IDDictionary") << "Dict must be a list of all values or an object of the values mapped";
+		return nullptr;
+	}
+
+	if (out->nBits <= maxDenseBits) {
+		out->dense.assign(nValues, -1);
+		for (size_t i = 0; i < out->values.size(); i++) out->dense[out->values[i]] = out->ids[i];
+	}
+	return out;
 }
 
 // --------------------------------------------------------------
-int IDDictionary::lookup(int value) {
-	if (!bValid) return value;
+shared_ptr<IDDictionary::Table> IDDictionary::loadCache(string path, const FileStamp& _stamp) {
+
+	if (!ofFile::doesFileExist(path, false)) return nullptr;
+	ofBuffer buffer = ofBufferFromFile(path, true);
+	const char* data = buffer.getData();
+	size_t size = buffer.size();
+
+	size_t pos = 0;
+	bool bValid = true;
+	auto readU64 = [&]() -> uint64_t {
+		uint64_t value = 0;
+		if (pos + sizeof(value) > size) {
+			bValid = false;
+			return value;
+		}
+		memcpy(&value, data + pos, sizeof(value));
+		pos += sizeof(value);
+		return value;
+	};
+
+	// [magic][json size][json modification time][nBits][number of entries]
+	// then the values (uint32) and their IDs (int32)
+	if (readU64() != cacheMagic) return nullptr;
+	FileStamp cached;
+	cached.size = readU64();
+	cached.modified = int64_t(readU64());
+	if (!bValid || cached != _stamp) return nullptr;
+
+	shared_ptr<Table> out = make_shared<Table>();
+	out->nBits = int(readU64());
+	uint64_t nEntries = readU64();
+	if (!bValid || out->nBits < 1 || out->nBits > 31) return nullptr;
+	if (nEntries > (uint64_t(1) << out->nBits) || (size - pos) != nEntries * (sizeof(uint32_t) + sizeof(int32_t))) return nullptr;
+
+	out->values.resize(nEntries);
+	out->ids.resize(nEntries);
+	memcpy(out->values.data(), data + pos, nEntries * sizeof(uint32_t));
+	pos += nEntries * sizeof(uint32_t);
+	for (uint64_t i = 0; i < nEntries; i++) {
+		int32_t ID;
+		memcpy(&ID, data + pos + i * sizeof(int32_t), sizeof(int32_t));
+		out->ids[i] = ID;
+	}
 
-	if (dict.empty() || value < 0 || value > dict.size()) return -1;
-	else return dict[value];
+	if (out->nBits <= maxDenseBits) {
+		out->dense.assign(size_t(1) << out->nBits, -1);
+		for (size_t i = 0; i < out->values.size(); i++) {
+			if (out->values[i] >= out->dense.size()) return nullptr;
+			out->dense[out->values[i]] = out->ids[i];
+		}
+	}
+	return out;
 }
 
 // --------------------------------------------------------------
+bool IDDictionary::saveCache(string path, const FileStamp& _stamp, const Table& _table) {
 
-// --------------------------------------------------------------
+	string out;
+	auto writeU64 = [&out](uint64_t value) {
+		out.append((const char*)&value, sizeof(value));
+	};
+	writeU64(cacheMagic);
+	writeU64(_stamp.size);
+	writeU64(uint64_t(_stamp.modified));
+	writeU64(_table.nBits);
+	writeU64(_table.values.size());
+	out.append((const char*)_table.values.data(), _table.values.size() * sizeof(uint32_t));
+	for (int ID : _table.ids) {
+		int32_t value = ID;
+		out.append((const char*)&value, sizeof(value));
+	}
+
+	ofBuffer buffer(out.data(), out.size());
+	return ofBufferToFile(path, buffer, true);
+}
 
 // --------------------------------------------------------------
+void IDDictionary::setAutoReload(bool _bAutoReload, float _periodSec) {
+
+	{
+		std::lock_guard<std::mutex> lk(reloadMutex);
+		bAutoReload = _bAutoReload;
+		periodSec = MAX(_periodSec, 0.01f);
+	}
+	if (bAutoReload && !isThreadRunning()) startThread();
+	reloadCV.notify_one();
+}
 
 // --------------------------------------------------------------
+void IDDictionary::requestReload() {
+
+	{
+		std::lock_guard<std::mutex> lk(reloadMutex);
+		bReloadRequested = true;
+	}
+	if (!isThreadRunning()) startThread();
+	reloadCV.notify_one();
+}
 
 // --------------------------------------------------------------
+void IDDictionary::threadedFunction() {
+
+	while (isThreadRunning()) {
+
+		bool bReload = false;
+		string path;
+		FileStamp lastStamp;
+		{
+			std::unique_lock<std::mutex> lk(reloadMutex);
+			// Wake up every period to check the file (or only when a reload
+			// is requested, if not reloading automatically)
+			auto predicate = [this] { return bReloadRequested || !isThreadRunning(); };
+			if (bAutoReload) reloadCV.wait_for(lk, std::chrono::microseconds(uint64_t(periodSec * 1000000.0)), predicate);
+			else reloadCV.wait(lk, predicate);
+			if (!isThreadRunning()) break;
+			bReload = bReloadRequested;
+			bReloadRequested = false;
+			path = filepath;
+			lastStamp = stamp;
+		}
+		if (path.empty()) continue;
+
+		// Only reload when the file changes, unless requested
+		FileStamp newStamp;
+		if (!getFileStamp(ofToDataPath(path, true), newStamp)) continue;
+		if (!bReload && newStamp == lastStamp) continue;
+
+		// Load the new table while lookups continue with the current one
+		shared_ptr<Table> loaded = load(path, newStamp);
+		{
+			std::lock_guard<std::mutex> lk(reloadMutex);
+			if (path != filepath) continue;
+			stamp = newStamp;
+		}
+		if (!loaded) {
+			ofLogError("IDDictionary") << "Could not reload the dictionary " << path << ". The previous dictionary is still used.";
+			continue;
+		}
+		atomic_store(&table, shared_ptr<const Table>(loaded));
+		nReloads++;
+		ofLogNotice("IDDictionary") << "Dictionary reloaded from " << path << " (" << loaded->values.size() << " entries)";
+	}
+}
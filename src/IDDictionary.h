@@ -2,7 +2,15 @@
 
 #include "ofMain.h"
 
-class IDDictionary {
+// Maps the IDs reported by a system (e.g. Motive's active marker IDs) to
+// other IDs (e.g. Lamp IDs), as described by a json dictionary. Dictionaries
+// may list every value or only the values that are mapped (see the README).
+// Loaded dictionaries are cached in a binary file next to the json (with the
+// extension ".cache"), which is loaded instead of the json until the json
+// changes.
+// Lookups never wait for a reload: each dictionary is loaded into a new table,
+// which replaces the current table atomically once it is complete.
+class IDDictionary : public ofThread {
 public:
 
 	IDDictionary();
@@ -10,20 +18,78 @@ public:
 
 	bool setup(string _filepath = "");
 
-	bool isSetup() { return bValid; }
+	bool isSetup() { return getTable() != nullptr; }
 
 	// Lookup a value mapping
 	int lookup(int value);
 
+	// Number of bits of the values mapped (values are less than 2^nBits)
+	int getNumBits();
+	// Number of values mapped to valid IDs
+	size_t getNumEntries();
+
+	// A loaded dictionary. Tables are never modified once they are shared,
+	// so a table can be used for a whole frame while it is replaced.
+	struct Table {
+		int nBits = 0;
+		// Values mapped to valid IDs, in ascending order, and their IDs
+		vector<uint32_t> values;
+		vector<int> ids;
+		// ID of every value, if there are few enough values
+		vector<int> dense;
+
+		// Returns -1 for values that are not mapped
+		int lookup(int value) const;
+	};
+	// Get the current table (null if no dictionary is loaded)
+	shared_ptr<const Table> getTable() const { return atomic_load(&table); }
+
+	// Reload the dictionary whenever its file changes. The file is checked
+	// on a background thread every period.
+	void setAutoReload(bool _bAutoReload, float _periodSec = 1.0);
+	bool isAutoReloading() { return bAutoReload; }
+	// Reload the dictionary on the background thread
+	void requestReload();
+	// Number of times the dictionary has been replaced since it was setup
+	uint64_t getNumReloads() { return nReloads; }
+
+	// Dictionaries with at most this many bits are also kept as a list of
+	// every value, so lookups don't need to search.
+	static const int maxDenseBits = 16;
+
 private:
 
 	// The path at which the dictionary is loaded
 	string filepath = "";
 
 	// This is the dictionary, mapping Motive ID (int) to Lamp ID (int)
-	vector<int> dict;
+	shared_ptr<const Table> table;
+
+	// Size and modification time of a file, to tell when it changes
+	struct FileStamp {
+		uint64_t size = 0;
+		int64_t modified = 0;
+		bool operator==(const FileStamp& other) const { return size == other.size && modified == other.modified; }
+		bool operator!=(const FileStamp& other) const { return !(*this == other); }
+	};
+	static bool getFileStamp(string path, FileStamp& stamp);
+	FileStamp stamp;
+
+	// Load a table from the cache, if it is up to date, or else from the json
+	shared_ptr<Table> load(string path, FileStamp& _stamp);
+	shared_ptr<Table> loadJson(string path);
+	shared_ptr<Table> loadCache(string path, const FileStamp& _stamp);
+	bool saveCache(string path, const FileStamp& _stamp, const Table& _table);
+	static string getCachePath(string path) { return path + ".cache"; }
+	static const uint64_t cacheMagic = 0x3143494449534C52; // "RLSIDIC1"
 
-	// Is the mapping loaded?
-	bool bValid = false;
+	// Reload the dictionary on this thread
+	void threadedFunction();
+	bool bAutoReload = false;
+	float periodSec = 1.0;
+	std::mutex reloadMutex;
+	std::condition_variable reloadCV;
+	bool bReloadRequested = false;
+	atomic<uint64_t> nReloads = 0;
 
-};
\ No newline at end of file
+};
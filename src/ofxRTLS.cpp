@@ -3,6 +3,7 @@
 // --------------------------------------------------------------
 ofxRTLS::ofxRTLS() {
 
+	for (int i = 0; i < NUM_RTLS_SYSTEM_TYPES; i++) primarySources[i] = NULL;
 }
 
 // --------------------------------------------------------------
@@ -41,41 +42,241 @@ void ofxRTLS::setup() {
 		ofAddListener(player.newPlaybackData, this, &ofxRTLS::playerDataReceived);
 	}
 	
-	if (RTLS_NULL()) {
-		
-		// Setup params
-		nsys.setup();
-		// Add listener for new data
-		ofAddListener(nsys.newDataReceived, this, &ofxRTLS::nsysDataReceived);
-
-		if (RTLS_POSTPROCESS()) {
-			nsysPostM.setup(RTLS_SYSTEM_TYPE_NULL, RTLS_TRACKABLE_TYPE_SAMPLE,
-				"NullSysMarkers", "NM");
-			if (RTLS_PLAYER()) {
-				ofAddListener(player.takeLooped, &nsysPostM, &ofxRTLSPostprocessor::resetEventReceved);
-			}
+	// Pass every frame to the synchronizer before the application 
+	// receives it (if frames are synchronized)
+	ofAddListener(newFrameReceived, &synchronizer, &ofxRTLSSynchronizer::frameReceived, OF_EVENT_ORDER_BEFORE_APP);
+	ofAddListener(synchronizer.newFrameSynchronized, this, &ofxRTLS::synchronizerFrameReceived);
+
+	// Setup each source and begin receiving its data
+	{
+		std::lock_guard<std::mutex> lk(reconfigureMutex);
+		applyConfig();
+	}
+	
+	// Add a listener for any new latency measurements
+	ofAddListener(latencyCalculated, this, &ofxRTLS::newLatencyCalculated);
+	
+	startThread();
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::start() {
+	// Start communications with the trackers
+	bStarted = true;
+	for (auto& source : sources) {
+		if (source->bActive) startSource(*source);
+	}
+	if (bSynchronize) synchronizer.start();
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::stop() {
+	// Stop communication with the trackers
+	bStarted = false;
+	for (auto& source : sources) {
+		if (source->bActive) stopSource(*source);
+	}
+	synchronizer.stop();
+}
+
+// --------------------------------------------------------------
+bool ofxRTLS::reloadConfig(string configPath) {
+
+	std::lock_guard<std::mutex> lk(reconfigureMutex);
+	uint64_t startTime = ofGetElapsedTimeMicros();
+
+	if (!RTLS_CONFIG()->reload(configPath)) return false;
+	ofLogNotice("ofxRTLS") << getSupport();
+
+	applyConfig();
+
+	ofLogNotice("ofxRTLS") << "Reconfigured in " << double(ofGetElapsedTimeMicros() - startTime) / 1000.0 << " ms";
+	return true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::applyConfig() {
+
+	// Find (or create) the source of each configured instance
+	vector<Source*> configured;
+	for (auto& c : RTLS_CONFIG()->sources()) {
+		Source* source = getSource(c.id);
+		if (source == NULL) {
+			sources.push_back(unique_ptr<Source>(new Source()));
+			source = sources.back().get();
+			source->rtls = this;
+			source->id = c.id;
+			source->systemType = c.systemType;
+		}
+		else if (source->systemType != c.systemType) {
+			ofLogError("ofxRTLS") << "Source \"" << c.id << "\" was previously a " << 
+				getRTLSSystemTypeDescription(source->systemType) << " source. Restart to change its system.";
+			continue;
 		}
+		configured.push_back(source);
 	}
 
-	if (RTLS_OPENVR()) {
-		
-		// Setup Params
-		openvr.setup();
-		// Add listeners for new data
-		ofAddListener(openvr.newDataReceived, this, &ofxRTLS::openvrDataReceived);
-
-		if (RTLS_POSTPROCESS()) {
-			// Setup the postprocessor
-			openvrPostM.setup(RTLS_SYSTEM_TYPE_OPENVR, RTLS_TRACKABLE_TYPE_SAMPLE,
-				"OpenVRMarkers", "OM");
-			if (RTLS_PLAYER()) {
-				ofAddListener(player.takeLooped, &openvrPostM, &ofxRTLSPostprocessor::resetEventReceved);
-			}
+	// Detach the sources that are no longer configured, or whose 
+	// postprocessing has been enabled or disabled. The other sources keep
+	// running.
+	for (auto& source : sources) {
+		if (!source->bActive) continue;
+		bool bConfigured = find(configured.begin(), configured.end(), source.get()) != configured.end();
+		if (!bConfigured || source->bPostprocessed != RTLS_POSTPROCESS()) detachSource(*source);
+	}
+
+	// The first source of each system is recorded and replaced by playback
+	Source* primary[NUM_RTLS_SYSTEM_TYPES] = { NULL };
+	for (auto source : configured) {
+		if (primary[source->systemType] == NULL) primary[source->systemType] = source;
+	}
+	for (auto& source : sources) source->bPrimary = primary[source->systemType] == source.get();
+	for (int i = 0; i < NUM_RTLS_SYSTEM_TYPES; i++) primarySources[i] = primary[i];
+
+	// Attach the sources that are newly configured
+	for (auto source : configured) attachSource(*source);
+
+	// Synchronize frames, if configured
+	ofJson syncSettings = RTLS_CONFIG()->sync();
+	bSynchronize = syncSettings.is_object() && syncSettings.value("enabled", true);
+	synchronizer.stop();
+	synchronizer.clear();
+	if (bSynchronize) {
+		synchronizer.setup(syncSettings);
+		if (bStarted) synchronizer.start();
+	}
+}
+
+// --------------------------------------------------------------
+ofxRTLS::Source* ofxRTLS::getSource(string id) {
+
+	for (auto& source : sources) {
+		if (source->id == id) return source.get();
+	}
+	return NULL;
+}
+
+// --------------------------------------------------------------
+ofxRTLS::Source* ofxRTLS::getPrimarySource(RTLSSystemType systemType) {
+
+	if (systemType <= RTLS_SYSTEM_TYPE_INVALID || systemType >= NUM_RTLS_SYSTEM_TYPES) return NULL;
+	return primarySources[systemType];
+}
+
+// --------------------------------------------------------------
+ofxRTLSPostprocessor* ofxRTLS::Source::getPostprocessor(RTLSTrackableType trackableType) {
+
+	for (auto& p : postprocessors) {
+		if (p.trackableType == trackableType) return p.pp.get();
+	}
+	return NULL;
+}
+
+// --------------------------------------------------------------
+const string& ofxRTLS::Source::getContext(RTLSSystemType _systemType, RTLSTrackableType trackableType) {
+
+	static const string invalid = "";
+	if (_systemType < 0 || _systemType >= NUM_RTLS_SYSTEM_TYPES) return invalid;
+	if (trackableType < 0 || trackableType >= NUM_RTLS_TRACKABLE_TYPES) return invalid;
+
+	string& context = contexts[_systemType][trackableType];
+	if (context.empty()) {
+		RTLSFrameContext c;
+		c.systemType = _systemType;
+		c.trackableType = trackableType;
+		c.sourceID = id;
+		context = c.toString();
+	}
+	return context;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLS::isValidTrackableType(RTLSSystemType systemType, RTLSTrackableType trackableType) {
+
+	switch (systemType) {
+	case RTLS_SYSTEM_TYPE_NULL:
+	case RTLS_SYSTEM_TYPE_OPENVR: return trackableType == RTLS_TRACKABLE_TYPE_SAMPLE;
+	case RTLS_SYSTEM_TYPE_MOTIVE: return trackableType == RTLS_TRACKABLE_TYPE_SAMPLE || 
+		trackableType == RTLS_TRACKABLE_TYPE_OBSERVER; // markers and cameras
+	default: return false;
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::attachSource(Source& source) {
+
+	if (source.bActive) return;
+
+	// Setup the source the first time it is configured
+	if (!source.bSetup) {
+		setupSource(source);
+		source.bSetup = true;
+	}
+
+	if (RTLS_POSTPROCESS()) {
+		if (!source.bPostprocessorsSetup) {
+			setupSourcePostprocessors(source);
+			source.bPostprocessorsSetup = true;
+		}
+		else {
+			// Frames were missed while the source was detached, so
+			// histories are no longer valid
+			for (auto& p : source.postprocessors) p.pp->reset();
 		}
+		source.bPostprocessed = true;
 	}
-	
-	if (RTLS_MOTIVE()) {
+	else {
+		source.bPostprocessed = false;
+	}
+	source.bActive = true;
+
+	// Add a listener for new data
+	switch (source.systemType) {
+	case RTLS_SYSTEM_TYPE_NULL: ofAddListener(source.nsys->newDataReceived, &source, &Source::nsysDataReceived); break;
+	case RTLS_SYSTEM_TYPE_OPENVR: ofAddListener(openvr.newDataReceived, &source, &Source::openvrDataReceived); break;
+	case RTLS_SYSTEM_TYPE_MOTIVE: ofAddListener(motive.newDataReceived, &source, &Source::motiveDataReceived); break;
+	default: break;
+	}
+
+	if (bStarted) startSource(source);
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::detachSource(Source& source) {
+
+	if (!source.bActive) return;
+
+	// Stop sending this source's frames, then stop receiving them
+	source.bActive = false;
+	switch (source.systemType) {
+	case RTLS_SYSTEM_TYPE_NULL: ofRemoveListener(source.nsys->newDataReceived, &source, &Source::nsysDataReceived); break;
+	case RTLS_SYSTEM_TYPE_OPENVR: ofRemoveListener(openvr.newDataReceived, &source, &Source::openvrDataReceived); break;
+	case RTLS_SYSTEM_TYPE_MOTIVE: ofRemoveListener(motive.newDataReceived, &source, &Source::motiveDataReceived); break;
+	default: break;
+	}
+	if (bStarted) stopSource(source);
+
+	// Send the frames that are still being postprocessed
+	if (source.bPostprocessed) {
+		for (auto& p : source.postprocessors) p.pp->drain();
+	}
+	source.bPostprocessed = false;
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::setupSource(Source& source) {
 
+	switch (source.systemType) {
+	case RTLS_SYSTEM_TYPE_NULL: {
+		// Setup params
+		source.nsys.reset(new ofxRTLSNullSystem());
+		source.nsys->setup(source.isDefault() ? "" : source.id);
+	}; break;
+	case RTLS_SYSTEM_TYPE_OPENVR: {
+		// Setup Params
+		openvr.setup();
+	}; break;
+	case RTLS_SYSTEM_TYPE_MOTIVE: {
 		// Setup parameters for Motive
 		motive.setupParams();
 
@@ -83,68 +284,96 @@ void ofxRTLS::setup() {
 		RUI_NEW_GROUP("ofxMotive Data");
 		RUI_SHARE_PARAM_WCN("Motive- Send Camera Data", bSendCameraData);
 		RUI_SHARE_PARAM_WCN("Motive- Camera Data Freq", cameraDataFrequency, 0, 300);
-
-		// Add listeners for new data
-		ofAddListener(motive.newDataReceived, this, &ofxRTLS::motiveDataReceived);
-
-		if (RTLS_POSTPROCESS()) {
-			// Setup the postprocessors
-			motivePostM.setup(RTLS_SYSTEM_TYPE_MOTIVE, RTLS_TRACKABLE_TYPE_SAMPLE,
-				"MotiveMarkers", "MM");
-			motivePostR.setup(RTLS_SYSTEM_TYPE_MOTIVE, RTLS_TRACKABLE_TYPE_OBSERVER,
-				"MotiveRef", "MR");
-			if (RTLS_PLAYER()) {
-				ofAddListener(player.takeLooped, &motivePostM, &ofxRTLSPostprocessor::resetEventReceved);
-				ofAddListener(player.takeLooped, &motivePostR, &ofxRTLSPostprocessor::resetEventReceved);
-			}
-		}
+	}; break;
+	default: break;
 	}
-	
-	// Add a listener for any new latency measurements
-	ofAddListener(latencyCalculated, this, &ofxRTLS::newLatencyCalculated);
-	
-	startThread();
 }
 
 // --------------------------------------------------------------
-void ofxRTLS::start() {
-	// Start communications with the trackers
-	
-	if (RTLS_NULL()) {
-		nsys.start();
-	}
-	
-	if (RTLS_OPENVR()) {
-		openvr.connect();
-	}
-	
-	if (RTLS_MOTIVE()) {
-		motive.start();
+void ofxRTLS::setupSourcePostprocessors(Source& source) {
+
+	auto addPostprocessor = [this, &source](RTLSTrackableType trackableType, string name, 
+		string abbr, string diagnosticsName) {
+
+		// Sources that are not named after their system have their own params
+		if (!source.isDefault()) {
+			name += " " + source.id;
+			abbr += "_" + source.id;
+			diagnosticsName += ":" + source.id;
+		}
+		Source::Postprocessor p;
+		p.trackableType = trackableType;
+		p.name = diagnosticsName;
+		p.pp.reset(new ofxRTLSPostprocessor());
+		ofxRTLSPostprocessor& pp = *p.pp;
+
+		// Use the pipeline declared for this source
+		ofJson settings;
+		settings["pipeline"] = RTLS_CONFIG()->pipeline(getRTLSSystemTypeDescription(source.systemType),
+			getRTLSTrackableTypeDescription(trackableType), source.id);
+		pp.applySettings(settings);
+
+		pp.setup(source.systemType, trackableType, name, abbr);
+		ofAddListener(pp.degradationChanged, this, &ofxRTLS::postprocessorDegradationChanged);
+		ofAddListener(pp.outputReady, this, &ofxRTLS::postprocessorOutputReceived);
+		if (RTLS_PLAYER()) {
+			ofAddListener(player.takeLooped, &pp, &ofxRTLSPostprocessor::resetEventReceved);
+			ofAddListener(player.restorePostprocessors, &pp, &ofxRTLSPostprocessor::restoreEventReceived);
+			ofAddListener(pp.stateCaptured, &player, &ofxRTLSPlayer::postprocessorStateCaptured);
+		}
+		source.postprocessors.push_back(std::move(p));
+	};
+
+	switch (source.systemType) {
+	case RTLS_SYSTEM_TYPE_NULL: {
+		addPostprocessor(RTLS_TRACKABLE_TYPE_SAMPLE, "NullSysMarkers", "NM", "nsysPostM");
+	}; break;
+	case RTLS_SYSTEM_TYPE_OPENVR: {
+		addPostprocessor(RTLS_TRACKABLE_TYPE_SAMPLE, "OpenVRMarkers", "OM", "openvrPostM");
+	}; break;
+	case RTLS_SYSTEM_TYPE_MOTIVE: {
+		addPostprocessor(RTLS_TRACKABLE_TYPE_SAMPLE, "MotiveMarkers", "MM", "motivePostM");
+		addPostprocessor(RTLS_TRACKABLE_TYPE_OBSERVER, "MotiveRef", "MR", "motivePostR");
+	}; break;
+	default: break;
 	}
 }
 
 // --------------------------------------------------------------
-void ofxRTLS::stop() {
-	// Stop communication with the trackers
-	if (RTLS_NULL()) {
-		nsys.stop();
-	}
+void ofxRTLS::startSource(Source& source) {
 
-	if (RTLS_OPENVR()) {
-		openvr.disconnect();
+	switch (source.systemType) {
+	case RTLS_SYSTEM_TYPE_NULL: source.nsys->start(); break;
+	case RTLS_SYSTEM_TYPE_OPENVR: openvr.connect(); break;
+	case RTLS_SYSTEM_TYPE_MOTIVE: motive.start(); break;
+	default: break;
 	}
+}
 
-	if (RTLS_MOTIVE()) {
-		motive.stop();
+// --------------------------------------------------------------
+void ofxRTLS::stopSource(Source& source) {
+
+	switch (source.systemType) {
+	case RTLS_SYSTEM_TYPE_NULL: source.nsys->stop(); break;
+	case RTLS_SYSTEM_TYPE_OPENVR: openvr.disconnect(); break;
+	case RTLS_SYSTEM_TYPE_MOTIVE: motive.stop(); break;
+	default: break;
 	}
 }
 
 // --------------------------------------------------------------
-void ofxRTLS::nsysDataReceived(NullSystemEventArgs& args) {
-	if (isPlaying(RTLS_SYSTEM_TYPE_NULL)) return;
+void ofxRTLS::nsysDataReceived(Source& source, NullSystemEventArgs& args) {
+	if (source.bPrimary && isPlaying(RTLS_SYSTEM_TYPE_NULL)) return;
 
 	uint64_t thisMicros = ofGetElapsedTimeMicros();
 
+	// Map the time the frame was generated to the server's clock
+	uint64_t captureMicros = thisMicros;
+	if (args.sourceTimeMicros != 0) {
+		source.clock.addSample(args.sourceTimeMicros, thisMicros);
+		captureMicros = MIN(source.clock.map(args.sourceTimeMicros), thisMicros);
+	}
+
 	markDataReceived();
 
 	// ==============================================
@@ -153,43 +382,72 @@ void ofxRTLS::nsysDataReceived(NullSystemEventArgs& args) {
 	// ==============================================
 
 	ofxRTLSEventArgs outArgs(latencyCalculated);
-	outArgs.setStartAssemblyTime(thisMicros);
-	outArgs.frame.set_frame_id(nsysFrameID);
-	outArgs.frame.set_timestamp(ofGetElapsedTimeMillis());
+	outArgs.setStartAssemblyTime(captureMicros);
+	outArgs.timeMicros = captureMicros;
+	outArgs.sourceTimeMicros = args.sourceTimeMicros;
+	outArgs.frame.set_frame_id(source.frameID);
+	outArgs.frame.set_timestamp(captureMicros / 1000);
 	outArgs.systemType = args.bOverrideContext ? (RTLSSystemType)args.systemOverride : RTLS_SYSTEM_TYPE_NULL;
 	outArgs.trackableType = args.bOverrideContext ? (RTLSTrackableType)args.typeOverride : RTLS_TRACKABLE_TYPE_SAMPLE;
-	{
-		ofJson js;
-		js["s"] = int(outArgs.systemType);
-		js["t"] = int(outArgs.trackableType);
-		outArgs.frame.set_context(js.dump());
-	}
+	// Frames with an overridden context are sent by the primary source of 
+	// their system, so they are attributed to it. (Its cached contexts
+	// belong to its own thread, so this context is built here.)
+	Source* sender = args.bOverrideContext ? getPrimarySource(outArgs.systemType) : &source;
+	if (sender == &source) {
+		outArgs.sourceID = source.id;
+		outArgs.frame.set_context(source.getContext(outArgs.systemType, outArgs.trackableType));
+	}
+	else if (sender != NULL) {
+		RTLSFrameContext c;
+		c.systemType = outArgs.systemType;
+		c.trackableType = outArgs.trackableType;
+		c.sourceID = sender->id;
+		outArgs.sourceID = c.sourceID;
+		outArgs.frame.set_context(c.toString());
+	}
+
+	if (args.bHighScale) {
+		auto& b = args.block;
+		outArgs.frame.mutable_trackables()->Reserve(b.size());
+		for (size_t i = 0; i < b.size(); i++) {
 
-	for (auto& t : args.trackables) {
+			Trackable* trackable = outArgs.frame.add_trackables();
+			if (b.id[i] != 0) trackable->set_id(b.id[i]);
+			if (b.cuid[i] != 0) trackable->set_cuid(source.identities.getString(source.identities.internSerial(b.cuid[i])));
+			Trackable::Position* position = trackable->mutable_position();
+			position->set_x(b.x[i]);
+			position->set_y(b.y[i]);
+			position->set_z(b.z[i]);
+		}
+	}
+	else {
+		for (auto& t : args.trackables) {
 
-		Trackable* trackable = outArgs.frame.add_trackables();
-		if (t.hasId()) trackable->set_id(t.getId());
-		if (t.hasCuid()) trackable->set_cuid(t.getCuid());
-		Trackable::Position* position = trackable->mutable_position();
-		position->set_x(t.getPosition().x);
-		position->set_y(t.getPosition().y);
-		position->set_z(t.getPosition().z);
+			Trackable* trackable = outArgs.frame.add_trackables();
+			if (t.hasId()) trackable->set_id(t.getId());
+			if (t.hasCuid()) trackable->set_cuid(t.getCuid());
+			if (t.hasTruth()) trackable->set_context("{\"g\":" + ofToString(t.getTruth()) + "}");
+			Trackable::Position* position = trackable->mutable_position();
+			position->set_x(t.getPosition().x);
+			position->set_y(t.getPosition().y);
+			position->set_z(t.getPosition().z);
+		}
 	}
 
-	if (RTLS_PLAYER()) {
+	if (RTLS_PLAYER() && source.bPrimary) {
 		// Pass this raw data to the recorder
-		recorder.add(RTLS_SYSTEM_TYPE_NULL, nsys.getFrameRate(), outArgs.frame);
+		recorder.add(RTLS_SYSTEM_TYPE_NULL, source.nsys->getFrameRate(), outArgs.frame);
 		recorder.update(RTLS_SYSTEM_TYPE_NULL);
 	}
-	
-	sendData(outArgs);
 
-	nsysFrameID++;
+	sendData(sender, outArgs);
+
+	source.frameID++;
 }
 
 // --------------------------------------------------------------
-void ofxRTLS::openvrDataReceived(ofxOpenVRTrackerEventArgs& args) {
-	if (isPlaying(RTLS_SYSTEM_TYPE_OPENVR)) return;
+void ofxRTLS::openvrDataReceived(Source& source, ofxOpenVRTrackerEventArgs& args) {
+	if (source.bPrimary && isPlaying(RTLS_SYSTEM_TYPE_OPENVR)) return;
 
 	uint64_t thisMicros = ofGetElapsedTimeMicros();
 
@@ -202,23 +460,20 @@ void ofxRTLS::openvrDataReceived(ofxOpenVRTrackerEventArgs& args) {
 
 	ofxRTLSEventArgs outArgs(latencyCalculated);
 	outArgs.setStartAssemblyTime(thisMicros);
-	outArgs.frame.set_frame_id(openvrFrameID);
-	outArgs.frame.set_timestamp(ofGetElapsedTimeMillis());
+	outArgs.timeMicros = thisMicros;
+	outArgs.frame.set_frame_id(source.frameID);
+	outArgs.frame.set_timestamp(thisMicros / 1000);
 	outArgs.systemType = RTLS_SYSTEM_TYPE_OPENVR;
 	outArgs.trackableType = RTLS_TRACKABLE_TYPE_SAMPLE;
-	{
-		ofJson js;
-		js["s"] = int(outArgs.systemType);
-		js["t"] = int(outArgs.trackableType);
-		outArgs.frame.set_context(js.dump());
-	}
+	outArgs.sourceID = source.id;
+	outArgs.frame.set_context(source.getContext(outArgs.systemType, outArgs.trackableType));
 		
 	for (int i = 0; i < (*args.devices->getTrackers()).size(); i++) {
 
 		Device* tkr = (*args.devices->getTrackers())[i];
 		if (tkr->isActive()) {
 			Trackable* trackable = outArgs.frame.add_trackables();
-			trackable->set_name(tkr->serialNumber);
+			trackable->set_name(source.identities.getString(source.identities.internName(i, tkr->serialNumber)));
 			Trackable::Position* position = trackable->mutable_position();
 			position->set_x(tkr->position.x);
 			position->set_y(tkr->position.y);
@@ -231,20 +486,20 @@ void ofxRTLS::openvrDataReceived(ofxOpenVRTrackerEventArgs& args) {
 		}
 	}
 
-	if (RTLS_PLAYER()) {
+	if (RTLS_PLAYER() && source.bPrimary) {
 		// Pass this raw data to the recorder
 		recorder.add(RTLS_SYSTEM_TYPE_OPENVR, openvr.getFPS(), outArgs.frame);
 		recorder.update(RTLS_SYSTEM_TYPE_OPENVR);
 	}
 	
-	sendData(outArgs);
+	sendData(&source, outArgs);
 
-	openvrFrameID++;
+	source.frameID++;
 }
 
 // --------------------------------------------------------------
-void ofxRTLS::motiveDataReceived(MotiveEventArgs& args) {
-	if (isPlaying(RTLS_SYSTEM_TYPE_MOTIVE)) return;
+void ofxRTLS::motiveDataReceived(Source& source, MotiveEventArgs& args) {
+	if (source.bPrimary && isPlaying(RTLS_SYSTEM_TYPE_MOTIVE)) return;
 
 	uint64_t thisMicros = ofGetElapsedTimeMicros();
 
@@ -258,16 +513,13 @@ void ofxRTLS::motiveDataReceived(MotiveEventArgs& args) {
 	// Send each identified marker
 	ofxRTLSEventArgs mOutArgs(latencyCalculated);
 	mOutArgs.setStartAssemblyTime(thisMicros);
-	mOutArgs.frame.set_frame_id(motiveFrameID);
-	mOutArgs.frame.set_timestamp(ofGetElapsedTimeMillis());
+	mOutArgs.timeMicros = thisMicros;
+	mOutArgs.frame.set_frame_id(source.frameID);
+	mOutArgs.frame.set_timestamp(thisMicros / 1000);
 	mOutArgs.systemType = RTLS_SYSTEM_TYPE_MOTIVE;
 	mOutArgs.trackableType = RTLS_TRACKABLE_TYPE_SAMPLE;
-	{
-		ofJson js;
-		js["s"] = int(mOutArgs.systemType);
-		js["t"] = int(mOutArgs.trackableType);
-		mOutArgs.frame.set_context(js.dump());
-	}
+	mOutArgs.sourceID = source.id;
+	mOutArgs.frame.set_context(source.getContext(mOutArgs.systemType, mOutArgs.trackableType));
 
 	for (int i = 0; i < args.markers.size(); i++) {
 
@@ -275,9 +527,10 @@ void ofxRTLS::motiveDataReceived(MotiveEventArgs& args) {
 		// Instead of setting a char array to the cuid data (which would likely
 		// yield invalid utf-8 strings (that can't be json-dumped), set a string
 		// equal to "[low bits as uint64_t]-[high bits as uint64_t]".
-		string cuid = ofToString(args.markers[i].cuid.LowBits()) + "-" +
-			ofToString(args.markers[i].cuid.HighBits());
-		trackable->set_cuid(cuid);
+		// (Each cuid's string is only formatted once.)
+		ofxRTLSIdentityInterner::Handle cuid = source.identities.internCuid(
+			args.markers[i].cuid.LowBits(), args.markers[i].cuid.HighBits());
+		trackable->set_cuid(source.identities.getString(cuid));
 		// If the marker is active, set an ID. If passive, don't set the ID.
 		if (isMarkerActive(args.markers[i].cuid)) {
 			trackable->set_id(getActiveMarkerID(args.markers[i].cuid));
@@ -288,12 +541,12 @@ void ofxRTLS::motiveDataReceived(MotiveEventArgs& args) {
 		position->set_z(args.markers[i].position.z);
 	}
 
-	if (RTLS_PLAYER()) {
+	if (RTLS_PLAYER() && source.bPrimary) {
 		// Pass this raw data to the recorder
 		recorder.add(RTLS_SYSTEM_TYPE_MOTIVE, motive.getMaxFPS(), mOutArgs.frame);
 	}
 
-	sendData(mOutArgs);
+	sendData(&source, mOutArgs);
 
 
 	// ==============================================
@@ -308,31 +561,28 @@ void ofxRTLS::motiveDataReceived(MotiveEventArgs& args) {
 
 		ofxRTLSEventArgs cOutArgs(latencyCalculated);
 		cOutArgs.setStartAssemblyTime(thisMicros);
-		cOutArgs.frame.set_frame_id(motiveFrameID);
-		cOutArgs.frame.set_timestamp(ofGetElapsedTimeMillis());
+		cOutArgs.timeMicros = thisMicros;
+		cOutArgs.frame.set_frame_id(source.frameID);
+		cOutArgs.frame.set_timestamp(thisMicros / 1000);
 		cOutArgs.systemType = RTLS_SYSTEM_TYPE_MOTIVE;
 		cOutArgs.trackableType = RTLS_TRACKABLE_TYPE_OBSERVER;
-		{
-			ofJson js;
-			js["s"] = int(cOutArgs.systemType);
-			js["t"] = int(cOutArgs.trackableType);
-			// Passing this information isn't sustainable since it cannot be captured by
-			// a recording to a c3d file. If you want to know whether the system needs re-calibration,
-			// check the individual cameras to see if any need it.
-			//js["m"] = int(args.maybeNeedsCalibration); 
-			cOutArgs.frame.set_context(js.dump());
-		}
+		// Passing this information isn't sustainable since it cannot be captured by
+		// a recording to a c3d file. If you want to know whether the system needs re-calibration,
+		// check the individual cameras to see if any need it.
+		//js["m"] = int(args.maybeNeedsCalibration); 
+		cOutArgs.sourceID = source.id;
+		cOutArgs.frame.set_context(source.getContext(cOutArgs.systemType, cOutArgs.trackableType));
 
 		// Add all cameras (after postprocessing)
 		for (int i = 0; i < args.cameras.size(); i++) {
 
-			ofJson js;
-			js["m"] = int(args.cameras[i].maybeNeedsCalibration);
+			// Context of the camera: {"m":<maybe needs calibration>}
+			static const string cameraContexts[2] = { "{\"m\":0}", "{\"m\":1}" };
 
 			Trackable* trackable = cOutArgs.frame.add_trackables();
 			trackable->set_id(args.cameras[i].ID);
-			trackable->set_cuid(ofToString(args.cameras[i].serial));
-			trackable->set_context(js.dump());
+			trackable->set_cuid(source.identities.getString(source.identities.internSerial(args.cameras[i].serial)));
+			trackable->set_context(cameraContexts[args.cameras[i].maybeNeedsCalibration ? 1 : 0]);
 			Trackable::Position* position = trackable->mutable_position();
 			position->set_x(args.cameras[i].position.x);
 			position->set_y(args.cameras[i].position.y);
@@ -344,20 +594,20 @@ void ofxRTLS::motiveDataReceived(MotiveEventArgs& args) {
 			orientation->set_z(args.cameras[i].orientation.z);
 		}
 
-		if (RTLS_PLAYER()) {
+		if (RTLS_PLAYER() && source.bPrimary) {
 			// Pass this raw data to the recorder
 			recorder.add(RTLS_SYSTEM_TYPE_MOTIVE, motive.getMaxFPS(), cOutArgs.frame);
 		}
 
-		sendData(cOutArgs);
+		sendData(&source, cOutArgs);
 	}
 
-	if (RTLS_PLAYER()) {
+	if (RTLS_PLAYER() && source.bPrimary) {
 		// Update the recorder
 		recorder.update(RTLS_SYSTEM_TYPE_MOTIVE);
 	}
 	
-	motiveFrameID++;
+	source.frameID++;
 }
 
 // --------------------------------------------------------------
@@ -365,7 +615,17 @@ void ofxRTLS::playerDataReceived(ofxRTLSPlayerDataArgs& args) {
 
 	uint64_t thisMicros = ofGetElapsedTimeMicros();
 
-	markDataReceived();
+	// Playback replaces the data of the primary source of its system
+	Source* source = getPrimarySource(args.systemType);
+
+	// Replayed frames only bring the postprocessors up to date, so they
+	// are not needed if there are no postprocessors.
+	if (args.playback.bReplay) {
+		if (source == NULL || !source->bPostprocessed) return;
+	}
+	else {
+		markDataReceived();
+	}
 
 	// ==============================================
 	// Playback Data
@@ -374,98 +634,37 @@ void ofxRTLS::playerDataReceived(ofxRTLSPlayerDataArgs& args) {
 
 	ofxRTLSEventArgs outArgs(latencyCalculated);
 	outArgs.setStartAssemblyTime(thisMicros);
-	outArgs.frame.set_timestamp(ofGetElapsedTimeMillis());
+	outArgs.timeMicros = thisMicros;
+	outArgs.frame.set_timestamp(thisMicros / 1000);
 	outArgs.frame = args.frame;
 	outArgs.systemType = args.systemType;
 	outArgs.trackableType = args.trackableType;
-	// Context has already been set
+	outArgs.playback = args.playback;
+	// Context has already been set. The frame is sent by the primary source.
+	if (source != NULL) outArgs.sourceID = source->id;
 
 	// (Don't record played data)
 
 	// Send the data out appropriately
-	sendData(outArgs);
+	sendData(source, outArgs);
 }
 
 // --------------------------------------------------------------
-bool ofxRTLS::sendData(ofxRTLSEventArgs& args) {
+bool ofxRTLS::sendData(Source* source, ofxRTLSEventArgs& args) {
 	
-	switch (args.systemType) {
-
-	// ========================================================================
-	case RTLS_SYSTEM_TYPE_NULL: {
-		if (RTLS_NULL()) {
-			switch (args.trackableType) {
-			case RTLS_TRACKABLE_TYPE_SAMPLE: {
-				if (RTLS_POSTPROCESS())
-					// Post-process the data, then send it out when ready
-					nsysPostM.processAndSend(args, newFrameReceived);
-				else
-					// Send out data immediately
-					ofNotifyEvent(newFrameReceived, args);
-			}; break;
-			default: {
-				return false; // Invalid trackable type
-			}; break;
-			}
-		}
-		else {
-			return false; // Not compiled for Null System
-		}
-	}; break;
-
-	// ========================================================================
-	case RTLS_SYSTEM_TYPE_OPENVR: {
-		if (RTLS_OPENVR()) {
-			switch (args.trackableType) {
-			case RTLS_TRACKABLE_TYPE_SAMPLE: {
-				if (RTLS_POSTPROCESS())
-					openvrPostM.processAndSend(args, newFrameReceived);
-				else 
-					ofNotifyEvent(newFrameReceived, args);
-			}; break;
-			default: {
-				return false; // Invalid trackable type
-			}; break;
-			}
-		}
-		else {
-			return false; // Not compiled for OpenVR
-		}
-	}; break;
-
-	// ========================================================================
-	case RTLS_SYSTEM_TYPE_MOTIVE: {
-		if (RTLS_MOTIVE()) {
-			switch (args.trackableType) {
-			case RTLS_TRACKABLE_TYPE_OBSERVER: { // Motive Cameras
-				if (RTLS_POSTPROCESS())
-					motivePostR.processAndSend(args, newFrameReceived);
-				else
-					ofNotifyEvent(newFrameReceived, args);
-			}; break;
-			case RTLS_TRACKABLE_TYPE_SAMPLE: { // Motive markers
-				if (RTLS_POSTPROCESS())
-					motivePostM.processAndSend(args, newFrameReceived);
-				else
-					ofNotifyEvent(newFrameReceived, args);
-			}; break;
-			default: {
-				return false; // Invalid trackable type
-			}; break;
-			}
-		}
-		else {
-			return false; // Not compiled for Motive
-		}
-	}; break;
+	if (source == NULL || !source->bActive) return false; // Source is not enabled
+	if (!isValidTrackableType(source->systemType, args.trackableType)) return false; // Invalid trackable type
 
-	// ========================================================================
-	case RTLS_SYSTEM_TYPE_INVALID:
-	default: {
-		return false; // Invalid system type
-	}; break;
+	if (source->bPostprocessed) {
+		// Post-process the data, then send it out when ready
+		ofxRTLSPostprocessor* pp = source->getPostprocessor(args.trackableType);
+		if (pp == NULL) return false;
+		pp->processAndSend(args, newFrameReceived);
+	}
+	else {
+		// Send out data immediately
+		ofNotifyEvent(newFrameReceived, args);
 	}
-
 	return true;
 }
 
@@ -495,45 +694,35 @@ void ofxRTLS::threadedFunction() {
 // --------------------------------------------------------------
 void ofxRTLS::exit() {
 
-	if (RTLS_NULL()) {
-		if (RTLS_POSTPROCESS()) {
-			nsysPostM.exit();
-		}
-		ofRemoveListener(nsys.newDataReceived, this, &ofxRTLS::nsysDataReceived);
-		nsys.stop();
+	std::lock_guard<std::mutex> lk(reconfigureMutex);
+
+	// Stop receiving data and send the frames still being postprocessed
+	bool bOpenVRSetup = false;
+	for (auto& source : sources) {
+		detachSource(*source);
+		for (auto& p : source->postprocessors) p.pp->exit();
+		if (source->nsys) source->nsys->stop();
+		bOpenVRSetup |= source->systemType == RTLS_SYSTEM_TYPE_OPENVR && source->bSetup;
 	}
-	if (RTLS_OPENVR()) {
-		if (RTLS_POSTPROCESS()) {
-			openvrPostM.exit();
-		}
-		// Remove listener for new device data
-		ofRemoveListener(openvr.newDataReceived, this, &ofxRTLS::openvrDataReceived);
+	synchronizer.stop();
+	if (bOpenVRSetup) {
 		openvr.exit();
 	}
-	if (RTLS_MOTIVE()) {
-		if (RTLS_POSTPROCESS()) {
-			motivePostM.exit();
-			motivePostR.exit();
-		}
-		ofRemoveListener(motive.newDataReceived, this, &ofxRTLS::motiveDataReceived);
-	}
 }
 
 // --------------------------------------------------------------
 int ofxRTLS::isConnected() {
 
 	int nConnections = 0;
-
-	if (RTLS_NULL()) {
-		nConnections += int(nsys.isConnected());
-	}
-	if (RTLS_OPENVR()) {
-		nConnections += int(openvr.isConnected());
-	}
-	if (RTLS_MOTIVE()) {
-		nConnections += int(motive.isConnected());
+	for (auto& source : sources) {
+		if (!source->bActive) continue;
+		switch (source->systemType) {
+		case RTLS_SYSTEM_TYPE_NULL: nConnections += int(source->nsys->isConnected()); break;
+		case RTLS_SYSTEM_TYPE_OPENVR: nConnections += int(openvr.isConnected()); break;
+		case RTLS_SYSTEM_TYPE_MOTIVE: nConnections += int(motive.isConnected()); break;
+		default: break;
+		}
 	}
-
 	return nConnections;
 }
 
@@ -593,12 +782,15 @@ string ofxRTLS::getSupport() {
 float ofxRTLS::getMaxSystemFPS() {
 
 	float maxFPS = 0;
-	if (RTLS_NULL())
-		maxFPS = max(maxFPS, nsys.getFrameRate());
-	if (RTLS_OPENVR())
-		maxFPS = max(maxFPS, openvr.getFPS());
-	if (RTLS_MOTIVE())
-		maxFPS = max(maxFPS, float(motive.getMaxFPS()));
+	for (auto& source : sources) {
+		if (!source->bActive) continue;
+		switch (source->systemType) {
+		case RTLS_SYSTEM_TYPE_NULL: maxFPS = max(maxFPS, source->nsys->getFrameRate()); break;
+		case RTLS_SYSTEM_TYPE_OPENVR: maxFPS = max(maxFPS, openvr.getFPS()); break;
+		case RTLS_SYSTEM_TYPE_MOTIVE: maxFPS = max(maxFPS, float(motive.getMaxFPS())); break;
+		default: break;
+		}
+	}
 	return maxFPS;
 }
 
@@ -609,6 +801,33 @@ void ofxRTLS::newLatencyCalculated(ofxRTLSLatencyArgs& args) {
 	latencyMS = latencyMS * 0.95 + latency * 0.05;
 }
 
+// --------------------------------------------------------------
+void ofxRTLS::postprocessorDegradationChanged(ofxRTLSDegradationArgs& args) {
+
+	ofNotifyEvent(degradationChanged, args);
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::synchronizerFrameReceived(ofxRTLSSyncArgs& args) {
+
+	ofNotifyEvent(newFrameSynchronized, args);
+}
+
+// --------------------------------------------------------------
+ofEvent<ofxRTLSEventArgs>& ofxRTLS::getOutputEvent(string output) {
+
+	std::lock_guard<std::mutex> lk(outputEventsMutex);
+	auto& event = outputEvents[output];
+	if (!event) event.reset(new ofEvent<ofxRTLSEventArgs>());
+	return *event;
+}
+
+// --------------------------------------------------------------
+void ofxRTLS::postprocessorOutputReceived(ofxRTLSEventArgs& args) {
+
+	ofNotifyEvent(getOutputEvent(args.output), args);
+}
+
 // --------------------------------------------------------------
 bool ofxRTLS::isRecording() {
 	if (RTLS_PLAYER())
@@ -657,6 +876,71 @@ string ofxRTLS::getPlayingFile() {
 		return "";
 }
 
+// --------------------------------------------------------------
+map<string, double> ofxRTLS::getDiagnostics() {
+
+	map<string, double> out;
+
+	auto addPostprocessor = [&out](ofxRTLSPostprocessor& pp, string prefix) {
+		auto d = pp.getDiagnostics();
+		out[prefix + ".framesProcessed"] = d.nFramesProcessed;
+		out[prefix + ".queued"] = d.nQueued;
+		out[prefix + ".keyMappings"] = d.nKeyMappings;
+		out[prefix + ".lostTracks"] = d.nLostTracks;
+		out[prefix + ".filters"] = d.nFilters;
+		out[prefix + ".lastFrameTrackables"] = d.nLastFrameTrackables;
+		out[prefix + ".cuidCounter"] = d.cuidCounter;
+		out[prefix + ".degradationLevel"] = d.degradationLevel;
+		out[prefix + ".projectedMicros"] = d.projectedMicros;
+		out[prefix + ".degradedFrames"] = d.nDegradedFrames;
+		out[prefix + ".coalescedFrames"] = d.nCoalescedFrames;
+	};
+	for (auto& source : sources) {
+		for (auto& p : source->postprocessors) addPostprocessor(*p.pp, p.name);
+	}
+
+	if (RTLS_PLAYER()) {
+		auto d = recorder.getDiagnostics();
+		out["recorder.queuedTakes"] = d.nQueuedTakes;
+		out["recorder.recordingFrames"] = d.nRecordingFrames;
+		out["recorder.recordingLabels"] = d.nRecordingLabels;
+		out["player.keyframes"] = player.getNumKeyframes();
+	}
+
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		out["rtls.dataTimestamps"] = dataTimestamps.size();
+	}
+
+	return out;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLS::getSourceClock(string sourceID, double& offsetMicros, double& driftPPM) {
+
+	Source* source = getSource(sourceID);
+	if (source == NULL || source->clock.getNumSamples() == 0) return false;
+	offsetMicros = source->clock.getOffsetMicros();
+	driftPPM = source->clock.getDriftPPM();
+	return true;
+}
+
+// --------------------------------------------------------------
+map<string, ofxRTLSPostprocessStage::Stats> ofxRTLS::getStageStats() {
+
+	map<string, ofxRTLSPostprocessStage::Stats> out;
+
+	auto addPostprocessor = [&out](ofxRTLSPostprocessor& pp, string prefix) {
+		for (auto& stats : pp.getDiagnostics().stages) {
+			out[prefix + "." + stats.name] = stats;
+		}
+	};
+	for (auto& source : sources) {
+		for (auto& p : source->postprocessors) addPostprocessor(*p.pp, p.name);
+	}
+	return out;
+}
+
 // --------------------------------------------------------------
 void ofxRTLS::markDataReceived() {
 
@@ -698,6 +982,12 @@ void ofxRTLS::resetPlayback() {
 		player.reset();
 }
 
+// --------------------------------------------------------------
+void ofxRTLS::seekPlayback(float timeSec) {
+	if (RTLS_PLAYER())
+		player.seek(timeSec);
+}
+
 // --------------------------------------------------------------
 void ofxRTLS::promptOpenPlaybackFile() {
 	if (RTLS_PLAYER())
@@ -13,6 +13,9 @@ using namespace RTLSProtocol;
 #include "ofxMotive.h"
 
 #include "ofxRTLSPostprocessor.h"
+#include "ofxRTLSIdentityInterner.h"
+#include "ofxRTLSClockSync.h"
+#include "ofxRTLSSynchronizer.h"
 
 #include "ofxRTLSRecorder.h"
 #include "ofxRTLSPlayer.h"
@@ -37,6 +40,15 @@ public:
 
 	void exit();
 
+	// Reload the configuration file and apply it without restarting. Systems
+	// that are no longer listed stop sending data and their postprocessors
+	// send the frames they hold. Systems that are newly listed are setup (the 
+	// first time they are listed) and started (if this object has been 
+	// started). Systems that are still listed keep running undisturbed, 
+	// unless postprocessing has been enabled or disabled.
+	// (Call this from the same thread as start() and stop().)
+	bool reloadConfig(string configPath = "");
+
 	int isConnected();
 	bool isReceivingData();
 	float getFPS() { return dataFPS; }
@@ -49,6 +61,22 @@ public:
 	// Event that occurs when new latency is calculated
 	ofEvent< ofxRTLSLatencyArgs > latencyCalculated;
 
+	// Event that occurs when a postprocessor changes how much it degrades
+	// processing to meet its frame budget
+	ofEvent< ofxRTLSDegradationArgs > degradationChanged;
+
+	// Event that occurs when frames of all sources have been merged at a
+	// common time, if a synchronizer is configured under "sync" in the rtls
+	// config (see ofxRTLSSynchronizer)
+	ofEvent< ofxRTLSSyncArgs > newFrameSynchronized;
+
+	// Event that occurs when a postprocessing output (declared in a 
+	// pipeline of the rtls config) has new data. Outputs of every source
+	// and trackable type with this name are sent on the same event, from
+	// the thread of the postprocessor that produced them (its processing
+	// thread, or its last segment's thread when pipelined).
+	ofEvent< ofxRTLSEventArgs >& getOutputEvent(string output);
+
 	// What systems does this version of RTLS support?
 	string getSupport();
 	string getSupportedSystems();
@@ -64,29 +92,97 @@ public:
 	bool isPlaying(RTLSSystemType systemType);
 	void togglePlayback();
 	void resetPlayback();
+	void seekPlayback(float timeSec);
 	void promptOpenPlaybackFile();
 	float getPlayingPercentComplete();
 	float getPlayingFileDuration();
 	string getRecordingFile();
 	string getPlayingFile();
 
+	// Get the sizes of internal structures (maps, queues and takes) by name,
+	// for monitoring growth over long runs.
+	map<string, double> getDiagnostics();
+
+	// Get the timing and counters of each postprocessing stage, by the name
+	// of its postprocessor and stage (e.g. "motivePostM.hungarian").
+	map<string, ofxRTLSPostprocessStage::Stats> getStageStats();
+
+	// Get the estimated offset (us) and drift (ppm) of a source's clock from
+	// the server's clock (see ofxRTLSClockSync). Returns false if the source
+	// doesn't report when it captures its frames.
+	bool getSourceClock(string sourceID, double& offsetMicros, double& driftPPM);
+
 private:
 
-	ofxRTLSNullSystem nsys;
-	void nsysDataReceived(NullSystemEventArgs& args);
-	uint64_t nsysFrameID = 0;
-	ofxRTLSPostprocessor nsysPostM;
+	// A source of data: an instance of a tracking system (as listed in the
+	// configuration), with its own postprocessors. Its ID is included in the 
+	// context of its frames (as "i"). Any number of Null System sources can 
+	// run at once. OpenVR and Motive connect to a single runtime per process,
+	// so they each have at most one source.
+	class Source {
+	public:
+		ofxRTLS* rtls = NULL;
+		string id = "";
+		RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+		// Is this source named after its system (e.g. "null")? These use the
+		// original parameter and diagnostics names.
+		bool isDefault() { return id == ofToLower(getRTLSSystemTypeDescription(systemType)); }
+
+		// Generator of a Null System source
+		unique_ptr<ofxRTLSNullSystem> nsys;
+		uint64_t frameID = 0; // increment for every packet sent
+		// Identities reported by this source (only used on its data's thread)
+		ofxRTLSIdentityInterner identities;
+		// Context string of this source's frames of each system and 
+		// trackable type, built the first time it is needed (only used on
+		// its data's thread)
+		const string& getContext(RTLSSystemType systemType, RTLSTrackableType trackableType);
+		string contexts[NUM_RTLS_SYSTEM_TYPES][NUM_RTLS_TRACKABLE_TYPES];
+		// Mapping of the times at which this source captured its frames
+		// to the server's clock (if the source reports them)
+		ofxRTLSClockSync clock;
+
+		// Postprocessors by trackable type, with their diagnostics names
+		struct Postprocessor {
+			RTLSTrackableType trackableType;
+			string name;
+			unique_ptr<ofxRTLSPostprocessor> pp;
+		};
+		vector<Postprocessor> postprocessors;
+		ofxRTLSPostprocessor* getPostprocessor(RTLSTrackableType trackableType);
+
+		// Sources (and their postprocessors) are setup the first time they 
+		// are configured and kept once they are removed, so they can be 
+		// added again later.
+		bool bSetup = false;
+		bool bPostprocessorsSetup = false;
+		// Is this source's data sent, and is it postprocessed?
+		atomic<bool> bActive = false;
+		atomic<bool> bPostprocessed = false;
+		// The first source of each system is recorded, and is replaced by
+		// playback of its system.
+		atomic<bool> bPrimary = false;
+
+		// Pass this source's data to the tracker
+		void nsysDataReceived(NullSystemEventArgs& args) { rtls->nsysDataReceived(*this, args); }
+		void openvrDataReceived(ofxOpenVRTrackerEventArgs& args) { rtls->openvrDataReceived(*this, args); }
+		void motiveDataReceived(MotiveEventArgs& args) { rtls->motiveDataReceived(*this, args); }
+	};
+	vector< unique_ptr<Source> > sources;
+	Source* getSource(string id);
+	// Primary source of each system
+	atomic<Source*> primarySources[NUM_RTLS_SYSTEM_TYPES];
+	Source* getPrimarySource(RTLSSystemType systemType);
+	// Which trackable types does a system send?
+	static bool isValidTrackableType(RTLSSystemType systemType, RTLSTrackableType trackableType);
+
+	void nsysDataReceived(Source& source, NullSystemEventArgs& args);
 
 	ofxOpenVRTracker openvr;
-	void openvrDataReceived(ofxOpenVRTrackerEventArgs& args);
-	uint64_t openvrFrameID = 0; 
-	ofxRTLSPostprocessor openvrPostM; // marker postprocessor
+	void openvrDataReceived(Source& source, ofxOpenVRTrackerEventArgs& args);
 
 	ofxMotive motive;
-	void motiveDataReceived(MotiveEventArgs& args);
-	uint64_t motiveFrameID = 0; // increment for every packet sent
-	ofxRTLSPostprocessor motivePostM;	// marker postprocessor
-	ofxRTLSPostprocessor motivePostR;	// reference (camera) postprocessor
+	void motiveDataReceived(Source& source, MotiveEventArgs& args);
 	bool bSendCameraData = true;
 	float cameraDataFrequency = 10.0; // what is the sending period in seconds?
 	uint64_t lastSendTime = 0;
@@ -97,6 +193,24 @@ private:
 	void playerDataReceived(ofxRTLSPlayerDataArgs& args);
 	// frame ID?
 
+	// Create, remove and add sources to match the configuration
+	void applyConfig();
+	// Begin sending a source's data, setting it up if necessary
+	void attachSource(Source& source);
+	// Stop receiving a source's data and drain its postprocessors
+	void detachSource(Source& source);
+	void setupSource(Source& source);
+	void setupSourcePostprocessors(Source& source);
+	void startSource(Source& source);
+	void stopSource(Source& source);
+	// Has start() been called (without stop())?
+	bool bStarted = false;
+	// Merges the frames of all sources (if configured)
+	ofxRTLSSynchronizer synchronizer;
+	bool bSynchronize = false;
+	void synchronizerFrameReceived(ofxRTLSSyncArgs& args);
+	std::mutex reconfigureMutex;
+
 	void threadedFunction();
 
 	// last time a packet of data was received
@@ -105,9 +219,9 @@ private:
 	int stopGap = 100; // number of milliseconds before we decide no data is being received
 	// Mark that we received a new frame
 	void markDataReceived();
-	// Send event args given a system and type.
-	// If the provided system is not compiled, will return false.
-	bool sendData(ofxRTLSEventArgs& args);
+	// Send event args from a source, given their type.
+	// If the source is not active or the type is invalid, will return false.
+	bool sendData(Source* source, ofxRTLSEventArgs& args);
 
 	// Contains timestamps at which data was received in the last second
 	queue<uint64_t> dataTimestamps;
@@ -115,4 +229,11 @@ private:
 
 	atomic<double> latencyMS = 0.0;
 	void newLatencyCalculated(ofxRTLSLatencyArgs& args);
+
+	void postprocessorDegradationChanged(ofxRTLSDegradationArgs& args);
+
+	// Events of the postprocessing outputs, by name
+	map<string, unique_ptr< ofEvent<ofxRTLSEventArgs> > > outputEvents;
+	std::mutex outputEventsMutex;
+	void postprocessorOutputReceived(ofxRTLSEventArgs& args);
 };
\ No newline at end of file
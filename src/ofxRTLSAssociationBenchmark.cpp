@@ -0,0 +1,200 @@
+#include "ofxRTLSAssociationBenchmark.h"
+#include "ofxRTLSTrackableKey.h"
+
+// --------------------------------------------------------------
+ofxRTLSAssociationBenchmark::ofxRTLSAssociationBenchmark() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSAssociationBenchmark::~ofxRTLSAssociationBenchmark() {
+
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSAssociationBenchmark::setup(string scenarioPath, string settingsPath) {
+
+	ofFile file(ofToDataPath(settingsPath));
+	if (!file.exists()) {
+		ofLogError("ofxRTLSAssociationBenchmark") << "Settings file does not exist: \"" << settingsPath << "\"";
+		return false;
+	}
+	ofJson js;
+	try {
+		file >> js;
+	}
+	catch (const std::exception&) {
+		ofLogError("ofxRTLSAssociationBenchmark") << "Could not parse settings file \"" << settingsPath << "\"";
+		return false;
+	}
+	settings = js;
+	return scenario.setup(scenarioPath);
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSAssociationBenchmark::setup(const ofJson& _scenario, const ofJson& _settings) {
+
+	settings = _settings;
+	return scenario.setup(_scenario);
+}
+
+// --------------------------------------------------------------
+ofxRTLSAssociationBenchmark::Results ofxRTLSAssociationBenchmark::run(uint64_t maxFrames) {
+
+	Results r;
+	if (!scenario.isSetup()) {
+		ofLogError("ofxRTLSAssociationBenchmark") << "Cannot run a benchmark without a scenario";
+		return r;
+	}
+	scenario.reset();
+
+	ofxRTLSPostprocessor postprocessor;
+	postprocessor.setupHeadless(RTLS_SYSTEM_TYPE_NULL, RTLS_TRACKABLE_TYPE_SAMPLE,
+		"Benchmark", "BM", settings);
+
+	// Last key output for each true trackable, and all keys it was given
+	map<int, string> lastKeyOfTruth;
+	map<int, set<string> > keysOfTruth;
+	// Last true trackable output with each key
+	map<string, int> lastTruthOfKey;
+	uint64_t nTrueInputs = 0;
+	uint64_t nTrueOutputs = 0;
+	uint64_t nGhostInputs = 0;
+	uint64_t nGhostOutputs = 0;
+
+	vector<uint64_t> processTimes;
+	uint64_t hungarianTime = 0;
+	uint64_t filtersTime = 0;
+
+	uint64_t startTime = ofGetElapsedTimeMicros();
+	uint64_t frameIndex = 0;
+	NullSystemEventArgs args;
+	TrackableFrame frame;
+	while (maxFrames == 0 || frameIndex < maxFrames) {
+
+		args.trackables.clear();
+		if (!scenario.getNextFrame(args)) break;
+		toFrame(args, frameIndex, frame);
+		r.nInputTrackables += frame.trackables_size();
+		for (auto& t : args.trackables) {
+			if (t.getTruth() > 0) nTrueInputs++;
+			else nGhostInputs++;
+		}
+
+		postprocessor.process(frame);
+
+		auto times = postprocessor.getLastStageTimes();
+		processTimes.push_back(times.total);
+		hungarianTime += times.hungarian;
+		filtersTime += times.filters;
+
+		// Score the output
+		r.nOutputTrackables += frame.trackables_size();
+		for (int i = 0; i < frame.trackables_size(); i++) {
+			int truth = getTruth(frame.trackables(i));
+			if (truth == 0) continue;
+			if (truth < 0) {
+				nGhostOutputs++;
+				continue;
+			}
+			nTrueOutputs++;
+			string key = getTrackableKey(frame.trackables(i));
+
+			auto it = lastKeyOfTruth.find(truth);
+			if (it != lastKeyOfTruth.end() && it->second != key) r.idSwitches++;
+			lastKeyOfTruth[truth] = key;
+			keysOfTruth[truth].insert(key);
+
+			auto jt = lastTruthOfKey.find(key);
+			if (jt != lastTruthOfKey.end() && jt->second != truth) r.idSwaps++;
+			lastTruthOfKey[key] = truth;
+		}
+
+		frameIndex++;
+	}
+	r.elapsedSec = double(ofGetElapsedTimeMicros() - startTime) / 1000000.0;
+	r.nFrames = frameIndex;
+
+	// Throughput
+	if (r.elapsedSec > 0) {
+		r.framesPerSec = double(r.nFrames) / r.elapsedSec;
+		r.trackablesPerSec = double(r.nInputTrackables) / r.elapsedSec;
+	}
+	if (!processTimes.empty()) {
+		uint64_t sum = 0;
+		for (auto t : processTimes) sum += t;
+		r.processMeanUS = double(sum) / double(processTimes.size());
+		r.hungarianMeanUS = double(hungarianTime) / double(processTimes.size());
+		r.filtersMeanUS = double(filtersTime) / double(processTimes.size());
+		sort(processTimes.begin(), processTimes.end());
+		r.processP50US = double(processTimes[(processTimes.size() - 1) / 2]);
+		r.processP99US = double(processTimes[(processTimes.size() - 1) * 99 / 100]);
+	}
+
+	// Association
+	uint64_t nKeys = 0;
+	for (auto& it : keysOfTruth) {
+		nKeys += it.second.size();
+		r.fragmentations += it.second.size() - 1;
+	}
+	if (!keysOfTruth.empty()) r.keysPerTruth = double(nKeys) / double(keysOfTruth.size());
+	if (nTrueOutputs > 0) r.idSwitchRate = 1000.0 * double(r.idSwitches) / double(nTrueOutputs);
+	if (nGhostInputs > 0) r.ghostRate = double(nGhostOutputs) / double(nGhostInputs);
+	if (nTrueInputs > 0) r.coverage = double(nTrueOutputs) / double(nTrueInputs);
+
+	return r;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSAssociationBenchmark::toFrame(NullSystemEventArgs& args, uint64_t frameIndex, TrackableFrame& frame) {
+
+	frame.Clear();
+	frame.set_timestamp(uint64_t(double(frameIndex) * 1000.0 / double(scenario.getFPS())));
+	for (auto& t : args.trackables) {
+
+		Trackable* trackable = frame.add_trackables();
+		if (t.hasId()) trackable->set_id(t.getId());
+		if (t.hasCuid()) trackable->set_cuid(t.getCuid());
+		if (t.hasTruth()) trackable->set_context("{\"g\":" + ofToString(t.getTruth()) + "}");
+		Trackable::Position* position = trackable->mutable_position();
+		position->set_x(t.getPosition().x);
+		position->set_y(t.getPosition().y);
+		position->set_z(t.getPosition().z);
+	}
+}
+
+// --------------------------------------------------------------
+int ofxRTLSAssociationBenchmark::getTruth(const Trackable& t) {
+
+	// Context is {"g":<truth>}
+	const string& context = t.context();
+	if (context.size() < 6 || context.compare(0, 5, "{\"g\":") != 0) return 0;
+	return ofToInt(context.substr(5, context.size() - 6));
+}
+
+// --------------------------------------------------------------
+ofJson ofxRTLSAssociationBenchmark::Results::toJson() {
+
+	ofJson js;
+	js["nFrames"] = nFrames;
+	js["nInputTrackables"] = nInputTrackables;
+	js["nOutputTrackables"] = nOutputTrackables;
+	js["throughput"]["elapsedSec"] = elapsedSec;
+	js["throughput"]["framesPerSec"] = framesPerSec;
+	js["throughput"]["trackablesPerSec"] = trackablesPerSec;
+	js["throughput"]["processMeanUS"] = processMeanUS;
+	js["throughput"]["processP50US"] = processP50US;
+	js["throughput"]["processP99US"] = processP99US;
+	js["throughput"]["hungarianMeanUS"] = hungarianMeanUS;
+	js["throughput"]["filtersMeanUS"] = filtersMeanUS;
+	js["association"]["idSwitches"] = idSwitches;
+	js["association"]["idSwaps"] = idSwaps;
+	js["association"]["fragmentations"] = fragmentations;
+	js["association"]["keysPerTruth"] = keysPerTruth;
+	js["association"]["idSwitchRate"] = idSwitchRate;
+	js["association"]["ghostRate"] = ghostRate;
+	js["association"]["coverage"] = coverage;
+	return js;
+}
+
+// --------------------------------------------------------------
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSNullScenario.h"
+#include "ofxRTLSPostprocessor.h"
+#include "Trackable.pb.h"
+using namespace RTLSProtocol;
+
+// Runs a null system scenario through a headless postprocessor as fast as
+// possible, reporting both how quickly frames were processed and how well
+// output keys follow the scenario's ground truth. Use this to check that
+// changes to association (the Hungarian stage) or filtering remain correct.
+//
+// Ground truth is carried through the postprocessor in each trackable's 
+// context as {"g":<truth>}. Trackables added by filters while coasting
+// have no truth and are not scored.
+class ofxRTLSAssociationBenchmark {
+public:
+
+	ofxRTLSAssociationBenchmark();
+	~ofxRTLSAssociationBenchmark();
+
+	// Setup with a scenario (see ofxRTLSNullScenario) and postprocessor 
+	// settings (see ofxRTLSPostprocessor::applySettings).
+	bool setup(string scenarioPath, string settingsPath);
+	bool setup(const ofJson& scenario, const ofJson& settings);
+
+	struct Results {
+		uint64_t nFrames = 0;
+		uint64_t nInputTrackables = 0;
+		uint64_t nOutputTrackables = 0;
+
+		// Throughput
+		double elapsedSec = 0;
+		double framesPerSec = 0;
+		double trackablesPerSec = 0;
+		// Processing time per frame (microseconds)
+		double processMeanUS = 0;
+		double processP50US = 0;
+		double processP99US = 0;
+		double hungarianMeanUS = 0;
+		double filtersMeanUS = 0;
+
+		// Association
+		// Number of times a true trackable's output key changed
+		uint64_t idSwitches = 0;
+		// Number of times an output key moved to a different true trackable
+		uint64_t idSwaps = 0;
+		// Number of extra keys given to true trackables (a trackable followed
+		// by a single key has no fragmentations)
+		uint64_t fragmentations = 0;
+		// Mean number of keys given to each true trackable
+		double keysPerTruth = 0;
+		// ID switches per thousand scored outputs
+		double idSwitchRate = 0;
+		// Fraction of ghost inputs that were output
+		double ghostRate = 0;
+		// Fraction of true inputs that were output
+		double coverage = 0;
+
+		ofJson toJson();
+	};
+
+	// Run the scenario from the beginning, processing up to maxFrames frames
+	// (0 processes the whole scenario).
+	Results run(uint64_t maxFrames = 0);
+
+private:
+
+	ofxRTLSNullScenario scenario;
+	ofJson settings;
+
+	// Convert scenario output to a trackable frame, storing ground truth
+	// in each trackable's context
+	void toFrame(NullSystemEventArgs& args, uint64_t frameIndex, TrackableFrame& frame);
+	// Get the ground truth of a trackable (0 if none)
+	int getTruth(const Trackable& t);
+};
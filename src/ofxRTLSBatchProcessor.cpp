@@ -0,0 +1,153 @@
+#include "ofxRTLSBatchProcessor.h"
+
+// --------------------------------------------------------------
+ofxRTLSBatchProcessor::ofxRTLSBatchProcessor() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSBatchProcessor::~ofxRTLSBatchProcessor() {
+
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSBatchProcessor::setup(string settingsPath) {
+
+	ofFile file(ofToDataPath(settingsPath));
+	if (!file.exists()) {
+		ofLogError("ofxRTLSBatchProcessor") << "Settings file does not exist: \"" << settingsPath << "\"";
+		return false;
+	}
+	ofJson js;
+	try {
+		file >> js;
+	}
+	catch (const std::exception&) {
+		ofLogError("ofxRTLSBatchProcessor") << "Could not parse settings file \"" << settingsPath << "\"";
+		return false;
+	}
+	setup(js);
+	return true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBatchProcessor::setup(const ofJson& _settings) {
+
+	settings = _settings;
+	if (settings.find("suffix") != settings.end()) {
+		suffix = settings["suffix"].get<string>();
+	}
+}
+
+// --------------------------------------------------------------
+int ofxRTLSBatchProcessor::process(const vector<string>& takePaths, string outputFolder, int nThreads) {
+
+	if (takePaths.empty()) return 0;
+
+	// Each thread takes the next unprocessed take until none remain.
+	if (nThreads <= 0) nThreads = MAX(int(std::thread::hardware_concurrency()), 1);
+	nThreads = MIN(nThreads, int(takePaths.size()));
+
+	atomic<int> nextTake(0);
+	atomic<int> nSucceeded(0);
+	vector<std::thread> workers;
+	for (int i = 0; i < nThreads; i++) {
+		workers.push_back(std::thread([&] {
+			while (true) {
+				int index = nextTake++;
+				if (index >= int(takePaths.size())) break;
+
+				string inPath = takePaths[index];
+				string outPath = getOutputPath(inPath, outputFolder);
+				bool bSuccess = false;
+				try {
+					bSuccess = processTake(inPath, outPath);
+				}
+				catch (const std::exception&) {
+					bSuccess = false;
+				}
+				if (bSuccess) {
+					nSucceeded++;
+					ofLogNotice("ofxRTLSBatchProcessor") << "Processed take \"" << inPath << "\" to \"" << outPath << "\"";
+				}
+				else {
+					ofLogError("ofxRTLSBatchProcessor") << "Could not process take \"" << inPath << "\"";
+				}
+			}
+		}));
+	}
+	for (auto& w : workers) w.join();
+
+	return nSucceeded;
+}
+
+// --------------------------------------------------------------
+string ofxRTLSBatchProcessor::getOutputPath(string takePath, string outputFolder) {
+
+	string fileName = ofFilePath::getBaseName(takePath) + suffix + ".c3d";
+	if (outputFolder.empty()) {
+		return ofFilePath::join(ofFilePath::getEnclosingDirectory(takePath, false), fileName);
+	}
+	return ofFilePath::join(ofFilePath::getAbsolutePath(outputFolder), fileName);
+}
+
+// --------------------------------------------------------------
+ofJson ofxRTLSBatchProcessor::getSettings(RTLSSystemType systemType, RTLSTrackableType trackableType) {
+
+	if (settings.find("postprocess") == settings.end()) return ofJson();
+	const ofJson& pp = settings["postprocess"];
+
+	string s = ofToLower(getRTLSSystemTypeDescription(systemType));
+	string t = ofToLower(getRTLSTrackableTypeDescription(trackableType));
+	if (pp.find(s) != pp.end() && pp[s].find(t) != pp[s].end()) return pp[s][t];
+	if (pp.find("default") != pp.end()) return pp["default"];
+	return ofJson();
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSBatchProcessor::processTake(string inPath, string outPath) {
+
+	// Load the take
+	RTLSPlayerTake take;
+	take.path = inPath;
+	if (!take.load()) return false;
+	if (take.getC3dNumFrames() == 0) {
+		ofLogNotice("ofxRTLSBatchProcessor") << "No data in take \"" << inPath << "\"";
+		return false;
+	}
+	float fps = take.getC3dFps();
+
+	// Create a postprocessor for every system and trackable type in this take
+	vector< unique_ptr<ofxRTLSPostprocessor> > postprocessors;
+	set<int> systems;
+	for (int i = 0; i < take.frames.size(); i++) {
+		auto& f = take.frames[i];
+		postprocessors.push_back(unique_ptr<ofxRTLSPostprocessor>(new ofxRTLSPostprocessor()));
+		postprocessors.back()->setupHeadless(f.systemType, f.trackableType,
+			ofFilePath::getBaseName(inPath) + "-" + ofToString(i), "B" + ofToString(i),
+			getSettings(f.systemType, f.trackableType));
+		systems.insert(int(f.systemType));
+	}
+
+	// Process every frame, in order
+	RTLSTake out;
+	out.path = outPath;
+	for (uint64_t frameIndex = 0; frameIndex < take.getC3dNumFrames(); frameIndex++) {
+
+		const auto& pts = take.c3d->data().frame(frameIndex).points();
+		for (int i = 0; i < take.frames.size(); i++) {
+			auto& f = take.frames[i];
+			take.readFrame(f, pts, frameIndex);
+			// Use the take's time, since this runs faster than realtime
+			f.newFrame.set_timestamp(uint64_t(double(frameIndex) * 1000.0 / fps));
+
+			postprocessors[i]->process(f.newFrame);
+
+			out.add(int(f.systemType), fps, f.newFrame);
+		}
+		for (auto& s : systems) out.update(s);
+	}
+
+	// Write the processed take
+	return out.save();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSTypes.h"
+#include "ofxRTLSTake.h"
+#include "ofxRTLSPostprocessor.h"
+#include "Trackable.pb.h"
+using namespace RTLSProtocol;
+
+// Reprocesses recorded takes (.c3d files) through postprocessors, as fast as
+// possible and without a window, RemoteUI or realtime playback. Each take is
+// written to a new take. Takes are processed in parallel across threads; 
+// frames within a take are always processed in order.
+//
+// Postprocessors are configured with a json settings file resembling:
+// {
+//		"suffix" : "_processed",
+//		"postprocess" : {
+//			"default" : { ... },
+//			"motive" : {
+//				"sample" : { ... }
+//			}
+//		}
+// }
+// where each { ... } contains the postprocessor settings described by
+// ofxRTLSPostprocessor::applySettings(). System and trackable type names 
+// are case-insensitive. Settings for a specific system and trackable type 
+// are used if available; otherwise, the default settings are used.
+class ofxRTLSBatchProcessor {
+public:
+
+	ofxRTLSBatchProcessor();
+	~ofxRTLSBatchProcessor();
+
+	// Load the postprocessor settings from a json file...
+	bool setup(string settingsPath);
+	// ... or provide them directly.
+	void setup(const ofJson& settings);
+
+	// Process takes and write the results. If the output folder is empty,
+	// processed takes are written beside the originals with a suffix.
+	// Takes are processed with nThreads threads (0 uses all cores).
+	// Returns the number of takes that were successfully processed.
+	int process(const vector<string>& takePaths, string outputFolder = "", int nThreads = 0);
+
+	// Get the path at which a processed take will be written
+	string getOutputPath(string takePath, string outputFolder = "");
+
+	// Get the postprocessor settings for a system and trackable type
+	ofJson getSettings(RTLSSystemType systemType, RTLSTrackableType trackableType);
+
+private:
+
+	ofJson settings;
+	string suffix = "_processed";
+
+	// Process a single take
+	bool processTake(string inPath, string outPath);
+};
@@ -0,0 +1,393 @@
+#include "ofxRTLSBlinkDecodeStage.h"
+
+// --------------------------------------------------------------
+ofxRTLSBlinkDecodeStage::ofxRTLSBlinkDecodeStage() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSBlinkDecodeStage::~ofxRTLSBlinkDecodeStage() {
+
+}
+
+// --------------------------------------------------------------
+string ofxRTLSBlinkDecodeStage::getEncodingDescription(Encoding encoding) {
+
+	switch (encoding) {
+	case ENCODING_PULSE_LENGTH: return "pulse-length";
+	case ENCODING_SWITCH: return "switch";
+	case ENCODING_MAX: return "max";
+	case ENCODING_ROLLED: return "rolled";
+	default: return "none";
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::setup(const ofJson& settings) {
+
+	bReady = false;
+
+	string encodingStr = settings.value("encoding", getEncodingDescription(encoding));
+	bool bFound = false;
+	for (int i = 0; i < NUM_ENCODINGS; i++) {
+		if (encodingStr == getEncodingDescription(Encoding(i))) {
+			encoding = Encoding(i);
+			bFound = true;
+		}
+	}
+	if (!bFound) {
+		ofLogError("ofxRTLSBlinkDecodeStage") << "Stage " << getName() << " has no encoding \"" << encodingStr << "\".";
+		return;
+	}
+
+	nBits = settings.value("nBits", nBits);
+	startBit = settings.value("startBit", encoding == ENCODING_SWITCH ? 1 : 0) != 0 ? 1 : 0;
+	offLength = MAX(settings.value("offLength", offLength), 1);
+	onLength = MAX(settings.value("onLength", onLength), 1);
+	stopLength = MAX(settings.value("stopLength", encoding == ENCODING_PULSE_LENGTH ? 5 : 3), 2);
+	bInvert = settings.value("invert", bInvert);
+	brightnessKey = settings.value("brightnessKey", brightnessKey);
+	threshold = settings.value("threshold", threshold);
+	idOffset = settings.value("idOffset", idOffset);
+	minRepeats = MAX(settings.value("minRepeats", minRepeats), 1);
+	timeoutFrames = MAX(settings.value("timeoutFrames", timeoutFrames), 1);
+
+	if (settings.find("keyTypes") != settings.end() && settings["keyTypes"].is_string()) {
+		keyTypes.clear();
+		for (auto& s : ofSplitString(settings["keyTypes"].get<string>(), ",", true, true)) {
+			for (int i = 0; i < NUM_KEYS; i++) {
+				if (s == getTrackableKeyTypeDescription(TrackableKeyType(i))) keyTypes.insert(TrackableKeyType(i));
+			}
+		}
+	}
+	// Tracks without keys cannot be followed across frames
+	keyTypes.erase(KEY_NONE);
+
+	// Make the lookup table of words from the dictionary
+	wordIDs.clear();
+	IDDictionary dict;
+	string dictPath = settings.value("dictPath", string(""));
+	if (!dictPath.empty() && !dict.setup(dictPath)) return;
+	if (encoding == ENCODING_ROLLED) {
+		if (!dict.isSetup()) {
+			ofLogError("ofxRTLSBlinkDecodeStage") << "Stage " << getName() << " requires a dictionary to decode rolled sequences.";
+			return;
+		}
+		nBits = dict.getNumBits();
+	}
+	int maxBits = encoding == ENCODING_MAX ? 62 - stopLength : 24;
+	if (nBits < 1 || nBits > maxBits) {
+		ofLogError("ofxRTLSBlinkDecodeStage") << "Stage " << getName() << " cannot decode words of " << nBits << " bits.";
+		return;
+	}
+	shared_ptr<const IDDictionary::Table> table = dict.getTable();
+	if (table) {
+		wordIDs.assign(size_t(1) << nBits, -1);
+		for (size_t i = 0; i < table->values.size(); i++) {
+			uint32_t value = table->values[i];
+			int ID = table->ids[i];
+			if (encoding == ENCODING_ROLLED) wordIDs[value] = ID;
+			else if (ID < wordIDs.size()) wordIDs[ID] = ID;
+		}
+	}
+
+	// Classify each pulse length by the nearest symbol
+	pulseSymbols.assign(maxRun + 1, SYMBOL_INVALID);
+	for (int run = 1; run <= maxRun; run++) {
+		int dOff = abs(run - offLength);
+		int dOn = abs(run - onLength);
+		int dStop = abs(run - stopLength);
+		if (dOff < dOn && dOff < dStop) pulseSymbols[run] = SYMBOL_ZERO;
+		else if (dOn < dOff && dOn < dStop) pulseSymbols[run] = SYMBOL_ONE;
+		else if (dStop < dOff && dStop < dOn) pulseSymbols[run] = SYMBOL_STOP;
+	}
+
+	reset();
+	bReady = true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::reset() {
+
+	slots.clear();
+	freeSlots.clear();
+	keys.clear();
+	active.clear();
+	lastSeenFrames.clear();
+	rows.clear();
+	inputs.clear();
+	registers.clear();
+	counts.clear();
+	runs.clear();
+	phases.clear();
+	framed.clear();
+	candidates.clear();
+	repeats.clear();
+	IDs.clear();
+	frameIndex = 0;
+}
+
+// --------------------------------------------------------------
+int ofxRTLSBlinkDecodeStage::getSlot(const string& key) {
+
+	auto it = slots.find(key);
+	if (it != slots.end()) return it->second;
+
+	int slot = 0;
+	if (!freeSlots.empty()) {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slot = int(active.size());
+		keys.emplace_back();
+		active.push_back(0);
+		lastSeenFrames.push_back(0);
+		rows.push_back(0);
+		inputs.push_back(0);
+		registers.push_back(0);
+		counts.push_back(0);
+		runs.push_back(0);
+		phases.push_back(0);
+		framed.push_back(0);
+		candidates.push_back(0);
+		repeats.push_back(0);
+		IDs.push_back(0);
+	}
+	slots[key] = slot;
+	keys[slot] = key;
+	active[slot] = 1;
+	registers[slot] = 0;
+	counts[slot] = 0;
+	runs[slot] = 0;
+	phases[slot] = 0;
+	framed[slot] = 0;
+	candidates[slot] = 0;
+	repeats[slot] = 0;
+	IDs[slot] = 0;
+	return slot;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::freeSlot(int slot) {
+
+	slots.erase(keys[slot]);
+	keys[slot].clear();
+	active[slot] = 0;
+	freeSlots.push_back(slot);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::process(ofxRTLSWorkingSet& ws, const Context& /*context*/) {
+
+	if (!bReady) return;
+	frameIndex++;
+
+	// Tracks that are not seen receive a 0
+	std::fill(inputs.begin(), inputs.end(), 0);
+	for (size_t i = 0; i < ws.size(); i++) {
+		if (ws.isRemoved(i)) continue;
+		if (keyTypes.find(ws.getKeyType(i)) == keyTypes.end()) continue;
+
+		int slot = getSlot(ws.getKey(i));
+		lastSeenFrames[slot] = frameIndex;
+		rows[slot] = i;
+		float brightness = 1.0;
+		getContextValue(ws.getSource(i), brightnessKey, brightness);
+		inputs[slot] = brightness >= threshold ? 1 : 0;
+	}
+
+	// Forget tracks that have not been seen for a while
+	for (int slot = 0; slot < active.size(); slot++) {
+		if (active[slot] && frameIndex - lastSeenFrames[slot] > timeoutFrames) freeSlot(slot);
+	}
+	if (bInvert) {
+		for (auto& input : inputs) input ^= 1;
+	}
+
+	// Step all state machines
+	nWords = 0;
+	nRejected = 0;
+	nIdentified = 0;
+	switch (encoding) {
+	case ENCODING_PULSE_LENGTH: stepPulseLength(); break;
+	case ENCODING_SWITCH: stepSwitch(); break;
+	case ENCODING_MAX: stepMax(); break;
+	case ENCODING_ROLLED: stepRolled(); break;
+	default: break;
+	}
+	if (nWords > 0) count("words", nWords);
+	if (nRejected > 0) count("rejected", nRejected);
+	if (nIdentified > 0) count("identified", nIdentified);
+
+	// Apply the decoded IDs
+	for (int slot = 0; slot < active.size(); slot++) {
+		if (!active[slot] || lastSeenFrames[slot] != frameIndex || IDs[slot] == 0) continue;
+		ws.setKey(rows[slot], getTrackableKey(KEY_ID, ofToString(IDs[slot])));
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::stepPulseLength() {
+
+	// Each symbol is a start bit, followed by a pulse of the other bit
+	uint8_t pulseBit = 1 - startBit;
+	for (int slot = 0; slot < active.size(); slot++) {
+		if (!active[slot]) continue;
+
+		if (inputs[slot] == pulseBit) {
+			if (runs[slot] < maxRun) runs[slot]++;
+			continue;
+		}
+
+		// A start bit ends the last pulse
+		Symbol symbol = pulseSymbols[runs[slot]];
+		runs[slot] = 0;
+		switch (symbol) {
+		case SYMBOL_ZERO: receiveBit(slot, 0); break;
+		case SYMBOL_ONE: receiveBit(slot, 1); break;
+		case SYMBOL_STOP: receiveStop(slot); break;
+		default: framed[slot] = 0; break;
+		}
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::stepSwitch() {
+
+	// Each symbol is a start bit, followed by the bit (a 1 is the start bit).
+	// A stop is a start bit followed by a run of the other bit.
+	uint8_t otherBit = 1 - startBit;
+	for (int slot = 0; slot < active.size(); slot++) {
+		if (!active[slot]) continue;
+
+		uint8_t input = inputs[slot];
+		switch (phases[slot]) {
+		case 0: {
+			// Expecting a start bit
+			if (input == startBit) phases[slot] = 1;
+			else framed[slot] = 0;
+		}; break;
+		case 1: {
+			// Expecting a bit
+			if (input == startBit) {
+				receiveBit(slot, 1);
+				phases[slot] = 0;
+			}
+			else {
+				runs[slot] = 1;
+				phases[slot] = 2;
+			}
+		}; break;
+		case 2: default: {
+			// Expecting a start bit (after a 0) or more of a stop
+			if (input == otherBit) {
+				runs[slot]++;
+				if (runs[slot] >= stopLength) {
+					receiveStop(slot);
+					runs[slot] = 0;
+					phases[slot] = 0;
+				}
+			}
+			else {
+				if (runs[slot] == 1) receiveBit(slot, 0);
+				else framed[slot] = 0;
+				runs[slot] = 0;
+				phases[slot] = 1;
+			}
+		}; break;
+		}
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::stepMax() {
+
+	// Words are followed by a stop: a 1, a run of zeros and another 1.
+	// Words themselves have shorter runs of zeros.
+	for (int slot = 0; slot < active.size(); slot++) {
+		if (!active[slot]) continue;
+
+		if (inputs[slot] == 0) {
+			if (runs[slot] < maxRun) runs[slot]++;
+			receiveBit(slot, 0);
+			continue;
+		}
+
+		if (runs[slot] >= stopLength) {
+			// This 1 ends a stop. The bits received are the word, the
+			// stop's first 1 and its zeros.
+			uint64_t word = registers[slot] & ((uint64_t(1) << nBits) - 1);
+			bool bStopStart = (registers[slot] >> nBits) & 1;
+			if (framed[slot] && bStopStart && counts[slot] == nBits + 1 + runs[slot]) receiveWord(slot, word);
+			registers[slot] = 0;
+			counts[slot] = 0;
+			framed[slot] = 1;
+		}
+		else {
+			receiveBit(slot, 1);
+		}
+		runs[slot] = 0;
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::stepRolled() {
+
+	// Every window of bits is a rotation of a word
+	uint64_t highBit = nBits - 1;
+	for (int slot = 0; slot < active.size(); slot++) {
+		if (!active[slot]) continue;
+
+		registers[slot] = (registers[slot] >> 1) | (uint64_t(inputs[slot]) << highBit);
+		if (counts[slot] < nBits) counts[slot]++;
+		if (counts[slot] == nBits) receiveWord(slot, registers[slot]);
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::receiveBit(int slot, uint64_t bit) {
+
+	// Bits are only kept once a stop has framed the word
+	if (!framed[slot]) return;
+	int maxCount = encoding == ENCODING_MAX ? 63 : nBits;
+	if (counts[slot] >= maxCount) {
+		framed[slot] = 0;
+		return;
+	}
+	registers[slot] |= bit << counts[slot];
+	counts[slot]++;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::receiveStop(int slot) {
+
+	if (framed[slot] && counts[slot] == nBits) receiveWord(slot, registers[slot]);
+	registers[slot] = 0;
+	counts[slot] = 0;
+	framed[slot] = 1;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSBlinkDecodeStage::receiveWord(int slot, uint64_t word) {
+
+	int ID = int(word);
+	if (!wordIDs.empty()) ID = word < wordIDs.size() ? wordIDs[word] : -1;
+	if (ID >= 0) ID += idOffset;
+	if (ID <= 0) {
+		nRejected++;
+		repeats[slot] = 0;
+		return;
+	}
+	nWords++;
+
+	if (candidates[slot] == ID) repeats[slot]++;
+	else {
+		candidates[slot] = ID;
+		repeats[slot] = 1;
+	}
+	if (repeats[slot] >= minRepeats && IDs[slot] != ID) {
+		IDs[slot] = ID;
+		nIdentified++;
+	}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSPostprocessStage.h"
+#include "IDDictionary.h"
+
+// Identifies active markers by decoding the bit sequences they blink, one
+// frame at a time, with the encodings of scripts/generate-dictionary.py:
+//	"pulse-length"	each symbol is a start bit followed by a pulse whose length
+//					encodes a 0, a 1 or a stop
+//	"switch"		each symbol is a start bit followed by the bit, or by a
+//					longer run of the opposite bit for a stop
+//	"max"			bits are sent as they are, with at most a few consecutive
+//					zeros, and words are delimited by a longer run of zeros
+//	"rolled"		bits are sent continuously without stops. Each window of
+//					the dictionary's number of bits is looked up in the dictionary.
+// Each track (by its key) is decoded by a state machine that is updated in
+// constant time with the track's bit in each frame: 1 if the track was seen
+// (and is bright enough, if its context has a brightness, e.g. {"b":0.8}) and
+// 0 if not. The states of all tracks are kept in contiguous arrays and
+// updated together, one loop per frame.
+// Decoded words are looked up in a table made from the same json dictionary
+// as IDDictionary loads. For "rolled", the table maps windows to IDs; for the
+// other encodings, it contains the IDs the dictionary maps to, so other words
+// are rejected. (Without a dictionary, words are used as IDs.) An ID is applied
+// to its track once it has been decoded a number of times in a row.
+//
+// This stage should follow the Hungarian stage, so tracks keep their keys
+// from frame to frame. Stage settings (see ofxRTLSPostprocessStage):
+//	"encoding"		"pulse-length", "switch", "max" or "rolled" (default "pulse-length")
+//	"nBits"			bits per word (default 12; "rolled" uses the dictionary's)
+//	"dictPath"		path to the json dictionary (required for "rolled")
+//	"startBit"		value of the start bit ("pulse-length" default 0, "switch" default 1)
+//	"offLength", "onLength"	pulse lengths of a 0 and a 1 ("pulse-length"; default 1 and 2)
+//	"stopLength"	length of a stop ("pulse-length" default 5, otherwise 3)
+//	"invert"		invert each bit (default false)
+//	"brightnessKey"	key of the brightness in the trackable context (default "b")
+//	"threshold"		minimum brightness of a 1 (default 0.5)
+//	"idOffset"		added to each decoded ID (default 0)
+//	"minRepeats"	times an ID must be decoded in a row (default 2)
+//	"timeoutFrames"	frames after which unseen tracks are forgotten (default 60)
+//	"keyTypes"		key types of the tracks decoded (default "cuid")
+class ofxRTLSBlinkDecodeStage : public ofxRTLSPostprocessStage {
+public:
+
+	ofxRTLSBlinkDecodeStage();
+	~ofxRTLSBlinkDecodeStage();
+
+	void setup(const ofJson& settings);
+	void process(ofxRTLSWorkingSet& ws, const Context& context);
+	void reset();
+	bool replacesKeys() { return true; }
+
+	enum Encoding {
+		ENCODING_PULSE_LENGTH = 0,
+		ENCODING_SWITCH,
+		ENCODING_MAX,
+		ENCODING_ROLLED,
+		NUM_ENCODINGS
+	};
+	static string getEncodingDescription(Encoding encoding);
+
+	size_t getNumTracks() { return slots.size(); }
+
+private:
+
+	Encoding encoding = ENCODING_PULSE_LENGTH;
+	int nBits = 12;
+	int startBit = 0;
+	int offLength = 1;
+	int onLength = 2;
+	int stopLength = 5;
+	bool bInvert = false;
+	string brightnessKey = "b";
+	float threshold = 0.5;
+	int idOffset = 0;
+	int minRepeats = 2;
+	int timeoutFrames = 60;
+	set<TrackableKeyType> keyTypes = { KEY_CUID };
+	bool bReady = false;
+
+	// ID of each word (-1 if invalid). Empty if words are IDs.
+	vector<int> wordIDs;
+	// Symbol of each pulse length ("pulse-length")
+	enum Symbol : uint8_t {
+		SYMBOL_ZERO = 0,
+		SYMBOL_ONE,
+		SYMBOL_STOP,
+		SYMBOL_INVALID
+	};
+	vector<Symbol> pulseSymbols;
+	static const int maxRun = 255;
+
+	// State of each track, by slot
+	unordered_map<string, int> slots;
+	vector<int> freeSlots;
+	vector<string> keys;
+	vector<uint8_t> active;
+	vector<uint64_t> lastSeenFrames;
+	vector<size_t> rows;
+	vector<uint8_t> inputs;			// bit of this frame
+	vector<uint64_t> registers;		// bits received (first bit lowest)
+	vector<uint8_t> counts;			// number of bits in the register
+	vector<uint8_t> runs;			// length of the current run
+	vector<uint8_t> phases;			// position within a symbol ("switch")
+	vector<uint8_t> framed;			// has a stop been received?
+	vector<int> candidates;			// last decoded ID
+	vector<int> repeats;			// times the candidate was decoded in a row
+	vector<int> IDs;				// ID applied (0 if none)
+	uint64_t frameIndex = 0;
+	// Words decoded in this frame (added to the stage's counters once per frame)
+	uint64_t nWords = 0;
+	uint64_t nRejected = 0;
+	uint64_t nIdentified = 0;
+
+	int getSlot(const string& key);
+	void freeSlot(int slot);
+
+	// Update the state machines of all tracks with their inputs
+	void stepPulseLength();
+	void stepSwitch();
+	void stepMax();
+	void stepRolled();
+	// A bit or a stop was received by a track
+	void receiveBit(int slot, uint64_t bit);
+	void receiveStop(int slot);
+	// A word was decoded by a track
+	void receiveWord(int slot, uint64_t word);
+};
@@ -0,0 +1,113 @@
+#include "ofxRTLSClockSync.h"
+
+// --------------------------------------------------------------
+ofxRTLSClockSync::ofxRTLSClockSync() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSClockSync::~ofxRTLSClockSync() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSClockSync::addSample(uint64_t sourceMicros, uint64_t serverMicros) {
+
+	double offset = double(int64_t(serverMicros - sourceMicros));
+
+	// Start over if the source clock has jumped
+	if (bReference) {
+		bool bJump = sourceMicros < lastSourceMicros;
+		if (!bJump) {
+			double predicted = intercept + slope * double(int64_t(sourceMicros - referenceMicros));
+			bJump = abs(offset - predicted) > double(maxJumpMicros);
+		}
+		if (bJump) {
+			ofLogVerbose("ofxRTLSClockSync") << "The source clock jumped. Restarting the estimate.";
+			reset();
+			nResets++;
+		}
+	}
+	if (!bReference) {
+		bReference = true;
+		referenceMicros = sourceMicros;
+	}
+	lastSourceMicros = sourceMicros;
+	int64_t relMicros = int64_t(sourceMicros - referenceMicros);
+
+	// Keep the lowest offset of each window
+	if (windows.empty() || relMicros - windows.back().startMicros >= int64_t(windowMicros)) {
+		Window window;
+		window.startMicros = relMicros;
+		window.sourceMicros = relMicros;
+		window.offsetMicros = offset;
+		windows.push_back(window);
+		while (windows.size() > size_t(nWindows) + 1) windows.pop_front();
+	}
+	else if (offset < windows.back().offsetMicros) {
+		windows.back().sourceMicros = relMicros;
+		windows.back().offsetMicros = offset;
+	}
+
+	fit();
+	nSamples++;
+	offsetMicros = intercept + slope * double(relMicros);
+	driftPPM = slope * 1.0E6;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSClockSync::fit() {
+
+	// The last window is incomplete, so its lowest offset may still fall.
+	// Fit the complete windows once there are enough of them.
+	size_t nComplete = windows.size() - 1;
+	if (nComplete < 2) {
+		slope = 0;
+		intercept = windows.front().offsetMicros;
+		for (auto& w : windows) intercept = MIN(intercept, w.offsetMicros);
+		return;
+	}
+
+	// Least squares, centered for precision
+	double meanX = 0, meanY = 0;
+	for (size_t i = 0; i < nComplete; i++) {
+		meanX += double(windows[i].sourceMicros);
+		meanY += windows[i].offsetMicros;
+	}
+	meanX /= double(nComplete);
+	meanY /= double(nComplete);
+	double sxx = 0, sxy = 0;
+	for (size_t i = 0; i < nComplete; i++) {
+		double dx = double(windows[i].sourceMicros) - meanX;
+		sxx += dx * dx;
+		sxy += dx * (windows[i].offsetMicros - meanY);
+	}
+	slope = sxx > 0 ? sxy / sxx : 0;
+	intercept = meanY - slope * meanX;
+
+	// The most recent samples bound the offset from above
+	double current = intercept + slope * double(windows.back().sourceMicros);
+	if (windows.back().offsetMicros < current) intercept -= current - windows.back().offsetMicros;
+}
+
+// --------------------------------------------------------------
+uint64_t ofxRTLSClockSync::map(uint64_t sourceMicros) {
+
+	if (!bReference) return sourceMicros;
+	double relMicros = double(int64_t(sourceMicros - referenceMicros));
+	return sourceMicros + uint64_t(int64_t(llround(intercept + slope * relMicros)));
+}
+
+// --------------------------------------------------------------
+void ofxRTLSClockSync::reset() {
+
+	windows.clear();
+	bReference = false;
+	referenceMicros = 0;
+	lastSourceMicros = 0;
+	intercept = 0;
+	slope = 0;
+	offsetMicros = 0;
+	driftPPM = 0;
+	nSamples = 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Maps the times at which a system captured its frames, on the system's own
+// clock, to the server's clock (ofGetElapsedTimeMicros()).
+//
+// Each frame gives a sample of (source time, arrival time). Arrivals are
+// late by an unknown, varying delay (transport and callback scheduling), so
+// the samples with the least delay best describe the clocks' relationship.
+// The lowest offset (arrival - source) of each window of source time is
+// kept, and a line is fit through the recent windows' lowest offsets: its
+// intercept is the clocks' offset and its slope their relative drift.
+// Mapped times therefore exclude jitter, but include the least delay seen.
+// If the source clock jumps (e.g. it restarts), the estimate starts over.
+// Notes:
+// -	Samples are added and times are mapped on one thread (the thread that
+//		receives the system's data). The estimate can be read from any thread.
+class ofxRTLSClockSync {
+public:
+
+	ofxRTLSClockSync();
+	~ofxRTLSClockSync();
+
+	// Add the source time of a frame and its arrival time on the server (us)
+	void addSample(uint64_t sourceMicros, uint64_t serverMicros);
+	// Map a source time to the server's clock (us). Until samples have been
+	// added, source times are returned unchanged.
+	uint64_t map(uint64_t sourceMicros);
+
+	void reset();
+
+	// Duration of the windows of source time, and how many windows are fit
+	void setWindowMicros(uint64_t _windowMicros) { windowMicros = MAX(_windowMicros, uint64_t(1)); }
+	void setNumWindows(int _nWindows) { nWindows = MAX(_nWindows, 2); }
+	// How far a sample's offset may be from the estimate before the source
+	// clock is considered to have jumped (us)
+	void setMaxJumpMicros(uint64_t _maxJumpMicros) { maxJumpMicros = _maxJumpMicros; }
+
+	// The current estimate: offset of the server's clock from the source's
+	// (us) and drift of the source's clock (parts per million, positive if
+	// the source's clock runs slow)
+	double getOffsetMicros() { return offsetMicros; }
+	double getDriftPPM() { return driftPPM; }
+	// Number of samples in the estimate and times it has started over
+	uint64_t getNumSamples() { return nSamples; }
+	uint64_t getNumResets() { return nResets; }
+
+private:
+
+	// Lowest offset of a window of source time
+	struct Window {
+		// Start of the window, and source time of its lowest offset
+		// (relative to the reference)
+		int64_t startMicros = 0;
+		int64_t sourceMicros = 0;
+		double offsetMicros = 0;
+	};
+	deque<Window> windows;
+	uint64_t windowMicros = 1000000;
+	int nWindows = 30;
+	uint64_t maxJumpMicros = 1000000;
+
+	// Source times are relative to the first sample, to keep precision
+	bool bReference = false;
+	uint64_t referenceMicros = 0;
+	uint64_t lastSourceMicros = 0;
+
+	// Fit of offset = intercept + slope * (relative source time)
+	double intercept = 0;
+	double slope = 0;
+	void fit();
+
+	atomic<double> offsetMicros = 0;
+	atomic<double> driftPPM = 0;
+	atomic<uint64_t> nSamples = 0;
+	atomic<uint64_t> nResets = 0;
+};
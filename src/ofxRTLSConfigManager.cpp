@@ -47,16 +47,72 @@ bool ofxRTLSConfigManager::load(string config_path)
 			auto n_invalid_systems = 0;
 			for (auto i = 0; i < js.find("systems")->size(); i++)
 			{
-				auto system = js.find("systems")->at(i).get<string>();
+				// Each entry is either the name of a system or an object 
+				// describing its instances, e.g. { "system" : "Null", "id" : "north", "count" : 4 }
+				auto& entry = js.find("systems")->at(i);
+				string system = "";
+				string id = "";
+				int count = 1;
+				if (entry.is_string())
+				{
+					system = entry.get<string>();
+				} else if (entry.is_object() && entry.find("system") != entry.end() && entry["system"].is_string())
+				{
+					system = entry["system"].get<string>();
+					if (entry.find("id") != entry.end() && entry["id"].is_string())
+						id = entry["id"].get<string>();
+					if (entry.find("count") != entry.end() && entry["count"].is_number_integer())
+						count = entry["count"].get<int>();
+				}
 				system = ofToLower(system);
+
+				RTLSSystemType system_type = RTLS_SYSTEM_TYPE_INVALID;
 				if (system == "null")
-					null_ = true;
+					system_type = RTLS_SYSTEM_TYPE_NULL;
 				else if (system == "openvr")
-					openvr_ = true;
+					system_type = RTLS_SYSTEM_TYPE_OPENVR;
 				else if (system == "motive")
-					motive_ = true;
-				else
+					system_type = RTLS_SYSTEM_TYPE_MOTIVE;
+				if (system_type == RTLS_SYSTEM_TYPE_INVALID || count < 1)
+				{
 					n_invalid_systems++;
+					continue;
+				}
+
+				// OpenVR and Motive connect to a single runtime, so they have
+				// one instance, named after the system
+				if (system_type != RTLS_SYSTEM_TYPE_NULL)
+				{
+					if ((system_type == RTLS_SYSTEM_TYPE_OPENVR && openvr_) || (system_type == RTLS_SYSTEM_TYPE_MOTIVE && motive_) || count > 1)
+						ofLogWarning("ofxRTLSConfigManager") << "Only one instance of " << system << " is supported.";
+					if (!id.empty() && id != system)
+						ofLogWarning("ofxRTLSConfigManager") << "The ID of " << system << " is always \"" << system << "\".";
+					id = "";
+					count = 1;
+				}
+				if (id.empty()) id = system;
+
+				for (int j = 0; j < count; j++)
+				{
+					Source source;
+					source.id = count == 1 ? id : id + "-" + ofToString(j);
+					source.systemType = system_type;
+					bool duplicate = false;
+					for (auto& other : sources_) duplicate |= other.id == source.id;
+					if (duplicate)
+					{
+						if (system_type == RTLS_SYSTEM_TYPE_NULL)
+							ofLogWarning("ofxRTLSConfigManager") << "Source ID \"" << source.id << "\" is listed more than once. Only the first is used.";
+						continue;
+					}
+					sources_.push_back(source);
+				}
+				if (system_type == RTLS_SYSTEM_TYPE_NULL)
+					null_ = true;
+				else if (system_type == RTLS_SYSTEM_TYPE_OPENVR)
+					openvr_ = true;
+				else if (system_type == RTLS_SYSTEM_TYPE_MOTIVE)
+					motive_ = true;
 			}
 			if (n_invalid_systems == js.find("systems")->size())
 			{
@@ -71,6 +127,22 @@ bool ofxRTLSConfigManager::load(string config_path)
 	if (js.find("player") != js.end())
 		player_ = js.find("player")->get<bool>();
 
+	if (js.find("pipelines") != js.end())
+	{
+		if (!js.find("pipelines")->is_object())
+			ofLogWarning("ofxRTLSConfigManager") << "Pipelines must be supplied as an object. None loaded.";
+		else
+			pipelines_ = *js.find("pipelines");
+	}
+
+	if (js.find("sync") != js.end())
+	{
+		if (!js.find("sync")->is_object())
+			ofLogWarning("ofxRTLSConfigManager") << "Sync settings must be supplied as an object. Frames will not be synchronized.";
+		else
+			sync_ = *js.find("sync");
+	}
+
 	// Try to get the optional parameters
 	if (js.find("project_metadata") != js.end())
 	{
@@ -96,6 +168,59 @@ bool ofxRTLSConfigManager::load(string config_path)
 	return true;
 }
 
+// ----------------------------------------------------------------------------
+bool ofxRTLSConfigManager::reload(string config_path)
+{
+	// Parse the file into a separate configuration, so the current one is
+	// untouched (and stays readable by other threads) until it is replaced
+	ofxRTLSConfigManager next;
+	next.config_path_ = config_path_;
+	if (!next.load(config_path))
+	{
+		ofLogError("ofxRTLSConfigManager") << "Config file could not be reloaded. The previous settings are kept.";
+		return false;
+	}
+
+	// Recordings and playback are setup once
+	if (next.player_ != player_)
+		ofLogWarning("ofxRTLSConfigManager") << "Player support cannot be changed while the app is running.";
+
+	std::lock_guard<std::mutex> lk(mutex_);
+	config_path_ = next.config_path_;
+	sources_ = next.sources_;
+	null_ = next.null_;
+	openvr_ = next.openvr_;
+	motive_ = next.motive_;
+	postprocess_ = next.postprocess_;
+	pipelines_ = next.pipelines_;
+	sync_ = next.sync_;
+	project_metadata_exists_ = next.project_metadata_exists_;
+	project_name_ = next.project_name_;
+	project_version_ = next.project_version_;
+	project_commit_ = next.project_commit_;
+	project_repo_ = next.project_repo_;
+	return true;
+}
+
+// ----------------------------------------------------------------------------
+ofJson ofxRTLSConfigManager::pipeline(string system, string trackable_type, string source_id) const
+{
+	std::lock_guard<std::mutex> lk(mutex_);
+	if (!pipelines_.is_object()) return ofJson();
+
+	system = ofToLower(system);
+	trackable_type = ofToLower(trackable_type);
+	if (!source_id.empty() && pipelines_.find(source_id) != pipelines_.end() &&
+		pipelines_[source_id].find(trackable_type) != pipelines_[source_id].end())
+		return pipelines_[source_id][trackable_type];
+	if (pipelines_.find(system) != pipelines_.end() && 
+		pipelines_[system].find(trackable_type) != pipelines_[system].end())
+		return pipelines_[system][trackable_type];
+	if (pipelines_.find("default") != pipelines_.end())
+		return pipelines_["default"];
+	return ofJson();
+}
+
 // ----------------------------------------------------------------------------
 string ofxRTLSConfigManager::project_metadata()
 {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ofMain.h"
+#include "ofxRTLSTypes.h"
 
 class ofxRTLSConfigManager
 {
@@ -11,20 +12,46 @@ public:
 	// Load the rtls configuration
 	bool load(string config_path = "");
 
-	// Check if options are enabled
-	bool motive() const { return motive_; }
-	bool openvr() const { return openvr_; }
-	bool null() const { return null_; }
-	bool postprocess() const { return postprocess_; }
+	// Load the rtls configuration again (e.g. after the file has changed).
+	// If the file cannot be loaded, the current configuration is kept.
+	// Player support is not changed by reloading. The new configuration
+	// replaces the current one atomically.
+	// (Use ofxRTLS::reloadConfig() to apply the new configuration.)
+	bool reload(string config_path = "");
+
+	// An instance of a tracking system listed under "systems". Each source
+	// has a unique ID, which is included in the context of its frames.
+	struct Source {
+		string id = "";
+		RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+	};
+	vector<Source> sources() const { std::lock_guard<std::mutex> lk(mutex_); return sources_; }
+
+	// Check if options are enabled (i.e. if any source of a system is listed)
+	bool motive() const { std::lock_guard<std::mutex> lk(mutex_); return motive_; }
+	bool openvr() const { std::lock_guard<std::mutex> lk(mutex_); return openvr_; }
+	bool null() const { std::lock_guard<std::mutex> lk(mutex_); return null_; }
+	bool postprocess() const { std::lock_guard<std::mutex> lk(mutex_); return postprocess_; }
+	// (Never changed by reloading, so this can be read from any thread)
 	bool player() const { return player_; }
 
+	// Get the postprocessing pipeline declared for a system and trackable type
+	// (e.g. "motive", "sample") under "pipelines" (falling back to 
+	// "pipelines > default"). Returns null if none is declared. If a source ID
+	// is given, a pipeline declared for that source takes precedence.
+	ofJson pipeline(string system, string trackable_type, string source_id = "") const;
+
+	// Get the settings of the frame synchronizer under "sync" (see 
+	// ofxRTLSSynchronizer). Returns null if frames aren't synchronized.
+	ofJson sync() const { std::lock_guard<std::mutex> lk(mutex_); return sync_; }
+
 	// Optional project metadata that may be supplied in the rtls config file:
-	bool project_metadata_exists() { return project_metadata_exists_; }
+	bool project_metadata_exists() { std::lock_guard<std::mutex> lk(mutex_); return project_metadata_exists_; }
 	string project_metadata();
-	string project_name() const { return project_name_; }
-	string project_version() const { return project_version_; }
-	string project_commit() const { return project_commit_; }
-	string project_repo() const { return project_repo_; }
+	string project_name() const { std::lock_guard<std::mutex> lk(mutex_); return project_name_; }
+	string project_version() const { std::lock_guard<std::mutex> lk(mutex_); return project_version_; }
+	string project_commit() const { std::lock_guard<std::mutex> lk(mutex_); return project_commit_; }
+	string project_repo() const { std::lock_guard<std::mutex> lk(mutex_); return project_repo_; }
 	
 	
 private:
@@ -34,14 +61,20 @@ private:
 	ofxRTLSConfigManager() {};
 	~ofxRTLSConfigManager() {};
 
+	// Guards the fields that can be reloaded
+	mutable std::mutex mutex_;
+
 	string config_path_ = "configs/rtls-config.json";
 	bool loaded_ = false;
 	
+	vector<Source> sources_;
 	bool null_ = false;
 	bool openvr_ = false;
 	bool motive_ = false;
 	bool postprocess_ = false;
 	bool player_ = false;
+	ofJson pipelines_;
+	ofJson sync_;
 
 	bool project_metadata_exists_ = false;
 	string project_name_ = "";
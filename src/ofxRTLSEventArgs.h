@@ -12,6 +12,23 @@ public:
 	bool isValid() { return startTimeUS != 0 && stopTimeUS != 0; }
 };
 
+// Information about data played back from a take
+struct ofxRTLSPlaybackInfo {
+	// Is this data from a take?
+	bool bValid = false;
+	// Index of this frame in the take
+	uint64_t frameIndex = 0;
+	// Time of this frame in the take (ms)
+	uint64_t timeMS = 0;
+	// Generation of the player's keyframes (changes when they are invalidated)
+	uint64_t generation = 0;
+	// Should postprocessors capture their states before processing this frame?
+	bool bKeyframe = false;
+	// Is this frame replayed only to bring postprocessors up to date?
+	// (If so, it is not sent out.)
+	bool bReplay = false;
+};
+
 // The event args output
 class ofxRTLSEventArgs : public ofEventArgs {
 public:
@@ -35,6 +52,26 @@ public:
 	RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
 	RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
 
+	// Time this data was captured, on the server's monotonic clock 
+	// (ofGetElapsedTimeMicros()). If the system reports when it captured the
+	// data, this is that time mapped to the server's clock (see 
+	// ofxRTLSClockSync); otherwise, it's the time the data was received. 
+	// The frame's timestamp is this time in ms.
+	uint64_t timeMicros = 0;
+	// Time this data was captured on the system's own clock (0 if unknown)
+	uint64_t sourceTimeMicros = 0;
+
+	// ID of the source of this data (see ofxRTLSConfigManager; empty for 
+	// data from the player)
+	string sourceID = "";
+
+	// Playback information (only valid for data from the player)
+	ofxRTLSPlaybackInfo playback;
+
+	// Name of the postprocessing output that produced this data (empty for
+	// the main output; see ofxRTLSPostprocessor)
+	string output = "";
+
 	// (Optional, for more accuracy)
 	// Set the time this data was first being assembled.
 	void flagStartAssembly() {
@@ -64,10 +101,15 @@ public:
 		bValid = other.bValid;
 		systemType = other.systemType;
 		trackableType = other.trackableType;
+		timeMicros = other.timeMicros;
+		sourceTimeMicros = other.sourceTimeMicros;
+		sourceID = other.sourceID;
+		playback = other.playback;
+		output = other.output;
 	}
 
 private:
-	ofEvent<ofxRTLSLatencyArgs>* newLatencyCalculated;
+	ofEvent<ofxRTLSLatencyArgs>* newLatencyCalculated = NULL;
 	ofxRTLSLatencyArgs latency;
 	bool bSent = false;
 	bool bValid = true;
@@ -94,9 +136,76 @@ public:
 	vector< pair<RTLSSystemType, RTLSTrackableType> > systems;
 };
 
+// A postprocessor's state, captured before it processed a frame of a take
+class ofxRTLSPostprocessorStateArgs : public ofEventArgs {
+public:
+	RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+	RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
+	ofxRTLSPlaybackInfo playback;
+	string state = "";
+};
+
+// A postprocessor has changed how much it degrades processing to meet its
+// frame budget (see ofxRTLSFrameBudget)
+class ofxRTLSDegradationArgs : public ofEventArgs {
+public:
+	RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+	RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
+	// Number of degradations applied, and their descriptions in order
+	int level = 0;
+	vector<string> degradations;
+	// Projected cost of the frame at this level, and the budget (microseconds)
+	double projectedMicros = 0;
+	uint64_t budgetMicros = 0;
+};
+
+// Postprocessor states that should be restored
+class ofxRTLSPlayerRestoreArgs : public ofEventArgs {
+public:
+	struct Entry {
+		RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+		RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
+		// State to restore (if empty, the postprocessor is reset)
+		string state = "";
+	};
+	vector<Entry> entries;
+};
+
 // Argument when a file begins or stops playing
 class ofxRTLSPlaybackArgs : public ofEventArgs {
 public:
 	bool bPlay = false;
 	bool bPause = false;
-};
\ No newline at end of file
+};
+// A frame merged from the frames of several sources at a common time 
+// (see ofxRTLSSynchronizer)
+class ofxRTLSSyncArgs : public ofEventArgs {
+public:
+	// The merged frame. Its timestamp is the common time, and its context
+	// has the system -1 (multiple systems).
+	TrackableFrame frame;
+	// The common time of the frame (us, on the server's clock)
+	uint64_t timeMicros = 0;
+
+	// How a source's trackables were brought to the common time
+	enum Mode {
+		INTERPOLATED = 0,	// between two of its frames
+		EXTRAPOLATED,		// beyond its latest frame (by at most the bound)
+		HELD				// from its oldest frame, if none is older
+	};
+	// The trackables of each source, in the order they appear in the frame
+	struct Stream {
+		string sourceID = "";
+		RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+		RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
+		// Range of the stream's trackables in the frame [begin, end)
+		int begin = 0;
+		int end = 0;
+		Mode mode = INTERPOLATED;
+		// Time of the latest frame received from the source (us)
+		uint64_t latestTimeMicros = 0;
+	};
+	vector<Stream> streams;
+	// Sources left out because their latest frame was too old
+	vector<string> staleSources;
+};
@@ -0,0 +1,73 @@
+#include "ofxRTLSFilterStage.h"
+
+// --------------------------------------------------------------
+void ofxRTLSFilterStage::apply(ofxRTLSWorkingSet& ws, uint64_t timeMS, State& state) {
+
+	// For all that remain in the filter, set their new coordinates and export them
+
+	// Input the new data
+	state.rowFilters.resize(ws.size());
+	for (size_t i = 0; i < ws.size(); i++) {
+		// Add new data to the filter 
+		state.rowFilters[i] = state.filters.getFilter(ws.getKey(i));
+		state.rowFilters[i]->process(ws.getPosition(i));
+	}
+
+	// Process any remaining filters that haven't seen data
+	state.filters.processRemaining();
+
+	// Delete any data that is invalid.
+	// Also save the filters of all data that is valid.
+	state.existingFilters.clear();
+	for (size_t i = 0; i < ws.size(); i++) {
+		// Check if this trackable's data is invalid.
+		ofxFilter* filter = state.rowFilters[i];
+		if (!filter->isDataValid()) {
+			// If not, delete it
+			ws.remove(i);
+		}
+		else {
+			// Save that this filter has valid data
+			state.existingFilters.insert(filter);
+
+			// Set this new processed data
+			ws.setPosition(i, filter->getPosition());
+		}
+	}
+
+	// Add any data that isn't present
+	for (auto& it : state.filters.getFilters()) {
+		// Check if this is a new ID and if it has valid data.
+		if (state.existingFilters.find(it.second) == state.existingFilters.end() && it.second->isDataValid()) {
+			// If so, add a trackable with this key and position
+			ws.add(it.first, it.second->getPosition());
+		}
+	}
+
+	// Delete any filters that haven't been used recently
+	if (timeMS < state.lastCullingTime ||
+		timeMS - state.lastCullingTime > state.cullingPeriod) {
+		state.lastCullingTime = timeMS;
+		state.filters.removeUnused();
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFilterStage::setup(const ofJson& settings) {
+
+	state.filters.setup(settings.value("groupName", string("RTLS-") + getName()), 
+		settings.value("filterList", string("")));
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFilterStage::process(ofxRTLSWorkingSet& ws, const Context& context) {
+
+	apply(ws, context.timeMS, state);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFilterStage::reset() {
+
+	state.filters.reset();
+	state.lastCullingTime = 0;
+}
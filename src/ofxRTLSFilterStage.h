@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSPostprocessStage.h"
+#include "ofxFilterGroup.h"
+
+// Smooths the positions of trackables with a group of filters (one filter
+// per key), which also persist trackables that briefly disappear. The
+// built-in "filters" stage uses the postprocessor's filters. This stage owns
+// its filters instead, so that each output of a postprocessor (see 
+// ofxRTLSPostprocessor) can filter the same frames differently.
+// Stage settings (see ofxRTLSPostprocessStage):
+//	"filterList"	filters to apply, as in the postprocessor's settings
+//	"groupName"		name of the filter group's params (set by the postprocessor)
+class ofxRTLSFilterStage : public ofxRTLSPostprocessStage {
+public:
+
+	// A group of filters and the state used to apply them to working sets
+	struct State {
+		ofxFilterGroup filters;
+		// Filter of each trackable in the working set, and the filters with
+		// valid data in the current frame
+		vector<ofxFilter*> rowFilters;
+		unordered_set<ofxFilter*> existingFilters;
+		// When was the last time filters were culled? (ms)
+		uint64_t lastCullingTime = 0;
+		// What is the period by which filters are culled? (ms)
+		uint64_t cullingPeriod = 1000; // each second
+	};
+	// Filter a working set of a frame at a time (ms)
+	static void apply(ofxRTLSWorkingSet& ws, uint64_t timeMS, State& state);
+
+	void setup(const ofJson& settings);
+	void process(ofxRTLSWorkingSet& ws, const Context& context);
+	void reset();
+
+	size_t getNumFilters() { return state.filters.getFilters().size(); }
+
+private:
+
+	State state;
+};
@@ -0,0 +1,171 @@
+#include "ofxRTLSFrameBudget.h"
+
+// --------------------------------------------------------------
+ofxRTLSFrameBudget::ofxRTLSFrameBudget() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSFrameBudget::~ofxRTLSFrameBudget() {
+
+}
+
+// --------------------------------------------------------------
+string ofxRTLSFrameBudget::getDegradationDescription(Degradation degradation) {
+
+	switch (degradation) {
+	case DEGRADE_SHRINK_HUNGARIAN: return "shrinkHungarian";
+	case DEGRADE_SKIP_OPTIONAL: return "skipOptional";
+	case DEGRADE_COALESCE: return "coalesce";
+	default: return "none";
+	}
+}
+
+// --------------------------------------------------------------
+ofxRTLSFrameBudget::Degradation ofxRTLSFrameBudget::getDegradation(string description) {
+
+	for (Degradation d : { DEGRADE_SHRINK_HUNGARIAN, DEGRADE_SKIP_OPTIONAL, DEGRADE_COALESCE }) {
+		if (ofToLower(description) == ofToLower(getDegradationDescription(d))) return d;
+	}
+	return DEGRADE_NONE;
+}
+
+// --------------------------------------------------------------
+vector<ofxRTLSFrameBudget::Degradation> ofxRTLSFrameBudget::parseDegradations(string list) {
+
+	vector<Degradation> out;
+	for (auto& s : ofSplitString(list, ",", true, true)) {
+		Degradation d = getDegradation(s);
+		if (d == DEGRADE_NONE) {
+			ofLogError("ofxRTLSFrameBudget") << "There is no degradation \"" << s << "\".";
+			continue;
+		}
+		if (find(out.begin(), out.end(), d) == out.end()) out.push_back(d);
+	}
+	return out;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFrameBudget::setup(const vector<StageInfo>& _stages, const Settings& _settings) {
+
+	stages = _stages;
+	settings = _settings;
+	settings.smoothing = ofClamp(settings.smoothing, 0.001, 1.0);
+	settings.recoverFrames = MAX(settings.recoverFrames, 1);
+	frameMicros = settings.frameMicros;
+	setHungarianMaxSamples(settings.hungarianMaxSamples);
+
+	nSegments = 1;
+	for (auto& stage : stages) nSegments = MAX(nSegments, stage.segment + 1);
+
+	models.clear();
+	for (size_t i = 0; i < stages.size(); i++) {
+		models.push_back(unique_ptr<StageModel>(new StageModel()));
+	}
+
+	level = 0;
+	flags = DEGRADE_NONE;
+	projectedMicros = 0;
+	nRecoverFrames = 0;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFrameBudget::setPriority(const vector<Degradation>& priority) {
+
+	settings.priority = priority;
+	level = 0;
+	flags = DEGRADE_NONE;
+	nRecoverFrames = 0;
+}
+
+// --------------------------------------------------------------
+uint32_t ofxRTLSFrameBudget::getFlags(int _level) {
+
+	uint32_t out = DEGRADE_NONE;
+	for (int i = 0; i < _level && i < settings.priority.size(); i++) out |= settings.priority[i];
+	return out;
+}
+
+// --------------------------------------------------------------
+double ofxRTLSFrameBudget::project(size_t nTrackables, int _level) {
+
+	uint32_t _flags = getFlags(_level);
+	vector<double> segmentMicros(nSegments, 0.0);
+	for (size_t i = 0; i < stages.size(); i++) {
+		StageInfo& stage = stages[i];
+		StageModel& model = *models[i];
+		if (!model.bMeasured) continue;
+		if (stage.bOptional && (_flags & DEGRADE_SKIP_OPTIONAL)) continue;
+
+		double n = double(nTrackables) * model.inputRatio;
+		if (stage.bHungarian && (_flags & DEGRADE_SHRINK_HUNGARIAN)) n = MIN(n, double(hungarianMaxSamples));
+		segmentMicros[stage.segment] += model.coefficient * pow(n, stage.costExponent);
+	}
+	return *max_element(segmentMicros.begin(), segmentMicros.end());
+}
+
+// --------------------------------------------------------------
+uint32_t ofxRTLSFrameBudget::beginFrame(size_t nTrackables) {
+
+	uint64_t budget = frameMicros;
+	if (budget == 0) {
+		level = 0;
+		flags = DEGRADE_NONE;
+		projectedMicros = 0;
+		nRecoverFrames = 0;
+		return flags;
+	}
+
+	// Find the lowest level that meets the budget
+	int maxLevel = getMaxLevel();
+	int target = 0;
+	while (target < maxLevel && project(nTrackables, target) > double(budget)) target++;
+
+	if (target > level) {
+		// Degrade immediately
+		level = target;
+		nRecoverFrames = 0;
+	}
+	else if (target < level) {
+		// Recover gradually, so processing doesn't alternate between levels
+		if (project(nTrackables, level - 1) <= double(budget) * settings.recoverRatio) nRecoverFrames++;
+		else nRecoverFrames = 0;
+		if (nRecoverFrames >= settings.recoverFrames) {
+			level = level - 1;
+			nRecoverFrames = 0;
+		}
+	}
+	else {
+		nRecoverFrames = 0;
+	}
+
+	flags = getFlags(level);
+	projectedMicros = project(nTrackables, level);
+	if (level > 0) nDegradedFrames++;
+	return flags;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFrameBudget::recordStage(size_t stage, uint64_t micros, size_t nIn,
+	size_t nTrackables, uint32_t degradations) {
+
+	if (stage >= models.size()) return;
+	StageInfo& info = stages[stage];
+	StageModel& model = *models[stage];
+
+	// Find the size of the problem this stage solved
+	double n = double(nIn);
+	if (info.bHungarian && (degradations & DEGRADE_SHRINK_HUNGARIAN)) n = MIN(n, double(hungarianMaxSamples));
+	double coefficient = double(micros) / pow(MAX(n, 1.0), info.costExponent);
+	double inputRatio = nTrackables == 0 ? double(model.inputRatio) : double(nIn) / double(nTrackables);
+
+	if (!model.bMeasured) {
+		model.coefficient = coefficient;
+		model.inputRatio = inputRatio;
+		model.bMeasured = true;
+		return;
+	}
+	double a = settings.smoothing;
+	model.coefficient = model.coefficient + a * (coefficient - model.coefficient);
+	model.inputRatio = model.inputRatio + a * (inputRatio - model.inputRatio);
+}
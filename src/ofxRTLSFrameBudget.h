@@ -0,0 +1,121 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Keeps the processing of each frame within a deadline by degrading
+// processing when a frame is projected to take too long.
+//
+// The cost of each stage is modeled as c * n^p, where n is the number of
+// trackables the stage operates on and p is the stage's cost exponent (e.g. 1
+// for linear stages, 2 for the Hungarian stage). The coefficient c and the
+// ratio of the stage's input to the frame's size are exponentially weighted
+// moving averages of measured frames. Before a frame is processed, its cost is
+// projected from its number of trackables. If this exceeds the budget,
+// degradations are applied in order of priority until it does not (or all are
+// applied). Processing recovers one level at a time, once the projected cost
+// of the level below has stayed under a fraction of the budget for a number
+// of frames.
+// When stages run on several threads, each thread only needs to meet the
+// budget, so the most expensive segment of stages is projected instead.
+class ofxRTLSFrameBudget {
+public:
+
+	ofxRTLSFrameBudget();
+	~ofxRTLSFrameBudget();
+
+	// Ways of degrading processing
+	enum Degradation : uint32_t {
+		DEGRADE_NONE = 0,
+		// Limit the number of samples in the Hungarian FROM and TO sets
+		DEGRADE_SHRINK_HUNGARIAN = 1 << 0,
+		// Skip stages that are flagged as optional
+		DEGRADE_SKIP_OPTIONAL = 1 << 1,
+		// Only process the most recent of the frames waiting in the queue
+		DEGRADE_COALESCE = 1 << 2
+	};
+	// Descriptions are "shrinkHungarian", "skipOptional" and "coalesce"
+	static string getDegradationDescription(Degradation degradation);
+	static Degradation getDegradation(string description);
+	// Parse a comma-separated list of degradations
+	static vector<Degradation> parseDegradations(string list);
+
+	struct Settings {
+		// Budget of each frame (0 disables degradation)
+		uint64_t frameMicros = 0;
+		// Weight of each new measurement in the moving averages
+		float smoothing = 0.1;
+		// Degradations in the order they are applied
+		vector<Degradation> priority = { DEGRADE_SHRINK_HUNGARIAN, DEGRADE_SKIP_OPTIONAL, DEGRADE_COALESCE };
+		// Size of each Hungarian set when shrunk
+		int hungarianMaxSamples = 32;
+		// Recover a level after this many frames under (budget * recoverRatio)
+		int recoverFrames = 30;
+		float recoverRatio = 0.8;
+	};
+
+	// How a stage is projected
+	struct StageInfo {
+		double costExponent = 1.0;
+		bool bOptional = false;
+		bool bHungarian = false;
+		// Segment (thread) the stage runs on
+		int segment = 0;
+	};
+
+	// Setup the budget for a pipeline of stages.
+	// (Not thread-safe. Measurements are discarded.)
+	void setup(const vector<StageInfo>& stages, const Settings& settings);
+	// Change the budget of each frame. This can be called from any thread.
+	void setFrameMicros(uint64_t micros) { frameMicros = micros; }
+	uint64_t getFrameMicros() { return frameMicros; }
+	void setHungarianMaxSamples(int n) { hungarianMaxSamples = MAX(n, 1); }
+	int getHungarianMaxSamples() { return hungarianMaxSamples; }
+	// Change the order of degradations, which starts over from no degradation.
+	// (Only call this from the thread that calls beginFrame().)
+	void setPriority(const vector<Degradation>& priority);
+	const vector<Degradation>& getPriority() { return settings.priority; }
+
+	// Choose the degradations of a frame with this many trackables.
+	// Returns the flags of the degradations to apply.
+	// (Only call this from one thread, in order of the frames.)
+	uint32_t beginFrame(size_t nTrackables);
+	// Record the cost of a stage for a frame processed with these degradations.
+	// (Each stage must only be recorded from one thread.)
+	void recordStage(size_t stage, uint64_t micros, size_t nIn, size_t nTrackables, uint32_t degradations);
+
+	// Project the cost of a frame at a level of degradation (microseconds)
+	double project(size_t nTrackables, int level);
+	// Current level (the number of degradations applied, in order of priority)
+	int getLevel() { return level; }
+	int getMaxLevel() { return int(settings.priority.size()); }
+	uint32_t getFlags() { return flags; }
+	// Cost projected for the last frame at its level
+	double getProjectedMicros() { return projectedMicros; }
+	// Number of frames processed with degradations
+	uint64_t getNumDegradedFrames() { return nDegradedFrames; }
+
+private:
+
+	Settings settings;
+	atomic<uint64_t> frameMicros = 0;
+	atomic<int> hungarianMaxSamples = 32;
+	vector<StageInfo> stages;
+	int nSegments = 1;
+
+	// Measurements of each stage (updated by the stage's thread)
+	struct StageModel {
+		atomic<double> coefficient = 0;
+		atomic<double> inputRatio = 1;
+		atomic<bool> bMeasured = false;
+	};
+	vector< unique_ptr<StageModel> > models;
+
+	// Flags of the first (level) degradations
+	uint32_t getFlags(int level);
+
+	atomic<int> level = 0;
+	atomic<uint32_t> flags = DEGRADE_NONE;
+	atomic<double> projectedMicros = 0;
+	atomic<uint64_t> nDegradedFrames = 0;
+	int nRecoverFrames = 0;
+};
@@ -0,0 +1,157 @@
+#include "ofxRTLSFramePacer.h"
+
+// --------------------------------------------------------------
+ofxRTLSFramePacer::ofxRTLSFramePacer() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSFramePacer::~ofxRTLSFramePacer() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFramePacer::setDesiredFPS(float fps) {
+
+	if (fps == desiredFPS) return;
+	desiredFPS = fps;
+	flagRateChanged = true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFramePacer::reset() {
+	flagReset = true;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSFramePacer::waitForNextFrame() {
+
+	float fps = desiredFPS;
+	if (fps <= 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		flagReset = true;
+		return false;
+	}
+
+	Clock::time_point now = Clock::now();
+
+	// The first frame after a reset is due immediately
+	if (flagReset) {
+		flagReset = false;
+		flagRateChanged = false;
+		periodNS = 1.0E9 / double(fps);
+		anchor = now;
+		frameIndex = 0;
+		windowStart = now;
+		windowFrames = 0;
+		jitterCount = 0;
+		jitterSum = jitterSumSq = jitterMax = 0;
+		lastDeadline = now;
+		recordFrame(now, now);
+		return true;
+	}
+
+	// When the rate changes, re-anchor at the last deadline so the next
+	// deadline is one new period after it.
+	if (flagRateChanged) {
+		flagRateChanged = false;
+		anchor += std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double, std::nano>(double(frameIndex) * periodNS));
+		frameIndex = 0;
+		periodNS = 1.0E9 / double(fps);
+	}
+
+	frameIndex++;
+	Clock::time_point deadline = anchor + std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double, std::nano>(double(frameIndex) * periodNS));
+
+	// If we have fallen too far behind, re-anchor now rather than
+	// releasing a burst of frames.
+	if (now - deadline > std::chrono::duration<double, std::nano>(double(maxLagFrames) * periodNS)) {
+		anchor = now;
+		frameIndex = 0;
+		nReanchors++;
+		lastDeadline = now;
+		recordFrame(deadline, now);
+		return true;
+	}
+
+	// Sleep until shortly before the deadline...
+	Clock::duration margin = getSpinMargin();
+	if (deadline - now > margin) {
+		Clock::time_point target = deadline - margin;
+		std::this_thread::sleep_until(target);
+		// Learn how much the OS oversleeps
+		double oversleep = std::chrono::duration<double, std::nano>(Clock::now() - target).count();
+		oversleepNS = 0.9 * oversleepNS + 0.1 * MAX(oversleep, 0.0);
+	}
+	// ... then spin for the remainder.
+	while ((now = Clock::now()) < deadline) {
+		std::this_thread::yield();
+	}
+
+	lastDeadline = deadline;
+	recordFrame(deadline, now);
+	return true;
+}
+
+// --------------------------------------------------------------
+uint64_t ofxRTLSFramePacer::getLastDeadlineMicros() {
+
+	return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(lastDeadline.time_since_epoch()).count());
+}
+
+// --------------------------------------------------------------
+ofxRTLSFramePacer::Clock::duration ofxRTLSFramePacer::getSpinMargin() {
+
+	// Spin long enough to absorb a typical oversleep, but never for
+	// the whole frame.
+	double marginNS = MIN(MAX(1.5 * oversleepNS, minSpinMarginNS), 0.5 * periodNS);
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::nano>(marginNS));
+}
+
+// --------------------------------------------------------------
+void ofxRTLSFramePacer::recordFrame(Clock::time_point deadline, Clock::time_point wakeup) {
+
+	nFrames++;
+	windowFrames++;
+	jitterCount++;
+	double jitterUS = std::chrono::duration<double, std::micro>(wakeup - deadline).count();
+	jitterSum += jitterUS;
+	jitterSumSq += jitterUS * jitterUS;
+	jitterMax = MAX(jitterMax, jitterUS);
+
+	// Publish statistics once the window is complete
+	double elapsedNS = std::chrono::duration<double, std::nano>(wakeup - windowStart).count();
+	if (elapsedNS < statsWindowNS) return;
+
+	Stats s;
+	// The first frame of the window opens it, so it doesn't count 
+	// towards the rate.
+	s.achievedFPS = double(windowFrames - 1) * 1.0E9 / elapsedNS;
+	s.jitterMeanUS = jitterSum / double(jitterCount);
+	s.jitterStdUS = sqrt(MAX(jitterSumSq / double(jitterCount) - s.jitterMeanUS * s.jitterMeanUS, 0.0));
+	s.jitterMaxUS = jitterMax;
+	s.spinMarginUS = std::chrono::duration<double, std::micro>(getSpinMargin()).count();
+	s.nFrames = nFrames;
+	s.nReanchors = nReanchors;
+	{
+		std::lock_guard<std::mutex> lk(statsMutex);
+		stats = s;
+	}
+
+	// This frame opens the next window
+	windowStart = wakeup;
+	windowFrames = 1;
+	jitterCount = 0;
+	jitterSum = jitterSumSq = jitterMax = 0;
+}
+
+// --------------------------------------------------------------
+ofxRTLSFramePacer::Stats ofxRTLSFramePacer::getStats() {
+
+	std::lock_guard<std::mutex> lk(statsMutex);
+	return stats;
+}
+
+// --------------------------------------------------------------
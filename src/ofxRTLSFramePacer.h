@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Paces a loop at a desired frame rate.
+//
+// Deadlines are absolute times on a monotonic clock, measured from an anchor,
+// so rounding errors and late wakeups never accumulate into drift. The thread
+// sleeps until shortly before each deadline and then spins for the remainder,
+// since sleeping alone is only accurate to the OS scheduler's granularity.
+// The spin margin adapts to how much the OS has been oversleeping. If the 
+// loop falls more than a few frames behind, the pacer re-anchors instead of 
+// sending a burst of frames to catch up.
+//
+// The achieved rate and jitter (the lateness of each wakeup relative to its
+// deadline) are measured over windows of about a second.
+class ofxRTLSFramePacer {
+public:
+
+	ofxRTLSFramePacer();
+	~ofxRTLSFramePacer();
+
+	// Set the desired frame rate. This can be called from any thread.
+	void setDesiredFPS(float fps);
+	float getDesiredFPS() { return desiredFPS; }
+
+	// Re-anchor the deadlines at the next call to waitForNextFrame().
+	void reset();
+
+	// Block until the next frame is due. The first frame after a reset is
+	// due immediately. Returns false if the desired frame rate is invalid, 
+	// in which case no frame is due (but this will block briefly).
+	bool waitForNextFrame();
+
+	// Get the deadline of the frame most recently released, in microseconds
+	// of the monotonic clock (whose epoch is unspecified). Frames are 
+	// nominally produced at their deadlines.
+	uint64_t getLastDeadlineMicros();
+
+	// How many frames behind can the loop fall before re-anchoring?
+	void setMaxLagFrames(int frames) { maxLagFrames = MAX(frames, 1); }
+
+	struct Stats {
+		// Rate at which frames were released (Hz)
+		double achievedFPS = 0;
+		// Lateness of wakeups relative to their deadlines (microseconds)
+		double jitterMeanUS = 0;
+		double jitterStdUS = 0;
+		double jitterMaxUS = 0;
+		// Current margin before each deadline during which we spin (microseconds)
+		double spinMarginUS = 0;
+		// Total number of frames released and times the pacer has re-anchored
+		// after falling behind
+		uint64_t nFrames = 0;
+		uint64_t nReanchors = 0;
+	};
+	// Get the statistics of the most recently completed window.
+	// This can be called from any thread.
+	Stats getStats();
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	atomic<float> desiredFPS = 30;
+	atomic<bool> flagReset = true;
+	atomic<bool> flagRateChanged = false;
+
+	// Deadline n is (anchor + n * period)
+	Clock::time_point anchor;
+	uint64_t frameIndex = 0;
+	Clock::time_point lastDeadline;
+	double periodNS = 1.0E9 / 30.0;
+	int maxLagFrames = 4;
+
+	// Expected oversleep of the OS (ns), and the resulting spin margin
+	double oversleepNS = 1.0E6;
+	double minSpinMarginNS = 2.0E5;
+	Clock::duration getSpinMargin();
+
+	// Statistics of the current window
+	Clock::time_point windowStart;
+	uint64_t windowFrames = 0;
+	uint64_t jitterCount = 0;
+	double jitterSum = 0;
+	double jitterSumSq = 0;
+	double jitterMax = 0;
+	void recordFrame(Clock::time_point deadline, Clock::time_point wakeup);
+	double statsWindowNS = 1.0E9;
+
+	std::mutex statsMutex;
+	Stats stats;
+	uint64_t nFrames = 0;
+	uint64_t nReanchors = 0;
+};
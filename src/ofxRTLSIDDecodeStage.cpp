@@ -0,0 +1,204 @@
+#include "ofxRTLSIDDecodeStage.h"
+
+// --------------------------------------------------------------
+ofxRTLSIDDecodeStage::ofxRTLSIDDecodeStage() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSIDDecodeStage::~ofxRTLSIDDecodeStage() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIDDecodeStage::setup(const ofJson& settings) {
+
+	modelPath = settings.value("modelPath", modelPath);
+	window = MAX(settings.value("window", window), 1);
+	idOffset = settings.value("idOffset", idOffset);
+	minConfidence = settings.value("minConfidence", minConfidence);
+	recheckFrames = MAX(settings.value("recheckFrames", recheckFrames), 1);
+	brightnessKey = settings.value("brightnessKey", brightnessKey);
+	bParallel = settings.value("parallel", bParallel);
+
+	inputShape.clear();
+	if (settings.find("inputShape") != settings.end() && settings["inputShape"].is_array()) {
+		for (auto& dim : settings["inputShape"]) inputShape.push_back(dim.get<size_t>());
+	}
+	size_t inputSize = 1;
+	for (auto dim : inputShape) inputSize *= dim;
+	if (inputShape.empty() || inputShape.size() > 2 || inputSize != window) {
+		if (!inputShape.empty()) {
+			ofLogError("ofxRTLSIDDecodeStage") << "The input shape of stage " << getName() << " must have one or two dimensions and hold " << window << " samples.";
+		}
+		inputShape = { size_t(window) };
+	}
+
+	ids.clear();
+	if (settings.find("ids") != settings.end() && settings["ids"].is_array()) {
+		for (auto& ID : settings["ids"]) ids.push_back(ID.get<int>());
+	}
+
+	if (settings.find("keyTypes") != settings.end() && settings["keyTypes"].is_string()) {
+		keyTypes.clear();
+		for (auto& s : ofSplitString(settings["keyTypes"].get<string>(), ",", true, true)) {
+			for (int i = 0; i < NUM_KEYS; i++) {
+				if (s == getTrackableKeyTypeDescription(TrackableKeyType(i))) keyTypes.insert(TrackableKeyType(i));
+			}
+		}
+	}
+	// Tracks without keys cannot be followed across frames
+	keyTypes.erase(KEY_NONE);
+
+	// Load the model
+	model.reset();
+	if (modelPath.empty()) {
+		ofLogError("ofxRTLSIDDecodeStage") << "Stage " << getName() << " has no model path.";
+		return;
+	}
+	try {
+		model.reset(new fdeep::model(fdeep::load_model(ofToDataPath(modelPath, true), false)));
+	}
+	catch (const std::exception& e) {
+		ofLogError("ofxRTLSIDDecodeStage") << "Stage " << getName() << " cannot load the model \"" << modelPath << "\": " << e.what();
+	}
+
+	reset();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIDDecodeStage::reset() {
+
+	tracks.clear();
+	frameIndex = 0;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIDDecodeStage::process(ofxRTLSWorkingSet& ws, const Context& /*context*/) {
+
+	if (!model) return;
+	frameIndex++;
+
+	// Add a sample to the tracks in this frame
+	for (size_t i = 0; i < ws.size(); i++) {
+		if (ws.isRemoved(i)) continue;
+		if (keyTypes.find(ws.getKeyType(i)) == keyTypes.end()) continue;
+
+		Track& track = tracks[ws.getKey(i)];
+		if (track.samples.empty()) track.samples.resize(window, 0.0);
+		addSample(track, getSample(ws, i));
+		track.lastSeenFrame = frameIndex;
+		track.row = i;
+	}
+
+	// Tracks that were not seen are off (or occluded). Tracks that have not
+	// been seen for a whole window are forgotten.
+	pending.clear();
+	for (auto it = tracks.begin(); it != tracks.end(); ) {
+		Track& track = it->second;
+		if (track.lastSeenFrame != frameIndex) {
+			if (frameIndex - track.lastSeenFrame >= window) {
+				it = tracks.erase(it);
+				continue;
+			}
+			addSample(track, 0.0);
+		}
+		else if (track.nSamples >= window &&
+			(track.ID == 0 || frameIndex - track.lastDecodeFrame >= recheckFrames)) {
+			pending.push_back(&track);
+		}
+		it++;
+	}
+
+	// Decode all pending tracks at once
+	if (!pending.empty()) {
+		batch.resize(pending.size() * window);
+		for (size_t k = 0; k < pending.size(); k++) {
+			Track& track = *pending[k];
+			float* dst = &batch[k * window];
+			// Unroll the ring buffer from oldest to newest
+			for (int j = 0; j < window; j++) dst[j] = track.samples[(track.head + j) % window];
+		}
+
+		vector<int> classes;
+		vector<float> confidences;
+		if (decode(batch, pending.size(), classes, confidences)) {
+			for (size_t k = 0; k < pending.size(); k++) {
+				Track& track = *pending[k];
+				track.lastDecodeFrame = frameIndex;
+				track.confidence = confidences[k];
+				int ID = 0;
+				if (confidences[k] >= minConfidence && classes[k] >= 0) {
+					ID = classes[k] < ids.size() ? ids[classes[k]] : classes[k] + idOffset;
+				}
+				if (track.ID != 0 && ID == 0) count("lost");
+				track.ID = MAX(ID, 0);
+			}
+			count("decoded", pending.size());
+			count("batches");
+		}
+	}
+
+	// Apply the cached IDs
+	for (auto& it : tracks) {
+		Track& track = it.second;
+		if (track.lastSeenFrame != frameIndex || track.ID == 0) continue;
+		ws.setKey(track.row, getTrackableKey(KEY_ID, ofToString(track.ID)));
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIDDecodeStage::addSample(Track& track, float sample) {
+
+	// Overwrite the oldest sample
+	int tail = (track.head + track.nSamples) % window;
+	track.samples[tail] = sample;
+	if (track.nSamples < window) track.nSamples++;
+	else track.head = (track.head + 1) % window;
+}
+
+// --------------------------------------------------------------
+float ofxRTLSIDDecodeStage::getSample(ofxRTLSWorkingSet& ws, size_t row) {
+
+	float brightness = 1.0;
+	getContextValue(ws.getSource(row), brightnessKey, brightness);
+	return brightness;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSIDDecodeStage::decode(const vector<float>& _batch, size_t nWindows,
+	vector<int>& classes, vector<float>& confidences) {
+
+	fdeep::tensor_shape shape = inputShape.size() == 1 ?
+		fdeep::tensor_shape(inputShape[0]) : fdeep::tensor_shape(inputShape[0], inputShape[1]);
+
+	// frugally-deep models have no batch dimension, so each window of
+	// the batch is one set of inputs to the same call.
+	vector<fdeep::tensors> inputs;
+	inputs.reserve(nWindows);
+	for (size_t k = 0; k < nWindows; k++) {
+		fdeep::float_vec values(_batch.begin() + k * window, _batch.begin() + (k + 1) * window);
+		inputs.push_back({ fdeep::tensor(shape, std::move(values)) });
+	}
+
+	vector<fdeep::tensors> outputs;
+	try {
+		outputs = model->predict_multi(inputs, bParallel);
+	}
+	catch (const std::exception& e) {
+		ofLogError("ofxRTLSIDDecodeStage") << "Stage " << getName() << " cannot decode: " << e.what();
+		return false;
+	}
+
+	classes.assign(nWindows, -1);
+	confidences.assign(nWindows, 0.0);
+	for (size_t k = 0; k < outputs.size() && k < nWindows; k++) {
+		if (outputs[k].empty()) continue;
+		const fdeep::float_vec probabilities = outputs[k][0].to_vector();
+		if (probabilities.empty()) continue;
+		auto best = max_element(probabilities.begin(), probabilities.end());
+		classes[k] = int(best - probabilities.begin());
+		confidences[k] = *best;
+	}
+	return true;
+}
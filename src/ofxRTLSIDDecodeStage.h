@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxFDeep.h"
+#include "ofxRTLSPostprocessStage.h"
+
+// Identifies active markers by decoding the bit sequences they blink.
+//
+// Each track (by its key) keeps a ring buffer of its most recent samples. A
+// sample is the trackable's brightness, if its context contains one (e.g.
+// {"b":0.8}), and otherwise its presence: 1 if it was seen in a frame and 0
+// if it was not. Once a track has a full window of samples, the window is
+// decoded by a frugally-deep model, which outputs a probability for each class
+// of ID. Decoded IDs are cached and applied to their tracks until the
+// confidence of a later decoding falls below the minimum. Cached tracks are
+// only decoded again every few frames.
+// All tracks pending decoding in a frame are gathered into one batch, which
+// is run through the model in a single call.
+//
+// This stage should follow the Hungarian stage, so tracks keep their keys
+// from frame to frame. Stage settings (see ofxRTLSPostprocessStage):
+//	"modelPath"		path to the model's json (required)
+//	"window"		number of samples decoded (default 32)
+//	"inputShape"	shape of the model's input, e.g. [32] or [32, 1] (defaults
+//					to [window])
+//	"ids"			ID of each class (defaults to the class index + "idOffset")
+//	"idOffset"		(default 1, since IDs must be positive)
+//	"minConfidence"	minimum probability of a decoded class (default 0.9)
+//	"recheckFrames"	frames between decoding cached tracks (default 30)
+//	"keyTypes"		key types of the tracks decoded (default "cuid")
+//	"brightnessKey"	key of the brightness in the trackable context (default "b")
+//	"parallel"		decode the batch on multiple threads (default false)
+class ofxRTLSIDDecodeStage : public ofxRTLSPostprocessStage {
+public:
+
+	ofxRTLSIDDecodeStage();
+	~ofxRTLSIDDecodeStage();
+
+	void setup(const ofJson& settings);
+	void process(ofxRTLSWorkingSet& ws, const Context& context);
+	void reset();
+	bool replacesKeys() { return true; }
+
+	bool isModelLoaded() { return model != nullptr; }
+	size_t getNumTracks() { return tracks.size(); }
+
+private:
+
+	string modelPath = "";
+	int window = 32;
+	vector<size_t> inputShape;
+	vector<int> ids;
+	int idOffset = 1;
+	float minConfidence = 0.9;
+	int recheckFrames = 30;
+	set<TrackableKeyType> keyTypes = { KEY_CUID };
+	string brightnessKey = "b";
+	bool bParallel = false;
+
+	unique_ptr<fdeep::model> model;
+
+	struct Track {
+		// Ring buffer of samples (the oldest sample is at head)
+		vector<float> samples;
+		int head = 0;
+		int nSamples = 0;
+		uint64_t lastSeenFrame = 0;
+		// Row of the track in the current frame
+		size_t row = 0;
+		// Cached ID (0 if none)
+		int ID = 0;
+		float confidence = 0;
+		uint64_t lastDecodeFrame = 0;
+	};
+	unordered_map<string, Track> tracks;
+	uint64_t frameIndex = 0;
+
+	void addSample(Track& track, float sample);
+	// Get the brightness of a trackable, or its presence if it has none
+	float getSample(ofxRTLSWorkingSet& ws, size_t row);
+
+	// Decode a batch of windows. For each window, output the index of the
+	// most probable class and its probability.
+	bool decode(const vector<float>& batch, size_t nWindows, vector<int>& classes, vector<float>& confidences);
+	vector<float> batch;
+	vector<Track*> pending;
+};
@@ -0,0 +1,108 @@
+#include "ofxRTLSIdentityInterner.h"
+
+// --------------------------------------------------------------
+ofxRTLSIdentityInterner::ofxRTLSIdentityInterner() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSIdentityInterner::~ofxRTLSIdentityInterner() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSIdentityInterner::Handle ofxRTLSIdentityInterner::internCuid(uint64_t low, uint64_t high) {
+
+	return intern({ low, high, CUID });
+}
+
+// --------------------------------------------------------------
+ofxRTLSIdentityInterner::Handle ofxRTLSIdentityInterner::internSerial(uint64_t serial) {
+
+	return intern({ serial, 0, SERIAL });
+}
+
+// --------------------------------------------------------------
+ofxRTLSIdentityInterner::Handle ofxRTLSIdentityInterner::intern(const Key& key) {
+
+	auto it = handles.find(key);
+	if (it != handles.end()) return it->second;
+
+	reserveEntry();
+	Handle handle = Handle(entries.size());
+	Entry entry;
+	entry.kind = key.kind;
+	entry.low = key.low;
+	entry.high = key.high;
+	entries.push_back(entry);
+	handles[key] = handle;
+	return handle;
+}
+
+// --------------------------------------------------------------
+ofxRTLSIdentityInterner::Handle ofxRTLSIdentityInterner::internName(size_t slot, const string& name) {
+
+	// Most slots report the same name every frame
+	if (slot < slots.size() && slots[slot] >= 0 && entries[slots[slot]].str == name) {
+		return Handle(slots[slot]);
+	}
+
+	Handle handle;
+	auto it = names.find(name);
+	if (it != names.end()) {
+		handle = it->second;
+	}
+	else {
+		reserveEntry();
+		handle = Handle(entries.size());
+		Entry entry;
+		entry.kind = NAME;
+		entry.str = name;
+		entry.bFormatted = true;
+		entries.push_back(entry);
+		names[name] = handle;
+	}
+
+	if (slot >= slots.size()) slots.resize(slot + 1, -1);
+	slots[slot] = handle;
+	return handle;
+}
+
+// --------------------------------------------------------------
+const string& ofxRTLSIdentityInterner::getString(Handle handle) {
+
+	Entry& entry = entries[handle];
+	if (entry.bFormatted) return entry.str;
+
+	// Format this identity the first time it is needed
+	switch (entry.kind) {
+	case CUID: {
+		entry.str = std::to_string(entry.low) + "-" + std::to_string(entry.high);
+	}; break;
+	case SERIAL: {
+		entry.str = std::to_string(entry.low);
+	}; break;
+	case NAME: default: break;
+	}
+	entry.bFormatted = true;
+	return entry.str;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityInterner::reserveEntry() {
+
+	if (entries.size() < maxEntries) return;
+
+	ofLogVerbose("ofxRTLSIdentityInterner") << "Interned " << entries.size() << " identities. Clearing them to make room for more.";
+	clear();
+	nOverflows++;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityInterner::clear() {
+
+	entries.clear();
+	handles.clear();
+	names.clear();
+	slots.clear();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Maps the binary identities reported by a system (e.g. Motive's 128-bit
+// cuids, camera serial numbers or OpenVR serial numbers) to compact handles.
+// Each identity is stored once, and its string form (as set in a trackable's
+// cuid or name) is only formatted the first time it is requested, so
+// ingesting a frame of known identities does no string formatting.
+// Notes:
+// -	An interner is not thread-safe. Each source owns one, which is only
+//		used on the thread that receives its data.
+// -	Systems may report new identities indefinitely (e.g. unlabeled
+//		markers), so the interner is cleared once it holds maxEntries
+//		identities. Handles are only valid until the next identity is
+//		interned, so they should be resolved right away.
+class ofxRTLSIdentityInterner {
+public:
+
+	ofxRTLSIdentityInterner();
+	~ofxRTLSIdentityInterner();
+
+	typedef uint32_t Handle;
+
+	// Get the handle of a 128-bit cuid. Its string is
+	// "[low bits as uint64_t]-[high bits as uint64_t]".
+	Handle internCuid(uint64_t low, uint64_t high);
+	// Get the handle of a 64-bit serial number. Its string is the number.
+	Handle internSerial(uint64_t serial);
+	// Get the handle of a name reported in a slot (e.g. the index of a
+	// device). While a slot keeps reporting the same name, the name is
+	// only compared with the last one, not hashed.
+	Handle internName(size_t slot, const string& name);
+
+	// Get the string form of an identity
+	const string& getString(Handle handle);
+
+	size_t size() { return entries.size(); }
+	void clear();
+
+	void setMaxEntries(size_t _maxEntries) { maxEntries = MAX(_maxEntries, size_t(1)); }
+	size_t getMaxEntries() { return maxEntries; }
+	// Number of times the interner has been cleared because it was full
+	uint64_t getNumOverflows() { return nOverflows; }
+
+private:
+
+	enum Kind : uint8_t {
+		CUID = 0,
+		SERIAL,
+		NAME
+	};
+	struct Entry {
+		Kind kind = CUID;
+		uint64_t low = 0;
+		uint64_t high = 0;
+		string str = "";
+		bool bFormatted = false;
+	};
+	vector<Entry> entries;
+
+	// Binary identities and their handles
+	struct Key {
+		uint64_t low;
+		uint64_t high;
+		Kind kind;
+		bool operator==(const Key& other) const {
+			return low == other.low && high == other.high && kind == other.kind;
+		}
+	};
+	struct KeyHash {
+		size_t operator()(const Key& key) const {
+			uint64_t h = key.low * 0x9E3779B97F4A7C15ULL;
+			h ^= (key.high + uint64_t(key.kind)) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+			return size_t(h);
+		}
+	};
+	unordered_map<Key, Handle, KeyHash> handles;
+	// Names and their handles, and the last handle of each slot
+	unordered_map<string, Handle> names;
+	vector<int64_t> slots;
+
+	Handle intern(const Key& key);
+	// Make room for a new identity
+	void reserveEntry();
+
+	size_t maxEntries = 1 << 16;
+	uint64_t nOverflows = 0;
+};
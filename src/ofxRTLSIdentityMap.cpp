@@ -0,0 +1,256 @@
+#include "ofxRTLSIdentityMap.h"
+
+// --------------------------------------------------------------
+ofxRTLSIdentityMap::ofxRTLSIdentityMap() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSIdentityMap::~ofxRTLSIdentityMap() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityMap::setHorizon(uint64_t _horizonMS, uint64_t _horizonFrames) {
+	horizonMS = _horizonMS;
+	horizonFrames = _horizonFrames;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityMap::beginFrame(uint64_t timeMS) {
+
+	nowMS = timeMS;
+	nowFrame++;
+
+	// Time may jump backwards (e.g. when a take loops)
+	if (nowMS < lastEvictionMS) lastEvictionMS = nowMS;
+
+	// Evict each second or every 256 frames, whichever comes first
+	if (nowMS - lastEvictionMS >= 1000 || nowFrame - lastEvictionFrame >= 256) {
+		evict();
+	}
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSIdentityMap::resolve(const string& key, string& identityKey) {
+
+	auto it = index.find(key);
+	if (it == index.end()) return false;
+	uint32_t root = find(it->second);
+	touch(it->second, root);
+	if (root == it->second) return false;
+	identityKey = nodes[root].key;
+	return true;
+}
+
+// --------------------------------------------------------------
+string ofxRTLSIdentityMap::getIdentity(const string& key) {
+
+	auto it = index.find(key);
+	if (it == index.end()) return key;
+	return nodes[find(it->second)].key;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityMap::link(const string& key, const string& otherKey) {
+
+	uint32_t n = getNode(key);
+	uint32_t other = find(getNode(otherKey));
+	if (find(n) == other) return;
+
+	// Point this key's node to the other identity. (If this key is an 
+	// identity, the keys mapped to it follow.)
+	if (nodes[n].parent == n) nMappings++;
+	nodes[n].parent = other;
+	touch(n, other);
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSIdentityMap::isMapped(const string& key) {
+
+	auto it = index.find(key);
+	if (it == index.end()) return false;
+	return find(it->second) != it->second;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityMap::evict() {
+
+	lastEvictionMS = nowMS;
+	lastEvictionFrame = nowFrame;
+	if (horizonMS == 0 && horizonFrames == 0) return;
+
+	// Point every key directly to its identity, so keys can be freed 
+	// without breaking the paths of others
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i].bUsed) find(i);
+	}
+
+	// Free the keys of expired identities, and keys that have expired
+	// themselves (identities remain while any of their keys are seen)
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		if (!nodes[i].bUsed) continue;
+		uint32_t root = nodes[i].parent;
+		bool bExpired = isExpired(nodes[root].identitySeenMS, nodes[root].identitySeenFrame);
+		if (root != i) bExpired |= isExpired(nodes[i].seenMS, nodes[i].seenFrame);
+		if (!bExpired) continue;
+		if (root != i) nMappings--;
+		index.erase(nodes[i].key);
+		nodes[i] = Node();
+		freeNodes.push_back(i);
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityMap::clear() {
+
+	nodes.clear();
+	freeNodes.clear();
+	index.clear();
+	nMappings = 0;
+	nowFrame = 0;
+	lastEvictionMS = nowMS;
+	lastEvictionFrame = 0;
+}
+
+// --------------------------------------------------------------
+string ofxRTLSIdentityMap::serialize() {
+
+	// [now ms][now frame][number of keys]
+	// then for each key: [key][identity key][key seen ms][key seen frame]
+	// [identity seen ms][identity seen frame]
+	// Strings are preceded by their length.
+	string out;
+	auto writeU64 = [&out](uint64_t value) {
+		out.append((const char*)&value, sizeof(value));
+	};
+	auto writeString = [&](const string& str) {
+		writeU64(str.size());
+		out.append(str);
+	};
+
+	writeU64(nowMS);
+	writeU64(nowFrame);
+	writeU64(index.size());
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		if (!nodes[i].bUsed) continue;
+		uint32_t root = find(i);
+		writeString(nodes[i].key);
+		writeString(nodes[root].key);
+		writeU64(nodes[i].seenMS);
+		writeU64(nodes[i].seenFrame);
+		writeU64(nodes[root].identitySeenMS);
+		writeU64(nodes[root].identitySeenFrame);
+	}
+	return out;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSIdentityMap::deserialize(const string& data) {
+
+	size_t pos = 0;
+	bool bValid = true;
+	auto readU64 = [&]() -> uint64_t {
+		uint64_t value = 0;
+		if (pos + sizeof(value) > data.size()) {
+			bValid = false;
+			return value;
+		}
+		memcpy(&value, data.data() + pos, sizeof(value));
+		pos += sizeof(value);
+		return value;
+	};
+	auto readString = [&]() -> string {
+		uint64_t size = readU64();
+		if (!bValid || size > data.size() - pos) {
+			bValid = false;
+			return "";
+		}
+		string str = data.substr(pos, size);
+		pos += size;
+		return str;
+	};
+
+	clear();
+	nowMS = readU64();
+	nowFrame = readU64();
+	uint64_t nKeys = readU64();
+	for (uint64_t i = 0; i < nKeys && bValid; i++) {
+		string key = readString();
+		string identityKey = readString();
+		uint64_t seenMS = readU64();
+		uint64_t seenFrame = readU64();
+		uint64_t identitySeenMS = readU64();
+		uint64_t identitySeenFrame = readU64();
+		if (!bValid) break;
+		uint32_t root = getNode(identityKey);
+		nodes[root].identitySeenMS = identitySeenMS;
+		nodes[root].identitySeenFrame = identitySeenFrame;
+		uint32_t n = getNode(key);
+		nodes[n].seenMS = seenMS;
+		nodes[n].seenFrame = seenFrame;
+		if (n != root && nodes[n].parent == n) {
+			nodes[n].parent = root;
+			nMappings++;
+		}
+	}
+	lastEvictionMS = nowMS;
+	lastEvictionFrame = nowFrame;
+	if (!bValid) clear();
+	return bValid;
+}
+
+// --------------------------------------------------------------
+uint32_t ofxRTLSIdentityMap::find(uint32_t i) {
+
+	uint32_t root = i;
+	while (nodes[root].parent != root) root = nodes[root].parent;
+	// Compress the path
+	while (nodes[i].parent != root) {
+		uint32_t next = nodes[i].parent;
+		nodes[i].parent = root;
+		i = next;
+	}
+	return root;
+}
+
+// --------------------------------------------------------------
+uint32_t ofxRTLSIdentityMap::getNode(const string& key) {
+
+	auto it = index.find(key);
+	if (it != index.end()) return it->second;
+
+	uint32_t i;
+	if (!freeNodes.empty()) {
+		i = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	else {
+		i = nodes.size();
+		nodes.push_back(Node());
+	}
+	nodes[i].key = key;
+	nodes[i].parent = i;
+	nodes[i].bUsed = true;
+	touch(i, i);
+	index[key] = i;
+	return i;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSIdentityMap::touch(uint32_t i, uint32_t root) {
+	nodes[i].seenMS = nowMS;
+	nodes[i].seenFrame = nowFrame;
+	nodes[root].identitySeenMS = nowMS;
+	nodes[root].identitySeenFrame = nowFrame;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSIdentityMap::isExpired(uint64_t seenMS, uint64_t seenFrame) {
+
+	if (horizonMS > 0 && nowMS > seenMS && nowMS - seenMS > horizonMS) return true;
+	if (horizonFrames > 0 && nowFrame > seenFrame && nowFrame - seenFrame > horizonFrames) return true;
+	return false;
+}
+
+// --------------------------------------------------------------
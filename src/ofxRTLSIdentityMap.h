@@ -0,0 +1,89 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Maps trackable keys onto the keys of the identities they belong to, as
+// found by the Hungarian algorithm (e.g. a new cuid that continues an 
+// existing track). Keys are interned into compact indices and stored as a 
+// union-find forest with path compression, so resolving a key takes 
+// amortized constant time, regardless of how many times its track has 
+// been remapped.
+//
+// Keys and identities remember when they were last seen. Identities that
+// have not been seen for longer than a horizon (in milliseconds and/or 
+// frames) are evicted with all of their keys, as are keys of live identities
+// that have not been seen themselves (e.g. cuids that were replaced), 
+// so the map stays bounded over long sessions.
+class ofxRTLSIdentityMap {
+public:
+
+	ofxRTLSIdentityMap();
+	~ofxRTLSIdentityMap();
+
+	// Set how long identities are kept after they were last seen.
+	// A horizon of 0 disables that criterion (0 for both never evicts).
+	void setHorizon(uint64_t horizonMS, uint64_t horizonFrames);
+
+	// Begin a new frame at a time (ms). Expired identities are periodically
+	// evicted here.
+	void beginFrame(uint64_t timeMS);
+
+	// Get the key of the identity a key belongs to. Returns true if the key
+	// is mapped to a different key. Known keys are marked as seen.
+	bool resolve(const string& key, string& identityKey);
+	// Get the key of the identity a key belongs to (the key itself if it
+	// is not mapped).
+	string getIdentity(const string& key);
+
+	// Map a key onto the identity of another key
+	void link(const string& key, const string& otherKey);
+
+	// Is this key mapped to a different key?
+	bool isMapped(const string& key);
+	// Number of keys mapped to a different key
+	size_t getNumMappings() { return nMappings; }
+	// Number of keys stored (including the keys of identities)
+	size_t getNumKeys() { return index.size(); }
+
+	// Evict all identities that have expired
+	void evict();
+
+	void clear();
+
+	// Save and restore the whole map (including the times keys were seen)
+	string serialize();
+	bool deserialize(const string& data);
+
+private:
+
+	struct Node {
+		string key = "";
+		uint32_t parent = 0;
+		// When this key was last seen
+		uint64_t seenMS = 0;
+		uint64_t seenFrame = 0;
+		// When any key of this identity was last seen (only valid for roots)
+		uint64_t identitySeenMS = 0;
+		uint64_t identitySeenFrame = 0;
+		bool bUsed = false;
+	};
+	vector<Node> nodes;
+	vector<uint32_t> freeNodes;
+	unordered_map<string, uint32_t> index;
+	size_t nMappings = 0;
+
+	uint64_t horizonMS = 0;
+	uint64_t horizonFrames = 0;
+	uint64_t nowMS = 0;
+	uint64_t nowFrame = 0;
+	uint64_t lastEvictionMS = 0;
+	uint64_t lastEvictionFrame = 0;
+
+	// Find the root of a node, compressing the path to it
+	uint32_t find(uint32_t i);
+	// Get the node of a key, creating it if necessary
+	uint32_t getNode(const string& key);
+	// Mark a key (and its identity) as seen
+	void touch(uint32_t i, uint32_t root);
+	bool isExpired(uint64_t seenMS, uint64_t seenFrame);
+};
@@ -0,0 +1,194 @@
+#include "ofxRTLSLostTrackIndex.h"
+
+// --------------------------------------------------------------
+ofxRTLSLostTrackIndex::ofxRTLSLostTrackIndex() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSLostTrackIndex::~ofxRTLSLostTrackIndex() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSLostTrackIndex::add(const LostTrack& track) {
+
+	auto it = byKey.find(track.key);
+	if (it != byKey.end()) {
+		tracks[it->second] = track;
+		return;
+	}
+	byKey[track.key] = tracks.size();
+	tracks.push_back(track);
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSLostTrackIndex::remove(const string& key) {
+
+	auto it = byKey.find(key);
+	if (it == byKey.end()) return false;
+	removeAt(it->second);
+	return true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSLostTrackIndex::removeAt(size_t index) {
+
+	// Swap with the last track and remove it
+	byKey.erase(tracks[index].key);
+	if (index != tracks.size() - 1) {
+		tracks[index] = std::move(tracks.back());
+		byKey[tracks[index].key] = index;
+	}
+	tracks.pop_back();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSLostTrackIndex::expire(uint64_t nowMS, uint64_t nowFrame, uint64_t maxAgeMS, uint64_t maxAgeFrames) {
+
+	size_t i = 0;
+	while (i < tracks.size()) {
+		bool bExpired = false;
+		if (maxAgeMS > 0 && nowMS > tracks[i].timeMS && nowMS - tracks[i].timeMS > maxAgeMS) bExpired = true;
+		if (maxAgeFrames > 0 && nowFrame > tracks[i].frame && nowFrame - tracks[i].frame > maxAgeFrames) bExpired = true;
+		if (bExpired) removeAt(i);
+		else i++;
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSLostTrackIndex::match(const vector<glm::vec3>& detections, float radius, uint64_t nowMS,
+	float maxPredictionSec, vector<int>& matches) {
+
+	matches.assign(detections.size(), -1);
+	if (tracks.empty() || detections.empty() || radius <= 0) return;
+
+	// Index the predicted position of every lost track. Cells are as 
+	// wide as the radius, so matches lie in neighboring cells.
+	for (auto& it : cells) it.second.clear();
+	vector<glm::vec3> predicted(tracks.size());
+	for (uint32_t i = 0; i < tracks.size(); i++) {
+		float dt = nowMS > tracks[i].timeMS ? float(nowMS - tracks[i].timeMS) / 1000.0f : 0.0f;
+		dt = MIN(dt, MAX(maxPredictionSec, 0.0f));
+		predicted[i] = tracks[i].position + tracks[i].velocity * dt;
+		cells[getCellKey(predicted[i], radius, 0, 0, 0)].push_back(i);
+	}
+
+	// Collect candidate pairs within the radius
+	struct Candidate {
+		float distance;
+		uint32_t detection;
+		uint32_t track;
+	};
+	vector<Candidate> candidates;
+	for (uint32_t d = 0; d < detections.size(); d++) {
+		for (int x = -1; x <= 1; x++) {
+			for (int y = -1; y <= 1; y++) {
+				for (int z = -1; z <= 1; z++) {
+					auto it = cells.find(getCellKey(detections[d], radius, x, y, z));
+					if (it == cells.end()) continue;
+					for (auto t : it->second) {
+						float distance = glm::distance(detections[d], predicted[t]);
+						if (distance <= radius) candidates.push_back({ distance, d, t });
+					}
+				}
+			}
+		}
+	}
+
+	// Assign the closest pairs first
+	sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+		return a.distance < b.distance;
+	});
+	vector<bool> bTrackMatched(tracks.size(), false);
+	for (auto& c : candidates) {
+		if (matches[c.detection] >= 0 || bTrackMatched[c.track]) continue;
+		matches[c.detection] = c.track;
+		bTrackMatched[c.track] = true;
+	}
+
+	// Don't let empty cells accumulate
+	if (cells.size() > 4 * tracks.size() + 64) cells.clear();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSLostTrackIndex::clear() {
+	tracks.clear();
+	byKey.clear();
+	cells.clear();
+}
+
+// --------------------------------------------------------------
+string ofxRTLSLostTrackIndex::serialize() {
+
+	// [number of tracks] then for each track:
+	// [key][position xyz][velocity xyz][time ms][frame]
+	string out;
+	auto writeU64 = [&out](uint64_t value) {
+		out.append((const char*)&value, sizeof(value));
+	};
+	auto writeVec3 = [&out](const glm::vec3& v) {
+		out.append((const char*)&v.x, sizeof(float) * 3);
+	};
+
+	writeU64(tracks.size());
+	for (auto& t : tracks) {
+		writeU64(t.key.size());
+		out.append(t.key);
+		writeVec3(t.position);
+		writeVec3(t.velocity);
+		writeU64(t.timeMS);
+		writeU64(t.frame);
+	}
+	return out;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSLostTrackIndex::deserialize(const string& data) {
+
+	size_t pos = 0;
+	bool bValid = true;
+	auto read = [&](void* dst, size_t size) {
+		if (!bValid || pos + size > data.size()) {
+			bValid = false;
+			return;
+		}
+		memcpy(dst, data.data() + pos, size);
+		pos += size;
+	};
+
+	clear();
+	uint64_t nTracks = 0;
+	read(&nTracks, sizeof(nTracks));
+	for (uint64_t i = 0; i < nTracks && bValid; i++) {
+		LostTrack t;
+		uint64_t size = 0;
+		read(&size, sizeof(size));
+		if (!bValid || size > data.size() - pos) {
+			bValid = false;
+			break;
+		}
+		t.key = data.substr(pos, size);
+		pos += size;
+		read(&t.position.x, sizeof(float) * 3);
+		read(&t.velocity.x, sizeof(float) * 3);
+		read(&t.timeMS, sizeof(t.timeMS));
+		read(&t.frame, sizeof(t.frame));
+		if (bValid) add(t);
+	}
+	if (!bValid) clear();
+	return bValid;
+}
+
+// --------------------------------------------------------------
+uint64_t ofxRTLSLostTrackIndex::getCellKey(const glm::vec3& p, float cellSize, int dx, int dy, int dz) {
+	int x = int(floor(p.x / cellSize)) + dx;
+	int y = int(floor(p.y / cellSize)) + dy;
+	int z = int(floor(p.z / cellSize)) + dz;
+	// Pack 21 bits of each coordinate
+	return (uint64_t(uint32_t(x) & 0x1FFFFF) << 42) |
+		(uint64_t(uint32_t(y) & 0x1FFFFF) << 21) |
+		uint64_t(uint32_t(z) & 0x1FFFFF);
+}
+
+// --------------------------------------------------------------
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Holds tracks that have recently vanished (their key, last position, 
+// velocity and the time they were last seen), so new detections that the
+// Hungarian algorithm could not match to the last frame can be matched to
+// tracks lost several frames ago. Lost tracks are indexed in a spatial hash
+// at their predicted positions, so each detection only compares against
+// nearby tracks.
+class ofxRTLSLostTrackIndex {
+public:
+
+	ofxRTLSLostTrackIndex();
+	~ofxRTLSLostTrackIndex();
+
+	struct LostTrack {
+		string key = "";
+		glm::vec3 position;
+		glm::vec3 velocity;	// units per second
+		uint64_t timeMS = 0;
+		uint64_t frame = 0;
+	};
+
+	// Add a track that was lost (replacing any with the same key)
+	void add(const LostTrack& track);
+	// Remove a track (e.g. when it reappears). Returns true if it was present.
+	bool remove(const string& key);
+	// Remove tracks lost longer than maxAgeMS or maxAgeFrames ago
+	// (0 disables either criterion)
+	void expire(uint64_t nowMS, uint64_t nowFrame, uint64_t maxAgeMS, uint64_t maxAgeFrames);
+
+	// Match detections to lost tracks whose predicted positions (extrapolated
+	// by at most maxPredictionSec) are within radius, closest pairs first. 
+	// Each detection is matched to at most one track and vice versa. 
+	// Matches contain the index of a lost track for each detection, or -1.
+	// Matched tracks are not removed.
+	void match(const vector<glm::vec3>& detections, float radius, uint64_t nowMS, 
+		float maxPredictionSec, vector<int>& matches);
+
+	const LostTrack& get(int index) { return tracks[index]; }
+	size_t size() { return tracks.size(); }
+	bool empty() { return tracks.empty(); }
+	void clear();
+
+	string serialize();
+	bool deserialize(const string& data);
+
+private:
+
+	vector<LostTrack> tracks;
+	unordered_map<string, size_t> byKey;
+	void removeAt(size_t index);
+
+	// Spatial hash of predicted positions (rebuilt for each match)
+	unordered_map<uint64_t, vector<uint32_t> > cells;
+	// Get the key of the cell containing a position, offset by a number of cells
+	uint64_t getCellKey(const glm::vec3& p, float cellSize, int dx, int dy, int dz);
+};
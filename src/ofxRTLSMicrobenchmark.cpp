@@ -0,0 +1,437 @@
+#include "ofxRTLSMicrobenchmark.h"
+#include "ofxRTLSTrackableKey.h"
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::ofxRTLSMicrobenchmark() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::~ofxRTLSMicrobenchmark() {
+
+}
+
+// --------------------------------------------------------------
+vector<string> ofxRTLSMicrobenchmark::getBenchmarks() {
+	return { "trackableKey", "reconcileKey", "workingSet", "mapIDs", "removeUnidentifiable", "hungarian",
+		"filters", "takeAdd", "takeUpdate", "takeSave", "playerGetFrames" };
+}
+
+// --------------------------------------------------------------
+vector<ofxRTLSMicrobenchmark::Result> ofxRTLSMicrobenchmark::run(string filter, function<void(const Result&)> callback) {
+
+	ofDirectory::createDirectory(tempFolder, true, true);
+
+	vector<Result> results;
+	for (auto& name : getBenchmarks()) {
+		if (!filter.empty() && name.find(filter) == string::npos) continue;
+
+		for (auto nMarkers : markerCounts) {
+			if (nMarkers <= 0) continue;
+			if (name == "hungarian" && nMarkers > maxHungarianMarkers) continue;
+
+			Result r;
+			if (name == "trackableKey") r = runTrackableKey(nMarkers);
+			else if (name == "reconcileKey") r = runReconcileKey(nMarkers);
+			else if (name == "workingSet") r = runWorkingSet(nMarkers);
+			else if (name == "mapIDs") r = runMapIDs(nMarkers);
+			else if (name == "removeUnidentifiable") r = runRemoveUnidentifiable(nMarkers);
+			else if (name == "hungarian") r = runHungarian(nMarkers);
+			else if (name == "filters") r = runFilters(nMarkers);
+			else if (name == "takeAdd") r = runTakeAdd(nMarkers);
+			else if (name == "takeUpdate") r = runTakeUpdate(nMarkers);
+			else if (name == "takeSave") r = runTakeSave(nMarkers);
+			else if (name == "playerGetFrames") r = runPlayerGetFrames(nMarkers);
+
+			results.push_back(r);
+			if (callback) callback(r);
+		}
+	}
+	return results;
+}
+
+// --------------------------------------------------------------
+vector<TrackableFrame> ofxRTLSMicrobenchmark::createFrames(int nMarkers, float idFraction, float cuidFraction) {
+
+	// Markers start at random positions and move with constant velocities
+	ofSeedRandom(nMarkers);
+	vector<glm::vec3> positions(nMarkers);
+	vector<glm::vec3> velocities(nMarkers);
+	for (int i = 0; i < nMarkers; i++) {
+		positions[i] = glm::vec3(ofRandom(1), ofRandom(1), ofRandom(1));
+		velocities[i] = glm::vec3(ofRandom(-1, 1), ofRandom(-1, 1), ofRandom(-1, 1)) * 0.001;
+	}
+	int nID = int(round(idFraction * nMarkers));
+	int nCuid = int(round(cuidFraction * nMarkers));
+
+	vector<TrackableFrame> frames(nInputFrames);
+	for (int f = 0; f < nInputFrames; f++) {
+		frames[f].set_timestamp(f);
+		for (int i = 0; i < nMarkers; i++) {
+			Trackable* trackable = frames[f].add_trackables();
+			if (i < nID) trackable->set_id(i + 1);
+			else if (i < nID + nCuid) trackable->set_cuid(ofToString(1000000 + i));
+			glm::vec3 p = positions[i] + velocities[i] * float(f);
+			Trackable::Position* position = trackable->mutable_position();
+			position->set_x(p.x);
+			position->set_y(p.y);
+			position->set_z(p.z);
+		}
+	}
+	return frames;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSMicrobenchmark::begin(Measurement& m) {
+	if (allocationCounter) m.startAllocs = allocationCounter();
+	m.start = std::chrono::steady_clock::now();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSMicrobenchmark::end(Measurement& m, uint64_t nFrames) {
+	auto stop = std::chrono::steady_clock::now();
+	if (allocationCounter) m.allocs += allocationCounter() - m.startAllocs;
+	m.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - m.start).count();
+	m.nFrames += nFrames;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSMicrobenchmark::isDone(Measurement& m, std::chrono::steady_clock::time_point startTime) {
+	// Run for the minimum duration and at least as many frames as there are inputs
+	if (m.nFrames < nInputFrames) return false;
+	float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+	return elapsed >= minDurationSec;
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::toResult(string name, int nMarkers, Measurement& m) {
+
+	Result r;
+	r.benchmark = name;
+	r.nMarkers = nMarkers;
+	r.nFrames = m.nFrames;
+	if (m.nFrames > 0) {
+		r.nsPerFrame = double(m.ns) / double(m.nFrames);
+		if (allocationCounter) r.allocsPerFrame = double(m.allocs) / double(m.nFrames);
+	}
+	return r;
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runTrackableKey(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 0.5, 0.5);
+
+	Measurement m;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		auto& frame = frames[m.nFrames % nInputFrames];
+		uint64_t sum = 0;
+		begin(m);
+		for (int i = 0; i < frame.trackables_size(); i++) {
+			sum += getTrackableKey(frame.trackables(i)).size();
+		}
+		end(m);
+		sink = sink + sum;
+	}
+	return toResult("trackableKey", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runReconcileKey(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 0.5, 0.5);
+	// Reconcile each trackable with the key of the mirrored trackable,
+	// so IDs become CUIDs and vice versa
+	vector<string> keys(nMarkers);
+	for (int i = 0; i < nMarkers; i++) {
+		keys[i] = getTrackableKey(frames[0].trackables(nMarkers - 1 - i));
+	}
+
+	Measurement m;
+	TrackableFrame work;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		work.CopyFrom(frames[m.nFrames % nInputFrames]);
+		begin(m);
+		for (int i = 0; i < work.trackables_size(); i++) {
+			reconcileTrackableWithKey(*work.mutable_trackables(i), keys[i]);
+		}
+		end(m);
+	}
+	return toResult("reconcileKey", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runWorkingSet(int nMarkers) {
+
+	// A third of the markers are unidentifiable and are removed
+	auto frames = createFrames(nMarkers, 0.33, 0.33);
+
+	Measurement m;
+	TrackableFrame work;
+	ofxRTLSWorkingSet ws;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		work.CopyFrom(frames[m.nFrames % nInputFrames]);
+		begin(m);
+		ws.load(work);
+		for (size_t i = 0; i < ws.size(); i++) {
+			if (!isTrackableIdentifiable(ws.getKeyType(i))) ws.remove(i);
+		}
+		ws.writeBack();
+		end(m);
+	}
+	return toResult("workingSet", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runMapIDs(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 1, 0);
+
+	// Write a dictionary that covers every ID
+	int nBits = 1;
+	while ((1 << nBits) <= nMarkers) nBits++;
+	ofJson dict;
+	dict["nBits"] = nBits;
+	for (int i = 0; i < (1 << nBits); i++) dict["dict"].push_back((i * 7 + 3) % (1 << nBits));
+	string dictPath = ofFilePath::join(tempFolder, "dict.json");
+	ofSaveJson(dictPath, dict);
+
+	ofJson settings;
+	settings["mapIDs"] = true;
+	settings["dictPath"] = dictPath;
+	ofxRTLSPostprocessor pp;
+	pp.setupHeadless(RTLS_SYSTEM_TYPE_NULL, RTLS_TRACKABLE_TYPE_SAMPLE, "Microbenchmark", "MB", settings);
+
+	ofxRTLSPostprocessStage::Context context;
+	context.params = pp.acquireParams();
+	Measurement m;
+	TrackableFrame work;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		work.CopyFrom(frames[m.nFrames % nInputFrames]);
+		pp.workingSet.load(work);
+		begin(m);
+		pp._process_mapIDs(pp.workingSet, context);
+		end(m);
+	}
+	return toResult("mapIDs", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runRemoveUnidentifiable(int nMarkers) {
+
+	// A third of the markers are unidentifiable
+	auto frames = createFrames(nMarkers, 0.33, 0.33);
+
+	ofxRTLSPostprocessor pp;
+	pp.setupHeadless(RTLS_SYSTEM_TYPE_NULL, RTLS_TRACKABLE_TYPE_SAMPLE, "Microbenchmark", "MB", ofJson::object());
+
+	ofxRTLSPostprocessStage::Context context;
+	context.params = pp.acquireParams();
+	Measurement m;
+	TrackableFrame work;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		work.CopyFrom(frames[m.nFrames % nInputFrames]);
+		pp.workingSet.load(work);
+		begin(m);
+		pp._process_removeUnidentifiable(pp.workingSet, context);
+		end(m);
+	}
+	return toResult("removeUnidentifiable", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runHungarian(int nMarkers) {
+
+	// Markers keep their CUIDs and matching keys are not removed, so every
+	// marker is passed to the solver on every frame.
+	auto frames = createFrames(nMarkers, 0, 1);
+
+	ofJson settings;
+	settings["applyHungarian"] = true;
+	settings["hungarian"]["temporaryKeyTypes"] = "2";
+	settings["hungarian"]["permanentKeyTypes"] = "1";
+	settings["hungarian"]["radius"] = 0.1;
+	settings["hungarian"]["from"] = "both";
+	settings["hungarian"]["to"] = "both";
+	settings["hungarian"]["removeMatchingKeys"] = false;
+	settings["hungarian"]["assignCuids"] = false;
+	ofxRTLSPostprocessor pp;
+	pp.setupHeadless(RTLS_SYSTEM_TYPE_NULL, RTLS_TRACKABLE_TYPE_SAMPLE, "Microbenchmark", "MB", settings);
+	TrackableFrame last = frames.back();
+	pp.lastWorkingSet.load(last);
+	pp.lastWorkingSet.writeBack();
+
+	ofxRTLSPostprocessStage::Context context;
+	context.params = pp.acquireParams();
+	Measurement m;
+	TrackableFrame work;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		work.CopyFrom(frames[m.nFrames % nInputFrames]);
+		pp.workingSet.load(work);
+		begin(m);
+		pp._process_applyHungarian(pp.workingSet, context);
+		end(m);
+		pp.workingSet.writeBack();
+		pp.lastWorkingSet.swap(pp.workingSet);
+	}
+	return toResult("hungarian", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runFilters(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 0.5, 0.5);
+
+	ofJson settings;
+	settings["applyFilters"] = true;
+	settings["filterList"] = "axes(1,1,-1) easing(10)";
+	ofxRTLSPostprocessor pp;
+	pp.setupHeadless(RTLS_SYSTEM_TYPE_NULL, RTLS_TRACKABLE_TYPE_SAMPLE, "Microbenchmark", "MB", settings);
+
+	ofxRTLSPostprocessStage::Context context;
+	context.params = pp.acquireParams();
+	Measurement m;
+	TrackableFrame work;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		work.CopyFrom(frames[m.nFrames % nInputFrames]);
+		context.timeMS = m.nFrames;
+		pp.workingSet.load(work);
+		begin(m);
+		pp._process_applyFilters(pp.workingSet, context);
+		end(m);
+	}
+	return toResult("filters", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runTakeAdd(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 0.5, 0.5);
+
+	Measurement m;
+	RTLSTake* take = new RTLSTake();
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		begin(m);
+		take->add(0, 240, frames[m.nFrames % nInputFrames]);
+		end(m);
+		take->update(0);
+		// Limit the memory held by the take
+		if (take->getNumFrames() >= 1000) {
+			take->clear();
+			delete take;
+			take = new RTLSTake();
+		}
+	}
+	take->clear();
+	delete take;
+	return toResult("takeAdd", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runTakeUpdate(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 0.5, 0.5);
+
+	Measurement m;
+	RTLSTake* take = new RTLSTake();
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		take->add(0, 240, frames[m.nFrames % nInputFrames]);
+		begin(m);
+		take->update(0);
+		end(m);
+		if (take->getNumFrames() >= 1000) {
+			take->clear();
+			delete take;
+			take = new RTLSTake();
+		}
+	}
+	take->clear();
+	delete take;
+	return toResult("takeUpdate", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runTakeSave(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 0.5, 0.5);
+	const int nFramesPerTake = nInputFrames * 4;
+
+	Measurement m;
+	auto startTime = std::chrono::steady_clock::now();
+	while (!isDone(m, startTime)) {
+		RTLSTake take;
+		take.path = ofFilePath::join(tempFolder, "take.c3d");
+		for (int f = 0; f < nFramesPerTake; f++) {
+			take.add(0, 240, frames[f % nInputFrames]);
+			take.update(0);
+		}
+		begin(m);
+		take.save();
+		end(m, nFramesPerTake);
+		take.clear();
+	}
+	return toResult("takeSave", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+ofxRTLSMicrobenchmark::Result ofxRTLSMicrobenchmark::runPlayerGetFrames(int nMarkers) {
+
+	auto frames = createFrames(nMarkers, 0.5, 0.5);
+
+	Measurement m;
+	RTLSPlayerTake take;
+	take.path = saveTake(frames, nInputFrames);
+	if (!take.load()) {
+		ofLogError("ofxRTLSMicrobenchmark") << "Could not load take \"" << take.path << "\"";
+		return toResult("playerGetFrames", nMarkers, m);
+	}
+	uint64_t nFrames = take.getC3dNumFrames();
+
+	auto startTime = std::chrono::steady_clock::now();
+	while (nFrames > 0 && !isDone(m, startTime)) {
+		uint64_t frameIndex = m.nFrames % nFrames;
+		begin(m);
+		auto pts = take.c3d->data().frame(frameIndex).points();
+		for (auto& f : take.frames) take.readFrame(f, pts, frameIndex);
+		end(m);
+	}
+	return toResult("playerGetFrames", nMarkers, m);
+}
+
+// --------------------------------------------------------------
+string ofxRTLSMicrobenchmark::saveTake(const vector<TrackableFrame>& frames, int nFrames) {
+
+	RTLSTake take;
+	take.path = ofFilePath::join(tempFolder, "take.c3d");
+	for (int f = 0; f < nFrames; f++) {
+		take.add(0, 240, frames[f % frames.size()]);
+		take.update(0);
+	}
+	take.save();
+	take.clear();
+	return take.path;
+}
+
+// --------------------------------------------------------------
+ofJson ofxRTLSMicrobenchmark::Result::toJson() const {
+
+	ofJson js;
+	js["benchmark"] = benchmark;
+	js["markers"] = nMarkers;
+	js["frames"] = nFrames;
+	js["nsPerFrame"] = nsPerFrame;
+	if (allocsPerFrame >= 0) js["allocsPerFrame"] = allocsPerFrame;
+	else js["allocsPerFrame"] = nullptr;
+	return js;
+}
+
+// --------------------------------------------------------------
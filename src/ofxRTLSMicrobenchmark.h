@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSTypes.h"
+#include "ofxRTLSTake.h"
+#include "ofxRTLSPostprocessor.h"
+#include "Trackable.pb.h"
+using namespace RTLSProtocol;
+
+// Measures the per-frame hot paths of ofxRTLS at several marker counts:
+//	trackableKey			getTrackableKey() for every trackable
+//	reconcileKey			reconcileTrackableWithKey() for every trackable
+//	workingSet				ofxRTLSWorkingSet::load(), removing a third of the
+//							trackables and ofxRTLSWorkingSet::writeBack()
+//	mapIDs					ofxRTLSPostprocessor::_process_mapIDs()
+//	removeUnidentifiable	ofxRTLSPostprocessor::_process_removeUnidentifiable()
+//	hungarian				ofxRTLSPostprocessor::_process_applyHungarian()
+//	filters					ofxRTLSPostprocessor::_process_applyFilters()
+// (Postprocessor stages are measured on a working set that is already loaded.)
+//	takeAdd					RTLSTake::add() (as called by the recorder)
+//	takeUpdate				RTLSTake::update() (as called by the recorder)
+//	takeSave				RTLSTake::save(), per frame saved
+//	playerGetFrames			reading a frame of a take, as ofxRTLSPlayer::getFrames()
+//
+// Each result reports nanoseconds and heap allocations per frame. Allocations
+// can only be counted by the executable (which must replace the global 
+// operator new); provide its counter with setAllocationCounter().
+// Results are written as json, one line per result.
+class ofxRTLSMicrobenchmark {
+public:
+
+	ofxRTLSMicrobenchmark();
+	~ofxRTLSMicrobenchmark();
+
+	// Marker counts at which every benchmark is run
+	void setMarkerCounts(vector<int> _markerCounts) { markerCounts = _markerCounts; }
+	// Each measurement runs for at least this long
+	void setMinDuration(float seconds) { minDurationSec = seconds; }
+	// The Hungarian solver grows cubically, so it is skipped above this count
+	void setMaxHungarianMarkers(int n) { maxHungarianMarkers = n; }
+	// Provide a function returning the total number of allocations made
+	void setAllocationCounter(function<uint64_t()> counter) { allocationCounter = counter; }
+	// Folder for temporary files (dictionaries and takes)
+	void setTempFolder(string folder) { tempFolder = folder; }
+
+	struct Result {
+		string benchmark = "";
+		int nMarkers = 0;
+		uint64_t nFrames = 0;
+		double nsPerFrame = 0;
+		// Negative if allocations are not counted
+		double allocsPerFrame = -1;
+
+		ofJson toJson() const;
+	};
+
+	// Get the names of all benchmarks
+	static vector<string> getBenchmarks();
+
+	// Run benchmarks whose names contain the filter (all if empty).
+	// Each result is passed to the callback as it completes.
+	vector<Result> run(string filter = "", function<void(const Result&)> callback = nullptr);
+
+private:
+
+	vector<int> markerCounts = { 10, 100, 1000, 10000 };
+	float minDurationSec = 0.5;
+	int maxHungarianMarkers = 1000;
+	function<uint64_t()> allocationCounter = nullptr;
+	string tempFolder = "microbenchmark";
+
+	// Number of distinct input frames cycled through by each benchmark
+	const int nInputFrames = 64;
+	// Create input frames with moving markers. The fraction of markers that
+	// are identifiable by ID, CUID or not at all is given.
+	vector<TrackableFrame> createFrames(int nMarkers, float idFraction, float cuidFraction);
+
+	// Accumulates the timing and allocations of a measurement
+	struct Measurement {
+		uint64_t nFrames = 0;
+		uint64_t ns = 0;
+		uint64_t allocs = 0;
+		std::chrono::steady_clock::time_point start;
+		uint64_t startAllocs = 0;
+	};
+	void begin(Measurement& m);
+	void end(Measurement& m, uint64_t nFrames = 1);
+	bool isDone(Measurement& m, std::chrono::steady_clock::time_point startTime);
+	Result toResult(string name, int nMarkers, Measurement& m);
+
+	Result runTrackableKey(int nMarkers);
+	Result runReconcileKey(int nMarkers);
+	Result runWorkingSet(int nMarkers);
+	Result runMapIDs(int nMarkers);
+	Result runRemoveUnidentifiable(int nMarkers);
+	Result runHungarian(int nMarkers);
+	Result runFilters(int nMarkers);
+	Result runTakeAdd(int nMarkers);
+	Result runTakeUpdate(int nMarkers);
+	Result runTakeSave(int nMarkers);
+	Result runPlayerGetFrames(int nMarkers);
+
+	// Write a take of frames to the temp folder, returning its path
+	string saveTake(const vector<TrackableFrame>& frames, int nFrames);
+
+	// Keep results observable, so they aren't optimized away
+	volatile uint64_t sink = 0;
+};
@@ -0,0 +1,266 @@
+#include "ofxRTLSNullScenario.h"
+
+// --------------------------------------------------------------
+ofxRTLSNullScenario::ofxRTLSNullScenario() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSNullScenario::~ofxRTLSNullScenario() {
+
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSNullScenario::setup(string path) {
+
+	ofFile file(ofToDataPath(path));
+	if (!file.exists()) {
+		ofLogError("ofxRTLSNullScenario") << "Scenario file does not exist: \"" << path << "\"";
+		return false;
+	}
+	ofJson js;
+	try {
+		file >> js;
+	}
+	catch (const std::exception&) {
+		ofLogError("ofxRTLSNullScenario") << "Could not parse scenario file \"" << path << "\"";
+		return false;
+	}
+	return setup(js);
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSNullScenario::setup(const ofJson& js) {
+
+	bSetup = false;
+	if (!js.is_object()) {
+		ofLogError("ofxRTLSNullScenario") << "A scenario must be a json object";
+		return false;
+	}
+	scenario = js;
+
+	seed = js.value("seed", uint64_t(1));
+	fps = MAX(js.value("fps", 240.0f), 1.0f);
+	nFrames = uint64_t(round(MAX(js.value("duration", 10.0f), 0.0f) * fps));
+	nTrackables = MAX(js.value("nTrackables", 20), 0);
+	loBound = js.value("loBound", 0.0f);
+	hiBound = js.value("hiBound", 1.0f);
+	speed = js.value("speed", 0.5f);
+	noise = js.value("noise", 0.001f);
+	dropout = js.value("dropout", 0.0f);
+	bSetID = js.value("setID", true);
+	bSetCUID = js.value("setCUID", true);
+
+	events.clear();
+	if (js.find("events") != js.end() && js["events"].is_array()) {
+		map<string, EventType> types = {
+			{ "crowdCrossing", CROWD_CROSSING },
+			{ "occlusionBurst", OCCLUSION_BURST },
+			{ "ghosts", GHOSTS },
+			{ "cuidChurn", CUID_CHURN },
+			{ "idFlicker", ID_FLICKER } };
+		for (auto& e : js["events"]) {
+			string type = e.value("type", string(""));
+			if (types.find(type) == types.end()) {
+				ofLogWarning("ofxRTLSNullScenario") << "Unknown scenario event type \"" << type << "\"";
+				continue;
+			}
+			Event event;
+			event.type = types[type];
+			event.startFrame = uint64_t(round(MAX(e.value("start", 0.0f), 0.0f) * fps));
+			event.stopFrame = event.startFrame + uint64_t(round(MAX(e.value("duration", 1.0f), 0.0f) * fps));
+			event.fraction = e.value("fraction", event.fraction);
+			event.band = e.value("band", event.band);
+			event.rate = e.value("rate", event.rate);
+			event.lifetime = e.value("lifetime", event.lifetime);
+			event.offset = e.value("offset", event.offset);
+			event.probability = e.value("probability", event.probability);
+			event.swapProbability = e.value("swapProbability", event.swapProbability);
+			events.push_back(event);
+		}
+	}
+
+	bSetup = true;
+	reset();
+	return true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSNullScenario::reset() {
+
+	rngState = seed * 0x9E3779B97F4A7C15ULL + 1;
+	frameIndex = 0;
+	cuidCounter = 1;
+	ghosts.clear();
+	for (auto& e : events) e.members.clear();
+
+	trackables.resize(nTrackables);
+	for (auto& t : trackables) {
+		t.position = glm::vec3(random(loBound, hiBound), random(loBound, hiBound), random(loBound, hiBound));
+		t.velocity = glm::vec3(random(-1, 1), random(-1, 1), random(-1, 1));
+		if (glm::length(t.velocity) > 0) t.velocity = glm::normalize(t.velocity) * speed / fps;
+		t.cuid = cuidCounter++;
+		t.bCrossing = false;
+	}
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSNullScenario::getNextFrame(NullSystemEventArgs& args) {
+	if (!bSetup) return false;
+	if (frameIndex >= nFrames) return false;
+
+	float center = (loBound + hiBound) / 2.0;
+	set<int> occluded;
+	float idDropProbability = 0;
+	float idSwapProbability = 0;
+
+	for (auto& e : events) {
+
+		// Choose members and begin crossings when events start
+		if (frameIndex == e.startFrame) {
+			switch (e.type) {
+			case CROWD_CROSSING: {
+				e.members = randomMembers(e.fraction);
+				for (auto i : e.members) {
+					auto& t = trackables[i];
+					t.bCrossing = true;
+					t.crossFrom = t.position;
+					// Cross to the mirrored side, converging into a band
+					t.crossTo = glm::vec3(
+						loBound + hiBound - t.position.x,
+						center + (t.position.y - center) * e.band,
+						t.position.z);
+				}
+			}; break;
+			case OCCLUSION_BURST: {
+				e.members = randomMembers(e.fraction);
+			}; break;
+			default: break;
+			}
+		}
+		if (frameIndex == e.stopFrame && e.type == CROWD_CROSSING) {
+			for (auto i : e.members) trackables[i].bCrossing = false;
+		}
+		if (!e.isActive(frameIndex)) continue;
+
+		switch (e.type) {
+		case CROWD_CROSSING: {
+			// Move along the crossing, easing in and out
+			float u = float(frameIndex - e.startFrame + 1) / float(MAX(e.stopFrame - e.startFrame, uint64_t(1)));
+			u = u * u * (3.0f - 2.0f * u);
+			for (auto i : e.members) {
+				auto& t = trackables[i];
+				glm::vec3 next = t.crossFrom + (t.crossTo - t.crossFrom) * u;
+				t.velocity = next - t.position;
+				t.position = next;
+			}
+		}; break;
+		case OCCLUSION_BURST: {
+			occluded.insert(e.members.begin(), e.members.end());
+		}; break;
+		case GHOSTS: {
+			// Spawn ghosts near real trackables
+			if (nTrackables > 0 && random() < e.rate / fps) {
+				Ghost g;
+				auto& t = trackables[int(random() * nTrackables) % nTrackables];
+				g.position = t.position + glm::vec3(random(-1, 1), random(-1, 1), random(-1, 1)) * e.offset;
+				g.cuid = cuidCounter++;
+				g.stopFrame = frameIndex + MAX(uint64_t(round(e.lifetime * fps)), uint64_t(1));
+				ghosts.push_back(g);
+			}
+		}; break;
+		case CUID_CHURN: {
+			for (auto& t : trackables) {
+				if (random() < e.rate / fps) t.cuid = cuidCounter++;
+			}
+		}; break;
+		case ID_FLICKER: {
+			idDropProbability = MAX(idDropProbability, e.probability);
+			idSwapProbability = MAX(idSwapProbability, e.swapProbability);
+		}; break;
+		}
+	}
+
+	// Move all trackables that are not crossing, reflecting off the bounds
+	for (auto& t : trackables) {
+		if (t.bCrossing) continue;
+		t.position += t.velocity;
+		for (int a = 0; a < 3; a++) {
+			if (t.position[a] < loBound || t.position[a] > hiBound) {
+				t.velocity[a] *= -1;
+				t.position[a] = ofClamp(t.position[a], loBound, hiBound);
+			}
+		}
+	}
+
+	// Exchange IDs between pairs of trackables
+	vector<int> ids(nTrackables);
+	for (int i = 0; i < nTrackables; i++) ids[i] = i + 1;
+	if (nTrackables > 1 && random() < idSwapProbability) {
+		int a = int(random() * nTrackables) % nTrackables;
+		int b = int(random() * nTrackables) % nTrackables;
+		swap(ids[a], ids[b]);
+	}
+
+	// Output trackables
+	for (int i = 0; i < nTrackables; i++) {
+		auto& t = trackables[i];
+		if (random() < dropout) continue;
+		if (occluded.find(i) != occluded.end()) continue;
+
+		NullSystemTrackable out;
+		out.setKnownPosition(t.position);
+		out.setPositionNoise(glm::vec3(random(-noise, noise), random(-noise, noise), random(-noise, noise)));
+		if (bSetID && random() >= idDropProbability) out.setId(ids[i]);
+		if (bSetCUID) out.setCuid(ofToString(t.cuid));
+		out.setTruth(i + 1);
+		args.trackables.push_back(out);
+	}
+
+	// Output ghosts (which have no IDs)
+	auto it = ghosts.begin();
+	while (it != ghosts.end()) {
+		if (frameIndex >= it->stopFrame) {
+			it = ghosts.erase(it);
+			continue;
+		}
+		NullSystemTrackable out;
+		out.setKnownPosition(it->position);
+		out.setPositionNoise(glm::vec3(random(-noise, noise), random(-noise, noise), random(-noise, noise)));
+		if (bSetCUID) out.setCuid(ofToString(it->cuid));
+		out.setTruth(-1);
+		args.trackables.push_back(out);
+		it++;
+	}
+
+	frameIndex++;
+	return true;
+}
+
+// --------------------------------------------------------------
+uint64_t ofxRTLSNullScenario::randomU64() {
+
+	rngState ^= rngState >> 12;
+	rngState ^= rngState << 25;
+	rngState ^= rngState >> 27;
+	return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+// --------------------------------------------------------------
+float ofxRTLSNullScenario::random(float lo, float hi) {
+
+	float u = float(randomU64() >> 40) * (1.0f / 16777216.0f);
+	return lo + (hi - lo) * u;
+}
+
+// --------------------------------------------------------------
+vector<int> ofxRTLSNullScenario::randomMembers(float fraction) {
+
+	vector<int> members;
+	for (int i = 0; i < nTrackables; i++) {
+		if (random() < fraction) members.push_back(i);
+	}
+	return members;
+}
+
+// --------------------------------------------------------------
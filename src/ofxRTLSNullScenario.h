@@ -0,0 +1,128 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSNullSystem.h"
+
+// Generates scripted, repeatable situations for the null system, with the
+// ground truth identity of every output trackable. Time is virtual (frames / fps)
+// and all randomness comes from the seed, so a scenario always produces
+// the same frames.
+//
+// Scenarios are described with json:
+// {
+//		"seed" : 1,
+//		"fps" : 240,
+//		"duration" : 10,			// seconds
+//		"nTrackables" : 20,
+//		"loBound" : 0,				// bounds of the space (in x, y, z)
+//		"hiBound" : 1,
+//		"speed" : 0.5,				// units per second
+//		"noise" : 0.001,			// half-width of uniform position noise
+//		"dropout" : 0,				// probability per frame that a trackable is missing
+//		"setID" : true,
+//		"setCUID" : true,
+//		"events" : [ ... ]
+// }
+// Each event has a "type", a "start" time and a "duration" (seconds):
+//	"crowdCrossing"		A "fraction" of trackables cross to the mirrored side 
+//						of the space, converging into a band of relative 
+//						width "band" halfway through.
+//	"occlusionBurst"	A "fraction" of trackables are missing.
+//	"ghosts"			Ghost markers appear at "rate" per second, each for 
+//						"lifetime" seconds, within "offset" of a real trackable.
+//	"cuidChurn"			Trackables receive new cuids at "rate" per second.
+//	"idFlicker"			Each trackable's ID is missing with "probability" per 
+//						frame, and pairs of trackables exchange IDs with
+//						"swapProbability" per frame.
+class ofxRTLSNullScenario {
+public:
+
+	ofxRTLSNullScenario();
+	~ofxRTLSNullScenario();
+
+	// Load a scenario from a json file...
+	bool setup(string path);
+	// ... or from json directly.
+	bool setup(const ofJson& scenario);
+
+	// Restart the scenario from the beginning.
+	void reset();
+
+	// Get the next frame of the scenario. Trackables have ground truth.
+	// Returns false if the scenario has ended.
+	bool getNextFrame(NullSystemEventArgs& args);
+
+	float getFPS() { return fps; }
+	uint64_t getNumFrames() { return nFrames; }
+	uint64_t getFrameIndex() { return frameIndex; }
+	bool isSetup() { return bSetup; }
+
+private:
+
+	bool bSetup = false;
+	ofJson scenario;
+
+	// Scenario parameters
+	uint64_t seed = 1;
+	float fps = 240;
+	uint64_t nFrames = 0;
+	int nTrackables = 20;
+	float loBound = 0;
+	float hiBound = 1;
+	float speed = 0.5;
+	float noise = 0.001;
+	float dropout = 0;
+	bool bSetID = true;
+	bool bSetCUID = true;
+
+	enum EventType {
+		CROWD_CROSSING = 0,
+		OCCLUSION_BURST,
+		GHOSTS,
+		CUID_CHURN,
+		ID_FLICKER
+	};
+	struct Event {
+		EventType type;
+		uint64_t startFrame = 0;
+		uint64_t stopFrame = 0;
+		float fraction = 0.5;
+		float band = 0.2;
+		float rate = 1;
+		float lifetime = 0.1;
+		float offset = 0.05;
+		float probability = 0.05;
+		float swapProbability = 0;
+		// Trackables affected by this event (chosen when it starts)
+		vector<int> members;
+		bool isActive(uint64_t frame) { return frame >= startFrame && frame < stopFrame; }
+	};
+	vector<Event> events;
+
+	struct Trackable {
+		glm::vec3 position;
+		glm::vec3 velocity;
+		uint64_t cuid = 0;
+		// Crowd crossings move trackables from one position to another
+		bool bCrossing = false;
+		glm::vec3 crossFrom;
+		glm::vec3 crossTo;
+	};
+	vector<Trackable> trackables;
+
+	struct Ghost {
+		glm::vec3 position;
+		uint64_t cuid = 0;
+		uint64_t stopFrame = 0;
+	};
+	vector<Ghost> ghosts;
+
+	uint64_t frameIndex = 0;
+	uint64_t cuidCounter = 1;
+
+	// Random number generator (xorshift64*)
+	uint64_t rngState = 1;
+	uint64_t randomU64();
+	float random(float lo = 0, float hi = 1);
+	vector<int> randomMembers(float fraction);
+};
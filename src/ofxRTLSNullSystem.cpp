@@ -1,44 +1,99 @@
 #include "ofxRTLSNullSystem.h"
+#include "ofxRTLSNullScenario.h"
 
+// Random values for the high-scale generator are hashed from integers,
+// so they don't depend on the order in which trackables are updated.
 // --------------------------------------------------------------
-ofxRTLSNullSystem::ofxRTLSNullSystem() {
+static inline uint32_t nsHash(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x;
+}
+
+// --------------------------------------------------------------
+// Combine two integers into a key. Each random value is the hash of a
+// trackable's key (seed, index) and a key shared by all trackables
+// (frame, stream), so only the former must be computed per trackable.
+static inline uint32_t nsKey(uint32_t a, uint32_t b) {
+	return nsHash(a ^ nsHash(b + 0x9e3779b9));
+}
+
+// --------------------------------------------------------------
+// Uniform value in [0, 1)
+static inline float nsUniform(uint32_t trackableKey, uint32_t sharedKey) {
+	return float(nsHash(trackableKey ^ sharedKey) >> 8) * (1.0f / 16777216.0f);
+}
+
+// --------------------------------------------------------------
+// Uniform value in [-1, 1)
+static inline float nsSigned(uint32_t trackableKey, uint32_t sharedKey) {
+	return 2.0f * nsUniform(trackableKey, sharedKey) - 1.0f;
+}
+
+// --------------------------------------------------------------
+// Three coarser uniform values in [-1, 1), from the 10-bit fields of one hash
+static inline glm::vec3 nsSigned3(uint32_t trackableKey, uint32_t sharedKey) {
+	uint32_t h = nsHash(trackableKey ^ sharedKey);
+	const float scale = 2.0f / 1024.0f;
+	return glm::vec3(
+		float(h & 0x3FF) * scale - 1.0f,
+		float((h >> 10) & 0x3FF) * scale - 1.0f,
+		float((h >> 20) & 0x3FF) * scale - 1.0f);
+}
 
+// --------------------------------------------------------------
+ofxRTLSNullSystem::ofxRTLSNullSystem() {
+	scenario = new ofxRTLSNullScenario();
 }
 
 // --------------------------------------------------------------
 ofxRTLSNullSystem::~ofxRTLSNullSystem() {
+	if (bSetup) ofRemoveListener(RUI_GET_OF_EVENT(), this, &ofxRTLSNullSystem::paramChanged);
 	waitForThread(true);
+	delete scenario;
 }
 
 // --------------------------------------------------------------
-void ofxRTLSNullSystem::setup() {
+void ofxRTLSNullSystem::setup(string instanceID) {
 
 	ofAddListener(RUI_GET_OF_EVENT(), this, &ofxRTLSNullSystem::paramChanged);
-
-	RUI_NEW_GROUP("ofxRTLS Null System");
-	RUI_SHARE_PARAM_WCN("NuS- Send Fake Data", bSendFakeData);
-	RUI_SHARE_ENUM_PARAM_WCN("NuS- Data Mode", mode, ELASTIC, BROWNIAN, { "Elastic", "Brownian" });
-	RUI_SHARE_PARAM_WCN("NuS- Frame Rate", fps, 0, 1000);
-	RUI_SHARE_PARAM_WCN("NuS- nPoints", nPoints, 0, 1000);
-	RUI_SHARE_PARAM_WCN("NuS- Space Lo Bound", loBound, -10000, 10000);
-	RUI_SHARE_PARAM_WCN("NuS- Space Hi Bound", hiBound, -10000, 10000);
-	RUI_SHARE_PARAM_WCN("NuS- Position Speed", positionSpeed, -1000, 1000);
-	RUI_SHARE_PARAM_WCN("NuS- Position Noise", positionNoise, -100, 100);
-	RUI_SHARE_PARAM_WCN("NuS- Elastic Force", elasticForce, 0, 10);
-	RUI_SHARE_PARAM_WCN("NuS- Elastic Winds", elasticWinds, 0, 1);
-	RUI_SHARE_PARAM_WCN("NuS- Target Presence Density", targetPresenceDensity, 0, 1);
-	RUI_SHARE_PARAM_WCN("NuS- Presence Return Rapidness", presenceReturnRapidness, 0, 10);
-	RUI_SHARE_PARAM_WCN("NuS- Set ID", bSetID);
-	RUI_SHARE_PARAM_WCN("NuS- Set CUID", bSetCUID);
-	RUI_SHARE_PARAM_WCN("NuS- Override Context", bOverrideContext);
-	RUI_SHARE_PARAM_WCN("NuS- System Override", systemOverride, 0, 100);
-	RUI_SHARE_PARAM_WCN("NuS- Type Override", typeOverride, 0, 100);
-
-	temporalResampler.setDesiredFPS(fps);
+	bSetup = true;
+
+	// Each instance has its own params
+	if (!instanceID.empty()) paramPrefix = "NuS_" + instanceID + "- ";
+	RUI_NEW_GROUP("ofxRTLS Null System" + (instanceID.empty() ? string("") : " " + instanceID));
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Send Fake Data", bSendFakeData);
+	RUI_SHARE_ENUM_PARAM_WCN(paramPrefix + "Data Mode", mode, ELASTIC, BROWNIAN, { "Elastic", "Brownian" });
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Frame Rate", fps, 0, 10000);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "nPoints", nPoints, 0, 100000);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Space Lo Bound", loBound, -10000, 10000);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Space Hi Bound", hiBound, -10000, 10000);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Position Speed", positionSpeed, -1000, 1000);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Position Noise", positionNoise, -100, 100);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Elastic Force", elasticForce, 0, 10);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Elastic Winds", elasticWinds, 0, 1);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Target Presence Density", targetPresenceDensity, 0, 1);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Presence Return Rapidness", presenceReturnRapidness, 0, 10);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Set ID", bSetID);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Set CUID", bSetCUID);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Override Context", bOverrideContext);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "System Override", systemOverride, 0, 100);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Type Override", typeOverride, 0, 100);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "High Scale", bHighScale);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Seed", seed, 0, 1000000);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Threads", nThreads, 0, 64);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Scenario", bScenario);
+	RUI_SHARE_PARAM_WCN(paramPrefix + "Scenario Path", scenarioPath);
+
+	pacer.setDesiredFPS(fps);
 }
 
 // --------------------------------------------------------------
 void ofxRTLSNullSystem::start() {
+	pacer.reset();
 	startThread();
 	bConnected = true;
 }
@@ -54,20 +109,54 @@ void ofxRTLSNullSystem::stop() {
 	waitForThread(true);
 }
 
+// --------------------------------------------------------------
+float ofxRTLSNullSystem::getFrameRate() {
+	if (bScenario && scenario->isSetup()) return scenario->getFPS();
+	return fps;
+}
+
 // --------------------------------------------------------------
 void ofxRTLSNullSystem::threadedFunction() {
 
 	while (isThreadRunning()) {
 
-		temporalResampler.update();
+		// Wait until the next frame is due
+		if (!pacer.waitForNextFrame()) continue;
+
+		if (flagLoadScenario) {
+			flagLoadScenario = false;
+			if (bScenario && scenario->setup(scenarioPath)) {
+				pacer.setDesiredFPS(scenario->getFPS());
+			}
+			else {
+				pacer.setDesiredFPS(fps);
+			}
+		}
 
 		if (bSendFakeData) {
 			NullSystemEventArgs args;
-			getNextFrame(args);
+			if (bScenario && scenario->isSetup()) {
+				// Scenarios loop from the beginning when they end
+				if (!scenario->getNextFrame(args)) {
+					scenario->reset();
+					scenario->getNextFrame(args);
+				}
+			}
+			else if (bHighScale) getNextFrameHighScale(args);
+			else getNextFrame(args);
+			// Override context if necessary
+			if (bOverrideContext)
+			{
+				args.bOverrideContext = true;
+				args.systemOverride = systemOverride;
+				args.typeOverride = typeOverride;
+			}
+			// Frames are generated at their deadlines
+			args.sourceTimeMicros = pacer.getLastDeadlineMicros();
 			ofNotifyEvent(newDataReceived, args);
+			// Keep the block's memory for the next frame
+			if (args.bHighScale) hsBlock.swap(args.block);
 		}
-
-		sleep(temporalResampler.getSleepDurationMS());
 	}
 }
 
@@ -76,8 +165,14 @@ void ofxRTLSNullSystem::paramChanged(RemoteUIServerCallBackArg& arg) {
 
 	if (arg.action == CLIENT_UPDATED_PARAM) {
 
-		if (arg.paramName == "NuS- Frame Rate") {
-			temporalResampler.setDesiredFPS(arg.param.floatVal);
+		if (arg.paramName == paramPrefix + "Frame Rate") {
+			if (!bScenario) pacer.setDesiredFPS(arg.param.floatVal);
+		}
+		else if (arg.paramName == paramPrefix + "Scenario" || arg.paramName == paramPrefix + "Scenario Path") {
+			flagLoadScenario = true;
+		}
+		else if (arg.paramName == paramPrefix + "Seed" || arg.paramName == paramPrefix + "High Scale") {
+			flagRestartHighScale = true;
 		}
 	}
 }
@@ -206,13 +301,216 @@ void ofxRTLSNullSystem::getNextFrame(NullSystemEventArgs& args) {
 		if (!t.bPresent) continue;
 		args.trackables.push_back(NullSystemTrackable(t));
 	}
-	// Override context if necessary
-	if (bOverrideContext)
-	{
-		args.bOverrideContext = true;
-		args.systemOverride = systemOverride;
-		args.typeOverride = typeOverride;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSNullSystem::HighScaleState::resize(size_t n) {
+	px.resize(n);
+	py.resize(n);
+	pz.resize(n);
+	vx.resize(n);
+	vy.resize(n);
+	vz.resize(n);
+	maxSpeedFraction.resize(n);
+	present.resize(n);
+	cuid.resize(n);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSNullSystem::getNextFrameHighScale(NullSystemEventArgs& args) {
+
+	// Restart the generator, if requested
+	if (flagRestartHighScale) {
+		flagRestartHighScale = false;
+		hs.resize(0);
+		hsFrame = 0;
+	}
+
+	// Resize the worker pool, if requested
+	if (poolThreads != nThreads) {
+		poolThreads = nThreads;
+		pool.setup(poolThreads);
+	}
+
+	// Copy params, since they may change during this frame
+	size_t n = size_t(MAX(nPoints, 0));
+	float _fps = MAX(fps, 1.0f);
+	float _loBound = loBound;
+	float _hiBound = hiBound;
+	float _positionSpeed = positionSpeed;
+	float _positionNoise = positionNoise;
+	bool _bSetID = bSetID;
+	bool _bSetCUID = bSetCUID;
+	RTLSNullSystemMode _mode = mode;
+	uint32_t _seed = uint32_t(seed);
+	uint32_t frame = uint32_t(hsFrame);
+
+	// Initialize any new trackables
+	size_t lastSize = hs.size();
+	if (n != lastSize) {
+		hs.resize(n);
+		hsOutput.resize(n);
+		uint32_t initKeys[7];
+		for (uint32_t k = 0; k < 7; k++) initKeys[k] = nsKey(0xFFFFFFFF, k);
+		float range = _hiBound - _loBound;
+		for (size_t i = lastSize; i < n; i++) {
+			uint32_t tk = nsKey(_seed, uint32_t(i));
+			hs.px[i] = _loBound + range * nsUniform(tk, initKeys[0]);
+			hs.py[i] = _loBound + range * nsUniform(tk, initKeys[1]);
+			hs.pz[i] = _loBound + range * nsUniform(tk, initKeys[2]);
+			hs.vx[i] = nsSigned(tk, initKeys[3]) * _positionSpeed / _fps;
+			hs.vy[i] = nsSigned(tk, initKeys[4]) * _positionSpeed / _fps;
+			hs.vz[i] = nsSigned(tk, initKeys[5]) * _positionSpeed / _fps;
+			hs.maxSpeedFraction[i] = nsUniform(tk, initKeys[6]);
+			hs.present[i] = 1;
+			hs.cuid[i] = 0;
+		}
 	}
+
+	// Calculate the probability that a trackable becomes present or absent
+	float rapidnessMultiplier = 1.0 / (1.0 + _fps * presenceReturnRapidness);
+	float probBecomesPresent = targetPresenceDensity / max(targetPresenceDensity, float(1.0 - targetPresenceDensity)) * rapidnessMultiplier;
+	float probBecomesAbsent = (1.0 - targetPresenceDensity) / max(targetPresenceDensity, float(1.0 - targetPresenceDensity)) * rapidnessMultiplier;
+
+	// Elastic forces
+	float margin = MAX(0.1f * (_hiBound - _loBound), 1.0E-6f);
+	float innerLo = _loBound + margin;
+	float innerHi = _hiBound - margin;
+	float forceScale = elasticForce / margin / _fps;
+	float windScale = elasticWinds / _fps;
+	float brownianSpeed = _positionSpeed / _fps;
+
+	// Keys shared by all trackables this frame: presence, brownian 
+	// motion and position noise
+	uint32_t keys[3];
+	for (uint32_t k = 0; k < 3; k++) keys[k] = nsKey(frame, k);
+	// Winds are smooth value noise over time: each trackable interpolates
+	// between random values at the surrounding whole seconds.
+	double windTime = double(hsFrame) / double(_fps);
+	uint32_t windSecond = uint32_t(floor(windTime));
+	float windMix = float(windTime - floor(windTime));
+	windMix = windMix * windMix * (3.0f - 2.0f * windMix);
+	uint32_t windKeys[2] = { nsKey(windSecond, 3), nsKey(windSecond + 1, 3) };
+
+	// Update all trackables, one chunk per job
+	size_t nChunks = (n + hsChunkSize - 1) / hsChunkSize;
+	hsChunkCounts.assign(nChunks, 0);
+	pool.run(nChunks, [&](size_t chunk) {
+		size_t begin = chunk * hsChunkSize;
+		size_t end = MIN(begin + hsChunkSize, n);
+		size_t count = 0;
+		// (Raw pointers keep the compiler from reloading each array's address
+		// after every store.)
+		float* px = hs.px.data();
+		float* py = hs.py.data();
+		float* pz = hs.pz.data();
+		float* vx = hs.vx.data();
+		float* vy = hs.vy.data();
+		float* vz = hs.vz.data();
+		const float* maxSpeedFraction = hs.maxSpeedFraction.data();
+		uint8_t* present = hs.present.data();
+		uint64_t* cuid = hs.cuid.data();
+		float* ox = hsOutput.x.data();
+		float* oy = hsOutput.y.data();
+		float* oz = hsOutput.z.data();
+		int* oid = hsOutput.id.data();
+		uint64_t* ocuid = hsOutput.cuid.data();
+		for (size_t i = begin; i < end; i++) {
+			uint32_t tk = nsKey(_seed, uint32_t(i));
+
+			// Update whether this trackable is occluded or present.
+			// Trackables get a new cuid after every absence.
+			float prob = nsUniform(tk, keys[0]);
+			uint8_t isPresent = present[i] ? uint8_t(prob >= probBecomesAbsent) : uint8_t(prob < probBecomesPresent);
+			present[i] = isPresent;
+			uint64_t c = cuid[i];
+			if (!isPresent || !_bSetCUID) c = 0;
+			else if (c == 0) c = uint64_t(frame) * uint64_t(n) + i + 1;
+			cuid[i] = c;
+
+			float x = px[i];
+			float y = py[i];
+			float z = pz[i];
+			if (_mode == ELASTIC) {
+
+				// Push trackables back into the inner bounds, with some "winds"
+				float fx = float(x < innerLo) * (innerLo - x) + float(x > innerHi) * (innerHi - x);
+				float fy = float(y < innerLo) * (innerLo - y) + float(y > innerHi) * (innerHi - y);
+				float fz = float(z < innerLo) * (innerLo - z) + float(z > innerHi) * (innerHi - z);
+				glm::vec3 w0 = nsSigned3(tk, windKeys[0]);
+				glm::vec3 w1 = nsSigned3(tk, windKeys[1]);
+				glm::vec3 w = w0 + (w1 - w0) * windMix;
+				fx = fx * forceScale + w.x * windScale;
+				fy = fy * forceScale + w.y * windScale;
+				fz = fz * forceScale + w.z * windScale;
+
+				// Update and clamp the velocity
+				float _vx = vx[i] + fx;
+				float _vy = vy[i] + fy;
+				float _vz = vz[i] + fz;
+				float maxSpeed = brownianSpeed * maxSpeedFraction[i];
+				float speedSq = _vx * _vx + _vy * _vy + _vz * _vz;
+				float k = speedSq > maxSpeed * maxSpeed ? maxSpeed / sqrtf(speedSq) : 1.0f;
+				_vx *= k;
+				_vy *= k;
+				_vz *= k;
+				vx[i] = _vx;
+				vy[i] = _vy;
+				vz[i] = _vz;
+
+				x += _vx;
+				y += _vy;
+				z += _vz;
+			}
+			else {
+				glm::vec3 step = nsSigned3(tk, keys[1]) * brownianSpeed;
+				x += step.x;
+				y += step.y;
+				z += step.z;
+			}
+			px[i] = x;
+			py[i] = y;
+			pz[i] = z;
+
+			// Output the position with noise
+			glm::vec3 noise = nsSigned3(tk, keys[2]) * _positionNoise;
+			ox[i] = x + noise.x;
+			oy[i] = y + noise.y;
+			oz[i] = z + noise.z;
+			oid[i] = _bSetID ? int(i + 1) : 0;
+			ocuid[i] = c;
+
+			count += isPresent;
+		}
+		hsChunkCounts[chunk] = count;
+	});
+
+	// Copy present trackables into the block, each chunk at its offset
+	vector<size_t> offsets(nChunks, 0);
+	size_t total = 0;
+	for (size_t c = 0; c < nChunks; c++) {
+		offsets[c] = total;
+		total += hsChunkCounts[c];
+	}
+	hsBlock.resize(total);
+	pool.run(nChunks, [&](size_t chunk) {
+		size_t begin = chunk * hsChunkSize;
+		size_t end = MIN(begin + hsChunkSize, n);
+		size_t j = offsets[chunk];
+		for (size_t i = begin; i < end; i++) {
+			if (!hs.present[i]) continue;
+			hsBlock.x[j] = hsOutput.x[i];
+			hsBlock.y[j] = hsOutput.y[i];
+			hsBlock.z[j] = hsOutput.z[i];
+			hsBlock.id[j] = hsOutput.id[i];
+			hsBlock.cuid[j] = hsOutput.cuid[i];
+			j++;
+		}
+	});
+
+	args.bHighScale = true;
+	args.block.swap(hsBlock);
+	hsFrame++;
 }
 
 // --------------------------------------------------------------
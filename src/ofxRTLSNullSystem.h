@@ -3,7 +3,10 @@
 #include "ofMain.h"
 
 #include "ofxRemoteUIServer.h"
-#include "ofxTemporalResampler.h"
+#include "ofxRTLSFramePacer.h"
+#include "ofxRTLSWorkerPool.h"
+
+class ofxRTLSNullScenario;
 
 class NullSystemTrackable {
 public:
@@ -27,6 +30,13 @@ public:
 	void setCuid(string _cuid) { cuid = _cuid; bCuid = true; }
 	void clearCuid() { bCuid = false; }
 
+	// Ground truth identity (from scenarios). Real trackables are
+	// numbered from 1; ghost markers are -1.
+	bool hasTruth() { return bTruth; }
+	int getTruth() { return truth; }
+	void setTruth(int _truth) { truth = _truth; bTruth = true; }
+	void clearTruth() { bTruth = false; }
+
 	glm::vec3 force;	// forces
 	glm::vec3 velocity;	// velocity
 	float maxSpeedFraction = 1.0;
@@ -41,6 +51,9 @@ private:
 
 	bool bCuid = false;
 	string cuid;
+
+	bool bTruth = false;
+	int truth = 0;
 };
 
 class _NullSystemTrackable : public NullSystemTrackable {
@@ -48,13 +61,46 @@ public:
 	bool bPresent = true;
 };
 
+// Trackables in structure-of-arrays form, as output by the high-scale generator.
+// (An id or cuid of 0 is absent.)
+class NullSystemBlock {
+public:
+	vector<float> x;
+	vector<float> y;
+	vector<float> z;
+	vector<int> id;
+	vector<uint64_t> cuid;
+
+	size_t size() const { return x.size(); }
+	void resize(size_t n) {
+		x.resize(n);
+		y.resize(n);
+		z.resize(n);
+		id.resize(n);
+		cuid.resize(n);
+	}
+	void swap(NullSystemBlock& other) {
+		x.swap(other.x);
+		y.swap(other.y);
+		z.swap(other.z);
+		id.swap(other.id);
+		cuid.swap(other.cuid);
+	}
+};
+
 // The event args output
 class NullSystemEventArgs : public ofEventArgs {
 public:
 	vector<NullSystemTrackable> trackables;
+	// If the high-scale generator is active, trackables are instead 
+	// provided in this block.
+	bool bHighScale = false;
+	NullSystemBlock block;
 	bool bOverrideContext = false;
 	int systemOverride = 0;
 	int typeOverride = 0;
+	// Time this frame was generated, on the null system's own clock (us)
+	uint64_t sourceTimeMicros = 0;
 };
 
 class ofxRTLSNullSystem : private ofThread {
@@ -63,7 +109,9 @@ public:
 	ofxRTLSNullSystem();
 	~ofxRTLSNullSystem();
 
-	void setup();
+	// Setup the params. Each instance of the Null System that runs at the
+	// same time needs a unique ID, which is added to its param names.
+	void setup(string instanceID = "");
 
 	void start();
 
@@ -73,11 +121,16 @@ public:
 
 	ofEvent< NullSystemEventArgs > newDataReceived;
 
-	float getFrameRate() { return fps; }
+	float getFrameRate();
+	ofxRTLSFramePacer::Stats getPacingStats() { return pacer.getStats(); }
 
 private:
 
 	bool bConnected = false;
+	bool bSetup = false;
+
+	// Prefix of this instance's param names
+	string paramPrefix = "NuS- ";
 
 	void threadedFunction();
 
@@ -128,7 +181,44 @@ private:
 
 	uint64_t cuidCounter = 1;
 
+	// The high-scale generator stores trackables as arrays, is split into
+	// chunks across threads and is deterministic: all random values are 
+	// hashed from the seed, trackable index and frame index, so output 
+	// is the same for any number of threads. Time is virtual (frames / fps).
+	bool bHighScale = false;
+	int seed = 1;
+	int nThreads = 0; // 0 uses all cores
+	atomic<bool> flagRestartHighScale = true;
+	void getNextFrameHighScale(NullSystemEventArgs& args);
+	struct HighScaleState {
+		vector<float> px, py, pz;		// known positions
+		vector<float> vx, vy, vz;		// velocities
+		vector<float> maxSpeedFraction;
+		vector<uint8_t> present;
+		vector<uint64_t> cuid;
+		size_t size() { return px.size(); }
+		void resize(size_t n);
+	} hs;
+	// Frame index since the high-scale generator restarted
+	uint64_t hsFrame = 0;
+	// Output of every trackable (before removing absent trackables)
+	NullSystemBlock hsOutput;
+	// Block swapped into the event args, kept to reuse its memory
+	NullSystemBlock hsBlock;
+	// Number of trackables per chunk
+	const size_t hsChunkSize = 4096;
+	vector<size_t> hsChunkCounts;
+	ofxRTLSWorkerPool pool;
+	int poolThreads = -1;
+
+	// Scripted scenarios (see ofxRTLSNullScenario) replace the generators
+	// above and set their own frame rate.
+	bool bScenario = false;
+	string scenarioPath = "";
+	atomic<bool> flagLoadScenario = true;
+	ofxRTLSNullScenario* scenario = NULL;
+
 	// dynamically sets the output frame rate
 	void paramChanged(RemoteUIServerCallBackArg& arg);
-	ofxTemporalResampler temporalResampler;
+	ofxRTLSFramePacer pacer;
 };
\ No newline at end of file
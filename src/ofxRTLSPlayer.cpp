@@ -32,6 +32,8 @@ void ofxRTLSPlayer::setup() {
 	RUI_SHARE_PARAM_WCN("RTLS-P- Override Realtime Data", bOverridesRealtimeData);
 	RUI_SHARE_PARAM_WCN("RTLS-P- Window Start Time", windowStartTime, 0, 1000);
 	RUI_SHARE_PARAM_WCN("RTLS-P- Window Stop Time", windowStopTime, 0, 1000);
+	RUI_SHARE_PARAM_WCN("RTLS-P- Keyframe Period Sec", keyframePeriodSec, 0.1, 60);
+	RUI_SHARE_PARAM_WCN("RTLS-P- Warmup Sec", warmupSec, -1, 60);
 	allowSystemTypes.resize(int(NUM_RTLS_SYSTEM_TYPES));
 	for (int i = 0; i < int(NUM_RTLS_SYSTEM_TYPES); i++) {
 		RUI_SHARE_PARAM_WCN("RTLS-P- Allow System " +
@@ -86,8 +88,8 @@ void ofxRTLSPlayer::threadedFunction() {
 		// Reset the playback flag
 		flagPlaybackChange = false;
 
-		// Reset the dynamic fps resampler
-		resampler.reset();
+		// Re-anchor the frame pacer
+		pacer.reset();
 
 		// Load the next take
 		//take = NULL; // delete remaining takes? // take should be null
@@ -118,6 +120,8 @@ void ofxRTLSPlayer::threadedFunction() {
 				// ... and load this one.
 				take = nextTake;
 				nextTake = NULL;
+				clearKeyframes();
+				nextContinuousFrame = -1;
 				if (loadTake(take)) { // Success loading
 					ofLogNotice("ofxRTLSPlayer") << "Loaded take \"" << take->path << "\"";
 					// Set new take parameters
@@ -130,7 +134,7 @@ void ofxRTLSPlayer::threadedFunction() {
 						durationSec = take->getC3dDurationSec();
 						fps = take->getC3dFps();
 						numFrames = take->getC3dNumFrames();
-						resampler.setDesiredFPS(fps);
+						pacer.setDesiredFPS(fps);
 						windowStartTime = MIN(oldWindowStartTime, take->getC3dDurationSec());
 						windowStopTime = MIN(oldWindowStopTime, take->getC3dDurationSec());
 					}
@@ -195,19 +199,32 @@ void ofxRTLSPlayer::threadedFunction() {
 
 				// Signal that filters need to be reset
 				notifyResetPostprocessors(take);
+				nextContinuousFrame = -1;
 
 				// We've stopped playing, so break from this loop.
 				break;
 			}
 
-			// If this frame is zero, reset the postprocessors
-			if (take->frameCounter == windowStartFrame) notifyResetPostprocessors(take);
+			// Seek, if requested
+			if (flagSeek) {
+				flagSeek = false;
+				take->frameCounter = MIN(MAX(uint64_t(seekFrame), windowStartFrame), windowStopFrame - 1);
+			}
+
+			// Wait until this frame is due
+			pacer.waitForNextFrame();
+
+			// If this frame doesn't continue uninterrupted playback (since we are
+			// starting to play, have looped or have seeked), then bring the 
+			// postprocessors up to this frame.
+			if (int64_t(take->frameCounter) != nextContinuousFrame) warmStart(take, take->frameCounter);
 
 			// At this point, we have a valid take and are playing.
 			// Attempt to read the next frame and send it.
-			if (getFrames(take)) {
-				sendData(take);
+			if (getFrames(take, take->frameCounter)) {
+				sendData(take, take->frameCounter);
 			}
+			nextContinuousFrame = take->frameCounter + 1;
 
 			// Increment the frame counter
 			take->frameCounter++;
@@ -217,12 +234,6 @@ void ofxRTLSPlayer::threadedFunction() {
 			}
 			// Update atomic external-facing variables
 			frameCounter = take->frameCounter;
-			// TODO: If we loop, signal that filters need to be reset
-			
-			// Update the fps resampler
-			resampler.update();
-			// Sleep according to the resampler
-			sleep(resampler.getSleepDurationMS());
 		}
 	}
 }
@@ -282,6 +293,16 @@ void ofxRTLSPlayer::reset() {
 	cv.notify_one();
 }
 
+// --------------------------------------------------------------
+void ofxRTLSPlayer::seek(float timeSec) {
+	if (!isSetup) return;
+
+	seekFrame = uint64_t(round(MAX(timeSec, 0.0f) * fps));
+	flagSeek = true;
+	// Update atomic external-facing variables
+	frameCounter = MIN(uint64_t(seekFrame), MAX(uint64_t(numFrames), uint64_t(1)) - 1);
+}
+
 // --------------------------------------------------------------
 void ofxRTLSPlayer::togglePlayback() {
 
@@ -336,43 +357,9 @@ bool ofxRTLSPlayer::loadTake(RTLSPlayerTake* take) {
 	if (take == NULL) return false;
 	if (take->path.empty()) return false;
 
-	// Attempt to load the c3d file
-	bool bSuccess = false;
-	try {
-		if (take->c3d != NULL) { // should not get to this point...
-			take->c3d->~c3d();
-			delete take->c3d;
-		}
-		take->c3d = new ezc3d::c3d(take->path);
-		bSuccess = true;
-	}
-	catch (const std::exception&) {
-		ofLogError("ofxRTLSPlayer") << "Could not read c3d file \"" << take->path << "\"";
-	}
-	if (!bSuccess) return false;
-
-	// Make sure this c3d file has been generated by RTLS and
-	// not another program.
-	// Parameters: MANUFACTURER > SOFTWARE > RTLSServer
-	vector<string> values(take->c3d->parameters().group("MANUFACTURER").parameter("SOFTWARE").valuesAsString());
-	if (values.empty()) return false;
-	string software = ofTrim(ofToLower(values.front()));
-	if (software.compare("rtlsserver") != 0) {
-		ofLogError("ofxRTLSPlayer") << "Cannot play a c3d file generated by a different utility.";
-		return false;
-	}
+	// Attempt to load the c3d file and its template frames
+	bool bSuccess = take->load();
 
-	// Try to populate the take with template frames
-	bSuccess = false;
-	try {
-		bSuccess = take->populateTemplateFrames();
-	}
-	catch (const std::exception&) {
-		bSuccess = false;
-	}
-	if (!bSuccess) {
-		ofLogError("ofxRTLSPlayer") << "Could not parse take's data.";
-	}
 	// Store all systems that will be playing
 	if (bSuccess) {
 		std::lock_guard<std::mutex> lk(mutex);
@@ -445,7 +432,7 @@ void ofxRTLSPlayer::recordingEvent(ofxRTLSRecordingArgs& args) {
 }
 
 // --------------------------------------------------------------
-bool ofxRTLSPlayer::getFrames(RTLSPlayerTake* take) {
+bool ofxRTLSPlayer::getFrames(RTLSPlayerTake* take, uint64_t frameIndex) {
 	if (!isSetup) return false;
 	if (take == NULL) return false;
 	if (take->c3d == NULL) return false;
@@ -454,7 +441,7 @@ bool ofxRTLSPlayer::getFrames(RTLSPlayerTake* take) {
 	take->flagAllFramesOld();
 
 	// Get points for this take
-	auto pts = take->c3d->data().frame(take->frameCounter).points();
+	auto pts = take->c3d->data().frame(frameIndex).points();
 	// Proceed even if it's empty (pts.isEmpty()), so frames without
 	// data can still be processed by the postprocessor, if enabled.
 
@@ -472,41 +459,30 @@ bool ofxRTLSPlayer::getFrames(RTLSPlayerTake* take) {
 		}
 		if (bContinue) continue;
 
-		auto& frame = _f.newFrame;
-		auto& refFrame = _f.frame;
-
-		// Prepare the frame for incoming data
-		frame.Clear();
-		frame.CopyFrom(refFrame);
-		frame.clear_trackables();
-		// Set all relevant points, filling the frame with data from the c3d file
-		for (int index = 0; index < _f.dataIndices.size(); index++) {
-			// "index" indicates the index of a trackable in the refFrame
-			// "ptIndex" will indicate the corresponding point in the c3d file's list of points
-			int ptIndex = _f.dataIndices[index];
-			if (pts.point(ptIndex).isValid()) {
-				Trackable* tk = frame.add_trackables();
-				tk->CopyFrom(refFrame.trackables(index));
-				Trackable::Position* position = tk->mutable_position();
-				position->set_x(pts.point(ptIndex).x());
-				position->set_y(pts.point(ptIndex).y());
-				position->set_z(pts.point(ptIndex).z());
-				_f.bNewData = true;
-			}
-		}
-
-		// Set the frame ID
-		frame.set_frame_id(take->frameCounter);
+		// Fill this frame with data
+		take->readFrame(_f, pts, frameIndex);
 	}
 
 	return true;
 }
 
 // --------------------------------------------------------------
-void ofxRTLSPlayer::sendData(RTLSPlayerTake* take) {
+void ofxRTLSPlayer::sendData(RTLSPlayerTake* take, uint64_t frameIndex, bool bReplay) {
 	if (!isSetup) return;
 	if (take == NULL) return;
 
+	ofxRTLSPlaybackInfo playback;
+	playback.bValid = true;
+	playback.frameIndex = frameIndex;
+	playback.timeMS = uint64_t(round(double(frameIndex) * 1000.0 / take->getC3dFps()));
+	playback.generation = keyframeGeneration;
+	playback.bReplay = bReplay;
+	// Capture keyframes periodically, as long as the postprocessors
+	// have processed every frame since the beginning of the take
+	uint64_t keyframePeriod = MAX(uint64_t(round(keyframePeriodSec * take->getC3dFps())), uint64_t(1));
+	playback.bKeyframe = bUninterrupted && frameIndex % keyframePeriod == 0 &&
+		!hasKeyframe(take, frameIndex);
+
 	// Send every frame
 	for (int i = 0; i < take->frames.size(); i++) {
 
@@ -518,6 +494,7 @@ void ofxRTLSPlayer::sendData(RTLSPlayerTake* take) {
 		args.frame.CopyFrom(take->frames[i].newFrame);
 		args.systemType = take->frames[i].systemType;
 		args.trackableType = take->frames[i].trackableType;
+		args.playback = playback;
 		ofNotifyEvent(newPlaybackData, args);
 	}
 }
@@ -583,5 +560,104 @@ bool ofxRTLSPlayer::frameExceedsWindow(uint64_t counter)
 }
 
 // --------------------------------------------------------------
+void ofxRTLSPlayer::postprocessorStateCaptured(ofxRTLSPostprocessorStateArgs& args) {
+
+	std::lock_guard<std::mutex> lk(keyframeMutex);
+	// Ignore states captured for keyframes that have since been cleared
+	if (args.playback.generation != keyframeGeneration) return;
+	keyframes[make_pair(args.systemType, args.trackableType)][args.playback.frameIndex] = args.state;
+}
+
+// --------------------------------------------------------------
+uint64_t ofxRTLSPlayer::getNumKeyframes() {
+
+	std::lock_guard<std::mutex> lk(keyframeMutex);
+	uint64_t n = 0;
+	for (auto& it : keyframes) n += it.second.size();
+	return n;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPlayer::clearKeyframes() {
+
+	std::lock_guard<std::mutex> lk(keyframeMutex);
+	keyframes.clear();
+	keyframeGeneration++;
+}
 
-// --------------------------------------------------------------
\ No newline at end of file
+// --------------------------------------------------------------
+bool ofxRTLSPlayer::hasKeyframe(RTLSPlayerTake* take, uint64_t frameIndex) {
+
+	std::lock_guard<std::mutex> lk(keyframeMutex);
+	for (auto& f : take->frames) {
+		auto it = keyframes.find(make_pair(f.systemType, f.trackableType));
+		if (it == keyframes.end()) return false;
+		if (it->second.find(frameIndex) == it->second.end()) return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPlayer::warmStart(RTLSPlayerTake* take, uint64_t frameIndex) {
+
+	// Replay enough frames to warm up the filters
+	float _warmupSec = warmupSec;
+	uint64_t warmupFrames = uint64_t(round(MAX(_warmupSec, 0.0f) * take->getC3dFps()));
+	uint64_t startFrame = 0;
+	if (_warmupSec >= 0 && frameIndex > warmupFrames) startFrame = frameIndex - warmupFrames;
+
+	// Find the latest keyframe at or before the start frame that
+	// contains states for all of this take's postprocessors.
+	ofxRTLSPlayerRestoreArgs args;
+	bool bFound = false;
+	{
+		std::lock_guard<std::mutex> lk(keyframeMutex);
+		auto it = keyframes.find(make_pair(take->frames.front().systemType, take->frames.front().trackableType));
+		if (it != keyframes.end()) {
+			auto kf = it->second.upper_bound(startFrame);
+			while (kf != it->second.begin() && !bFound) {
+				kf--;
+				uint64_t keyframeIndex = kf->first;
+				args.entries.clear();
+				bFound = true;
+				for (auto& f : take->frames) {
+					auto it2 = keyframes.find(make_pair(f.systemType, f.trackableType));
+					if (it2 == keyframes.end() || it2->second.find(keyframeIndex) == it2->second.end()) {
+						bFound = false;
+						break;
+					}
+					ofxRTLSPlayerRestoreArgs::Entry entry;
+					entry.systemType = f.systemType;
+					entry.trackableType = f.trackableType;
+					entry.state = it2->second[keyframeIndex];
+					args.entries.push_back(entry);
+				}
+				if (bFound) startFrame = keyframeIndex;
+			}
+		}
+	}
+	// If no keyframe was found, the postprocessors are reset
+	// (restored with empty states).
+	if (!bFound) {
+		args.entries.clear();
+		for (auto& f : take->frames) {
+			ofxRTLSPlayerRestoreArgs::Entry entry;
+			entry.systemType = f.systemType;
+			entry.trackableType = f.trackableType;
+			args.entries.push_back(entry);
+		}
+	}
+	ofNotifyEvent(restorePostprocessors, args);
+
+	// Filters are only in the same state as uninterrupted playback if they
+	// have processed every frame since the beginning of the take.
+	bUninterrupted = startFrame == 0;
+
+	// Replay the frames up to this one
+	for (uint64_t i = startFrame; i < frameIndex; i++) {
+		if (getFrames(take, i)) sendData(take, i, true);
+	}
+	nextContinuousFrame = frameIndex;
+}
+
+// --------------------------------------------------------------
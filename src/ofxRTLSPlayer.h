@@ -10,7 +10,7 @@ using namespace RTLSProtocol;
 #include "ofxRTLSTrackableKey.h"
 
 #include "ezc3d_all.h"
-#include "ofxTemporalResampler.h"
+#include "ofxRTLSFramePacer.h"
 
 class ofxRTLSPlayerDataArgs : public ofEventArgs {
 public:
@@ -18,6 +18,7 @@ public:
 	TrackableFrame frame;
 	RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
 	RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
+	ofxRTLSPlaybackInfo playback;
 };
 
 // Locking with Condition Variables, Queues and Mutex follows the 
@@ -54,12 +55,16 @@ public:
 	float getTakeFPS() { return fps; }
 	uint64_t getTakeNumFrames() { return numFrames; }
 	float getTakePercentComplete();
+	ofxRTLSFramePacer::Stats getPacingStats() { return pacer.getStats(); }
 	void setLooping(bool _bLoop);
 	bool isLooping() { return bLoop; }
 
 	void play();
 	void pause();
 	void reset(); // to frame 0
+	// Seek to a time (in seconds) in the take. Postprocessors resume from
+	// the nearest keyframe before this time.
+	void seek(float timeSec);
 	void togglePlayback();
 	bool isPlaying() { return bPlaying; }
 	bool isPlaying(RTLSSystemType systemType);
@@ -80,8 +85,18 @@ public:
 	// This event is notified when we pause or play
 	ofEvent<ofxRTLSPlaybackArgs> playbackEvent;
 
+	// This is called when a postprocessor has captured its state at a keyframe.
+	// (Must manually add a listener.)
+	void postprocessorStateCaptured(ofxRTLSPostprocessorStateArgs& args);
+
+	// This event is notified when postprocessors should restore their states
+	ofEvent<ofxRTLSPlayerRestoreArgs> restorePostprocessors;
+
 	string getStatus();
 
+	// Number of keyframes held for the loaded take (across all postprocessors)
+	uint64_t getNumKeyframes();
+
 private:
 
 	bool bEnablePlayer = true;
@@ -140,14 +155,45 @@ private:
 	// from the same system?
 	bool bOverridesRealtimeData = true;
 
-	// TODO: Flag when a file starts again, so
-	// filters can be restarted
-
-	ofxTemporalResampler resampler;
+	// Paces playback at the take's frame rate
+	ofxRTLSFramePacer pacer;
+
+	// Keyframes are postprocessor states captured periodically during 
+	// uninterrupted playback from the beginning of a take. When playback
+	// jumps (seeking, looping or starting to play at a later frame), 
+	// postprocessors are restored from the latest keyframe and the frames
+	// between it and the new frame are replayed (not sent out), so
+	// postprocessors resume as if playback had been uninterrupted.
+	// Keyframes are kept for the loaded take.
+	float keyframePeriodSec = 1.0;
+	// Filter states cannot be captured, so filters are warmed up by
+	// replaying at least this many seconds before the new frame.
+	// If negative, frames are always replayed from the beginning of the take.
+	float warmupSec = 2.0;
+	std::mutex keyframeMutex;
+	// Map of system and trackable type to the frame index of each keyframe
+	// and its postprocessor state
+	map< pair<RTLSSystemType, RTLSTrackableType>, map<uint64_t, string> > keyframes;
+	// States captured for a different generation of keyframes are ignored
+	atomic<uint64_t> keyframeGeneration = 0;
+	void clearKeyframes();
+	bool hasKeyframe(RTLSPlayerTake* take, uint64_t frameIndex);
+	// Restore the postprocessors and replay frames, so this frame
+	// can be played next
+	void warmStart(RTLSPlayerTake* take, uint64_t frameIndex);
+	// Which frame continues uninterrupted playback? (-1 if none)
+	int64_t nextContinuousFrame = -1;
+	// Have the postprocessors processed every frame since the 
+	// beginning of the take?
+	bool bUninterrupted = false;
+
+	// Frame to seek to
+	atomic<bool> flagSeek = false;
+	atomic<uint64_t> seekFrame = 0;
 
 	// Get frames from data
-	bool getFrames(RTLSPlayerTake* take);
-	void sendData(RTLSPlayerTake* take);
+	bool getFrames(RTLSPlayerTake* take, uint64_t frameIndex);
+	void sendData(RTLSPlayerTake* take, uint64_t frameIndex, bool bReplay = false);
 	// Allow certain types of data through
 	struct Allow {
 		bool allow = true;
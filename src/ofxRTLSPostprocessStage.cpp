@@ -0,0 +1,97 @@
+#include "ofxRTLSPostprocessStage.h"
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessStage::recordFrame(uint64_t micros, size_t nIn, size_t nOut) {
+
+	stats.nFrames++;
+	stats.lastMicros = micros;
+	stats.maxMicros = MAX(stats.maxMicros, micros);
+	stats.meanMicros += (double(micros) - stats.meanMicros) / double(stats.nFrames);
+	stats.nIn = nIn;
+	stats.nOut = nOut;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSPostprocessStage::getContextValue(const Trackable* t, const string& key, float& value) {
+
+	if (t == NULL || key.empty()) return false;
+	const string& context = t->context();
+	if (context.size() < key.size() + 4) return false;
+
+	// This runs for every trackable of every frame, so the context is
+	// scanned in place for a top level key, rather than parsed.
+	const char* c = context.c_str();
+	const char* end = c + context.size();
+	int depth = 0;
+	bool bKey = false;	// is the next string at the top level a key?
+	while (c < end) {
+		char ch = *c;
+		if (ch == '"') {
+			// Find the end of this string
+			const char* begin = ++c;
+			while (c < end && *c != '"') c += (*c == '\\') ? 2 : 1;
+			if (c >= end) return false;
+			bool bMatch = bKey && depth == 1 && size_t(c - begin) == key.size() &&
+				memcmp(begin, key.data(), key.size()) == 0;
+			c++;
+			if (!bMatch) {
+				bKey = false;
+				continue;
+			}
+			// Read the value
+			while (c < end && (isspace((unsigned char)*c) || *c == ':')) c++;
+			char* valueEnd = NULL;
+			float v = strtof(c, &valueEnd);
+			if (valueEnd == c) return false;
+			value = v;
+			return true;
+		}
+		if (ch == '{' || ch == '[') depth++;
+		else if (ch == '}' || ch == ']') depth--;
+		if (ch == '{' || ch == ',') bKey = true;
+		else if (ch == ':') bKey = false;
+		c++;
+	}
+	return false;
+}
+
+// --------------------------------------------------------------
+ofxRTLSPostprocessStageRegistry* ofxRTLSPostprocessStageRegistry::instance = NULL;
+
+// --------------------------------------------------------------
+ofxRTLSPostprocessStageRegistry* ofxRTLSPostprocessStageRegistry::one() {
+	if (!instance) {
+		instance = new ofxRTLSPostprocessStageRegistry();
+	}
+	return instance;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessStageRegistry::add(string type, Factory factory) {
+
+	std::lock_guard<std::mutex> lk(mutex);
+	if (factories.find(type) != factories.end()) {
+		ofLogWarning("ofxRTLSPostprocessStageRegistry") << "Replacing the stage type \"" << type << "\".";
+	}
+	factories[type] = factory;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSPostprocessStageRegistry::has(string type) {
+
+	std::lock_guard<std::mutex> lk(mutex);
+	return factories.find(type) != factories.end();
+}
+
+// --------------------------------------------------------------
+ofxRTLSPostprocessStage* ofxRTLSPostprocessStageRegistry::create(string type) {
+
+	Factory factory;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		auto it = factories.find(type);
+		if (it == factories.end()) return NULL;
+		factory = it->second;
+	}
+	return factory();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSTypes.h"
+#include "ofxRTLSWorkingSet.h"
+#include "ofxRTLSPostprocessorParams.h"
+
+// A stage of a postprocessing pipeline. Stages operate in order on the
+// working set of each frame (see ofxRTLSWorkingSet).
+// Pipelines are declared as a list of stages, each either the type of
+// a stage or an object with the keys:
+//	"type"		type of the stage (required)
+//	"name"		name of the stage in diagnostics (defaults to the type)
+//	"enabled"	whether the stage runs (defaults to true)
+//	"optional"	whether the stage may be skipped when a frame is projected to
+//				exceed its budget (defaults to false; see ofxRTLSFrameBudget)
+//	"costExponent"	how the cost of the stage grows with the number of 
+//				trackables (defaults to 1, or 2 for the Hungarian stage)
+// All other keys are passed to the stage's setup().
+// Built-in stages are "mapIDs", "removeUnidentifiable", "hungarian",
+// "filters", "decodeIDs" (see ofxRTLSIDDecodeStage), "decodeBlinks" (see
+// ofxRTLSBlinkDecodeStage) and "predict" (see ofxRTLSPredictStage). Other
+// types of stages can be registered by the application with
+// ofxRTLSPostprocessStageRegistry (before ofxRTLS is setup).
+// A pipeline may instead be an object with its shared "stages" and named
+// "outputs", each a list of stages that runs on a copy of the shared result
+// (see ofxRTLSPostprocessor).
+class ofxRTLSPostprocessStage {
+public:
+
+	ofxRTLSPostprocessStage() {};
+	virtual ~ofxRTLSPostprocessStage() {};
+
+	// Information about the frame being processed
+	struct Context {
+		RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+		RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
+		// Time of the frame (ms), and more precisely (us)
+		uint64_t timeMS = 0;
+		uint64_t timeMicros = 0;
+		// Whether the frame is played back or processed headless (and so
+		// timed in its take, not by the server's clock)
+		bool bPlayback = false;
+		// Number of trackables in the frame as received
+		size_t nTrackables = 0;
+		// Degradations applied to meet the frame's budget
+		// (flags of ofxRTLSFrameBudget::Degradation)
+		uint32_t degradations = 0;
+		// Parameters of the postprocessor for this frame
+		shared_ptr<const ofxRTLSPostprocessorParams> params;
+	};
+
+	// Setup the stage with its entry in the pipeline.
+	virtual void setup(const ofJson& /*settings*/) {};
+	// Process the working set of a frame. Rows this stage removes are
+	// compacted before the next stage, so stages only see remaining rows.
+	virtual void process(ofxRTLSWorkingSet& ws, const Context& context) = 0;
+	// Reset any histories (e.g. when a take loops)
+	virtual void reset() {};
+	// Does this stage replace the keys of trackables (e.g. with decoded IDs)?
+	// If it follows the Hungarian stage, the Hungarian stage matches each 
+	// frame to its own output of the previous frame, so it keeps tracking
+	// the keys it assigned.
+	virtual bool replacesKeys() { return false; }
+	virtual bool isEnabled() { return bEnabled; }
+	void setEnabled(bool _bEnabled) { bEnabled = _bEnabled; }
+	bool isOptional() { return bOptional; }
+	double getCostExponent() { return costExponent; }
+
+	string getType() { return type; }
+	string getName() { return name; }
+
+	// Timing and counters of a stage
+	struct Stats {
+		string name = "";
+		uint64_t nFrames = 0;
+		uint64_t lastMicros = 0;
+		uint64_t maxMicros = 0;
+		double meanMicros = 0;
+		// Number of trackables into and out of the stage (last frame)
+		uint64_t nIn = 0;
+		uint64_t nOut = 0;
+		// Counters kept by the stage itself
+		map<string, uint64_t> counters;
+	};
+	// (Only call this from the processing thread or on headless postprocessors.)
+	const Stats& getStats() { return stats; }
+
+	// Record the processing of a frame.
+	// (This is called by the postprocessor after each frame.)
+	void recordFrame(uint64_t micros, size_t nIn, size_t nOut);
+
+protected:
+
+	// Add to a counter of this stage
+	void count(const string& counter, uint64_t n = 1) { stats.counters[counter] += n; }
+
+	// Get a number from the json context of a trackable (e.g. {"b":0.8}).
+	// Returns false if it has none. The context is scanned without being
+	// parsed, so this is cheap enough to call for every trackable.
+	static bool getContextValue(const Trackable* t, const string& key, float& value);
+
+private:
+
+	friend class ofxRTLSPostprocessor;
+	string type = "";
+	string name = "";
+	bool bEnabled = true;
+	bool bOptional = false;
+	double costExponent = 1.0;
+	Stats stats;
+};
+
+// Creates stages of the types registered by the application
+class ofxRTLSPostprocessStageRegistry {
+public:
+
+	static ofxRTLSPostprocessStageRegistry* one();
+
+	typedef function<ofxRTLSPostprocessStage*()> Factory;
+
+	// Register a type of stage, e.g.:
+	//	ofxRTLSPostprocessStageRegistry::one()->add("myStage", []() { return new MyStage(); });
+	void add(string type, Factory factory);
+	bool has(string type);
+	// Create a stage of this type (NULL if it is not registered)
+	ofxRTLSPostprocessStage* create(string type);
+
+private:
+
+	static ofxRTLSPostprocessStageRegistry* instance;
+
+	ofxRTLSPostprocessStageRegistry() {};
+	~ofxRTLSPostprocessStageRegistry() {};
+
+	std::mutex mutex;
+	map<string, Factory> factories;
+};
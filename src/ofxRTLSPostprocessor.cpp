@@ -1,4 +1,89 @@
 #include "ofxRTLSPostprocessor.h"
+#include "ofxRTLSConfigManager.h"
+#include "ofxRTLSIDDecodeStage.h"
+#include "ofxRTLSBlinkDecodeStage.h"
+#include "ofxRTLSPredictStage.h"
+#include <cfloat>
+
+// Built-in stages run the processing functions of a postprocessor.
+class ofxRTLSBuiltinStage : public ofxRTLSPostprocessStage {
+public:
+	typedef void (ofxRTLSPostprocessor::*Function)(ofxRTLSWorkingSet& ws, const Context& context);
+
+	ofxRTLSBuiltinStage(ofxRTLSPostprocessor* _pp, Function _function) {
+		pp = _pp;
+		function = _function;
+	}
+
+	void process(ofxRTLSWorkingSet& ws, const Context& context) { (pp->*function)(ws, context); }
+
+private:
+	ofxRTLSPostprocessor* pp = NULL;
+	Function function = NULL;
+};
+
+// --------------------------------------------------------------
+static inline uint64_t getGridCell(int x, int y, int z) {
+	// Distant cells may share a bucket, which only adds candidates
+	return (uint64_t(x & 0x1FFFFF) << 42) | (uint64_t(y & 0x1FFFFF) << 21) | uint64_t(z & 0x1FFFFF);
+}
+
+// --------------------------------------------------------------
+// Get the squared distance from each sample to the nearest of the others,
+// if within the radius (or FLT_MAX), using a grid of cells of the radius.
+static void getNearestDistances(const vector<HungarianSample>& samples,
+	const vector<HungarianSample>& others, float radius, vector<float>& distances) {
+
+	unordered_map<uint64_t, vector<size_t> > grid;
+	for (size_t i = 0; i < others.size(); i++) {
+		const glm::vec3& q = others[i].position;
+		grid[getGridCell(int(floor(q.x / radius)), int(floor(q.y / radius)), int(floor(q.z / radius)))].push_back(i);
+	}
+
+	float radius2 = radius * radius;
+	distances.assign(samples.size(), FLT_MAX);
+	for (size_t i = 0; i < samples.size(); i++) {
+		const glm::vec3& q = samples[i].position;
+		int cx = int(floor(q.x / radius));
+		int cy = int(floor(q.y / radius));
+		int cz = int(floor(q.z / radius));
+		for (int x = cx - 1; x <= cx + 1; x++) {
+			for (int y = cy - 1; y <= cy + 1; y++) {
+				for (int z = cz - 1; z <= cz + 1; z++) {
+					auto it = grid.find(getGridCell(x, y, z));
+					if (it == grid.end()) continue;
+					for (size_t j : it->second) {
+						glm::vec3 d = q - others[j].position;
+						float d2 = glm::dot(d, d);
+						if (d2 <= radius2 && d2 < distances[i]) distances[i] = d2;
+					}
+				}
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------------
+// Keep the n samples with the smallest distances (in their original order),
+// optionally collecting the others.
+static void keepNearestSamples(vector<HungarianSample>& samples, const vector<float>& distances,
+	size_t n, vector<HungarianSample>* excluded) {
+
+	if (samples.size() <= n) return;
+	vector<size_t> order(samples.size());
+	for (size_t i = 0; i < order.size(); i++) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+
+	vector<bool> keep(samples.size(), false);
+	for (size_t i = 0; i < n; i++) keep[order[i]] = true;
+	vector<HungarianSample> kept;
+	kept.reserve(n);
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (keep[i]) kept.push_back(samples[i]);
+		else if (excluded != NULL) excluded->push_back(samples[i]);
+	}
+	samples.swap(kept);
+}
 
 // --------------------------------------------------------------
 ofxRTLSPostprocessor::ofxRTLSPostprocessor() {
@@ -12,9 +97,21 @@ ofxRTLSPostprocessor::~ofxRTLSPostprocessor() {
 	flagUnlock = true;
 	// Signal the conditional variable
 	cv.notify_one();
+	drainCv.notify_all();
 
 	// Stop this thread and wait for it to complete
 	waitForThread(true);
+
+	// Stop the threads of the other segments
+	stopSegments();
+
+	if (!bHeadless) ofRemoveListener(RUI_GET_OF_EVENT(), this, &ofxRTLSPostprocessor::paramChanged);
+	delete pendingParams.exchange(NULL);
+
+	if (cuidGen != NULL) {
+		delete cuidGen;
+		cuidGen = NULL;
+	}
 }
 
 // --------------------------------------------------------------
@@ -26,6 +123,7 @@ void ofxRTLSPostprocessor::setup(RTLSSystemType _systemType, RTLSTrackableType _
 	name = _name;
 	abbr = _abbr;
 	dictPath = _dictPath;
+	filterList = _filterList;
 
 	// Setup postprocessing params
 	string ruiGroupFull = "ofxRTLSPostprocessor - " + name;
@@ -36,13 +134,15 @@ void ofxRTLSPostprocessor::setup(RTLSSystemType _systemType, RTLSTrackableType _
 	RUI_SHARE_PARAM_WCN(ruiGroupAbbr + "- Apply Hungarian", bApplyHungarian);
 	RUI_SHARE_PARAM_WCN(ruiGroupAbbr + "- Remove UnID Before Filters", bRemoveUnidentifiableBeforeFilters);
 	RUI_SHARE_PARAM_WCN(ruiGroupAbbr + "- Apply Filters", bApplyFilters);
+	RUI_SHARE_PARAM_WCN(ruiGroupAbbr + "- Pipeline Threads", pipelineThreads, 1, 16);
+	RUI_SHARE_PARAM_WCN(ruiGroupAbbr + "- Frame Budget Micros", frameBudgetMicros, 0, 1000000);
+	RUI_SHARE_PARAM_WCN(ruiGroupAbbr + "- Degradations", degradationsStr);
+	RUI_SHARE_PARAM_WCN(ruiGroupAbbr + "- Degraded Hungarian Max Samples", degradedHungarianMaxSamples, 1, 100000);
 	
 	// Setup the dictionary params
 	RUI_NEW_GROUP("IDDictionary - " + abbr);
 	RUI_SHARE_PARAM_WCN("ID_RTLS" + abbr + "- ID Dict Path", dictPath);
-
-	// Load the dictionary
-	if (!dictPath.empty()) dict.setup(dictPath);
+	RUI_SHARE_PARAM_WCN("ID_RTLS" + abbr + "- ID Dict Auto Reload", bDictAutoReload);
 
 	// Setup the hungarian algorithm
 	RUI_NEW_GROUP("Hungarian - " + abbr);
@@ -52,46 +152,653 @@ void ofxRTLSPostprocessor::setup(RTLSSystemType _systemType, RTLSTrackableType _
 	vector<string> hungarianMappings = { "Temporary", "Permanent", "Both" };
 	RUI_SHARE_ENUM_PARAM_WCN("HU_RTLS" + abbr + "- From Dataset Permanence", hungarianMappingFrom, HungarianMapping::TEMPORARY, HungarianMapping::TEMPORARY_AND_PERMANENT, hungarianMappings);
 	RUI_SHARE_ENUM_PARAM_WCN("HU_RTLS" + abbr + "- To Dataset Permanence", hungarianMappingTo, HungarianMapping::TEMPORARY, HungarianMapping::TEMPORARY_AND_PERMANENT, hungarianMappings);
-	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Map Recursion Limit", keyMappingRecursionLimit, 0, 10000);
+	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Mapping Horizon Sec", mappingHorizonSec, 0, 100000);
+	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Mapping Horizon Frames", mappingHorizonFrames, 0, 10000000);
 	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Remove Matching Keys", bRemoveMatchingKeysBeforeSolve);
 	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Assign CUIDs to UnID", bAssignCuidsToUnidentifiableTrackables);
 	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- CUID Start Counter", cuidStartCounter, 0, 1000000);
 	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Allow Remap From Perm", bAllowRemappingFromPermKeyTypes);
 	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Allow Remap To Perm", bAllowRemappingToPermKeyTypes);
+	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Reacquire Lost Tracks", bReacquireLostTracks);
+	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Reacquire Radius", reacquireRadius, 0, 10);
+	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Reacquire Max Sec", reacquireMaxSec, 0, 10);
+	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Reacquire Max Frames", reacquireMaxFrames, 0, 1000);
+	RUI_SHARE_PARAM_WCN("HU_RTLS" + abbr + "- Reacquire Max Prediction Sec", reacquireMaxPredictionSec, 0, 10);
+
+	// Use the pipeline declared in the rtls config for this system and trackable type
+	if (pipelineSettings.is_null()) {
+		pipelineSettings = ofxRTLSConfigManager::one()->pipeline(
+			getRTLSSystemTypeDescription(systemType), getRTLSTrackableTypeDescription(trackableType));
+	}
+
+	setupInternals();
+
+	// Publish the params again whenever they change
+	ofAddListener(RUI_GET_OF_EVENT(), this, &ofxRTLSPostprocessor::paramChanged);
+
+	// Split the stages across threads
+	setupSegments();
+
+	startThread();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::setupHeadless(RTLSSystemType _systemType, RTLSTrackableType _trackableType, 
+	string _name, string _abbr, const ofJson& settings) {
+
+	systemType = _systemType;
+	trackableType = _trackableType;
+	name = _name;
+	abbr = _abbr;
+	bHeadless = true;
+
+	applySettings(settings);
+
+	setupInternals();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::setupInternals() {
+
+	// Load the dictionary
+	if (!dictPath.empty()) dict.setup(dictPath);
+	if (bDictAutoReload) dict.setAutoReload(true);
 
+	// Publish the first snapshot of the params (which parses the key types)
+	publishParams();
+
+	// Setup the CUID generator
+	if (cuidGen != NULL) delete cuidGen;
+	cuidGen = new CuidGenerator(cuidStartCounter);
+
+	// Setup the filters
+	filterState.filters.setup("RTLS-"+abbr, filterList);
+
+	setupPipeline();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::publishParams() {
+
+	ofxRTLSPostprocessorParams* p = new ofxRTLSPostprocessorParams();
+	p->bMapIDs = bMapIDs;
+	p->bRemoveUnidentifiableBeforeHungarian = bRemoveUnidentifiableBeforeHungarian;
+	p->bApplyHungarian = bApplyHungarian;
+	p->bRemoveUnidentifiableBeforeFilters = bRemoveUnidentifiableBeforeFilters;
+	p->bApplyFilters = bApplyFilters;
+	p->frameBudgetMicros = MAX(frameBudgetMicros, 0);
+	p->degradedHungarianMaxSamples = degradedHungarianMaxSamples;
+	p->degradations = ofxRTLSFrameBudget::parseDegradations(degradationsStr);
 
 	// Parse the identifiable fields and create a mapping from the string
 	// type to a more mappable integer index.
-	{
-		vector<string> tmp = ofSplitString(tempKeyTypesStr, ",");
+	auto parseKeyTypes = [](string list, set<TrackableKeyType>& keyTypes) {
+		vector<string> tmp = ofSplitString(list, ",");
 		for (auto& s : tmp) {
 			for (int i = 0; i < NUM_KEYS - 1; i++) {
 				if (s.compare(getTrackableKeyTypeDescription(TrackableKeyType(i))) == 0) {
 					// match
-					tempKeyTypes.insert(TrackableKeyType(i));
+					keyTypes.insert(TrackableKeyType(i));
 				}
 			}
 		}
+	};
+	parseKeyTypes(tempKeyTypesStr, p->tempKeyTypes);
+	parseKeyTypes(permKeyTypesStr, p->permKeyTypes);
+
+	p->hungarianRadius = hungarianRadius;
+	p->hungarianMappingFrom = hungarianMappingFrom;
+	p->hungarianMappingTo = hungarianMappingTo;
+	p->mappingHorizonSec = mappingHorizonSec;
+	p->mappingHorizonFrames = mappingHorizonFrames;
+	p->bRemoveMatchingKeysBeforeSolve = bRemoveMatchingKeysBeforeSolve;
+	p->bAssignCuidsToUnidentifiableTrackables = bAssignCuidsToUnidentifiableTrackables;
+	p->bAllowRemappingFromPermKeyTypes = bAllowRemappingFromPermKeyTypes;
+	p->bAllowRemappingToPermKeyTypes = bAllowRemappingToPermKeyTypes;
+	p->bReacquireLostTracks = bReacquireLostTracks;
+	p->reacquireRadius = reacquireRadius;
+	p->reacquireMaxSec = reacquireMaxSec;
+	p->reacquireMaxFrames = reacquireMaxFrames;
+	p->reacquireMaxPredictionSec = reacquireMaxPredictionSec;
+
+	// Replace any snapshot that the processing thread has not acquired yet
+	delete pendingParams.exchange(p);
+}
+
+// --------------------------------------------------------------
+shared_ptr<const ofxRTLSPostprocessorParams> ofxRTLSPostprocessor::acquireParams() {
+
+	// Take ownership of the newest snapshot, if there is one. The previous 
+	// snapshot is deleted once no frame uses it.
+	ofxRTLSPostprocessorParams* p = pendingParams.exchange(NULL);
+	if (p != NULL) params.reset(p);
+	return params;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::paramChanged(RemoteUIServerCallBackArg& arg) {
+
+	// Presets may change any param. Otherwise, only respond to this 
+	// postprocessor's params.
+	if (arg.action == CLIENT_UPDATED_PARAM) {
+		if (arg.paramName == "ID_RTLS" + abbr + "- ID Dict Auto Reload") {
+			dict.setAutoReload(bDictAutoReload);
+			return;
+		}
+		if (arg.paramName.find("RTLS-P-" + abbr + "- ") != 0 &&
+			arg.paramName.find("HU_RTLS" + abbr + "- ") != 0) return;
 	}
-	{
-		vector<string> tmp = ofSplitString(permKeyTypesStr, ",");
-		for (auto& s : tmp) {
-			for (int i = 0; i < NUM_KEYS - 1; i++) {
-				if (s.compare(getTrackableKeyTypeDescription(TrackableKeyType(i))) == 0) {
-					// match
-					permKeyTypes.insert(TrackableKeyType(i));
-				}
+	publishParams();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::setupPipeline() {
+
+	stages.clear();
+	stageTimeFields.clear();
+	stageToggles.clear();
+	outputs.clear();
+
+	// Pipelines with outputs list their shared stages under "stages"
+	ofJson pipeline = pipelineSettings;
+	ofJson outputSettings;
+	if (pipeline.is_object()) {
+		if (pipeline.find("outputs") != pipeline.end()) outputSettings = pipeline["outputs"];
+		pipeline = pipeline.find("stages") != pipeline.end() ? pipeline["stages"] : ofJson();
+	}
+
+	// If no pipeline is declared, use the built-in stages in their default order
+	bool bDefault = !pipeline.is_array();
+	vector<bool ofxRTLSPostprocessorParams::*> toggles;
+	if (bDefault) {
+		pipeline = ofJson::array();
+		auto addDefault = [&](string type, string stageName, bool ofxRTLSPostprocessorParams::* toggle) {
+			ofJson entry;
+			entry["type"] = type;
+			entry["name"] = stageName;
+			pipeline.push_back(entry);
+			toggles.push_back(toggle);
+		};
+		addDefault("mapIDs", "mapIDs", &ofxRTLSPostprocessorParams::bMapIDs);
+		addDefault("removeUnidentifiable", "removeUnidentifiableBeforeHungarian", &ofxRTLSPostprocessorParams::bRemoveUnidentifiableBeforeHungarian);
+		addDefault("hungarian", "hungarian", &ofxRTLSPostprocessorParams::bApplyHungarian);
+		addDefault("removeUnidentifiable", "removeUnidentifiableBeforeFilters", &ofxRTLSPostprocessorParams::bRemoveUnidentifiableBeforeFilters);
+		addDefault("filters", "filters", &ofxRTLSPostprocessorParams::bApplyFilters);
+	}
+
+	set<string> statefulTypes;
+	for (int i = 0; i < pipeline.size(); i++) {
+		uint64_t StageTimes::* timeField = &StageTimes::other;
+		ofxRTLSPostprocessStage* stage = createStage(pipeline[i], "", timeField);
+		if (stage == NULL) continue;
+		// The shared Hungarian and filters stages use the postprocessor's 
+		// state, which can only be updated once per frame
+		if (stage->getType() == "hungarian" || stage->getType() == "filters") {
+			if (statefulTypes.count(stage->getType()) != 0) {
+				ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " can only run one \"" << stage->getType() 
+					<< "\" stage before its outputs. Ignoring the stage \"" << stage->getName() << "\".";
+				delete stage;
+				continue;
 			}
+			statefulTypes.insert(stage->getType());
 		}
+		stages.push_back(unique_ptr<ofxRTLSPostprocessStage>(stage));
+		stageTimeFields.push_back(timeField);
+		stageToggles.push_back(bDefault ? toggles[i] : NULL);
 	}
 
-	// Setup the CUID generator
-	cuidGen = new CuidGenerator(cuidStartCounter);
+	// Create the stages of each output
+	size_t nOutputStages = 0;
+	if (outputSettings.is_object()) {
+		for (auto it = outputSettings.begin(); it != outputSettings.end(); it++) {
+			if (!it.value().is_array()) {
+				ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " cannot parse output \"" << it.key() << "\". Outputs must be lists of stages.";
+				continue;
+			}
+			Output* output = new Output();
+			output->name = it.key();
+			output->data.systemType = systemType;
+			output->data.trackableType = trackableType;
+			output->data.output = output->name;
+			// Latency is measured on the main output
+			output->data.nullify();
+			for (auto& entry : it.value()) {
+				uint64_t StageTimes::* timeField = &StageTimes::other;
+				ofxRTLSPostprocessStage* stage = createStage(entry, output->name, timeField);
+				if (stage == NULL) continue;
+				stage->stats.name = output->name + "." + stage->name;
+				output->stages.push_back(unique_ptr<ofxRTLSPostprocessStage>(stage));
+			}
+			nOutputStages += output->stages.size();
+			outputs.push_back(unique_ptr<Output>(output));
+		}
+	}
+	else if (!outputSettings.is_null()) {
+		ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " cannot parse its outputs. Outputs must be an object of lists of stages.";
+	}
+	// Run outputs in parallel (or on the calling thread, if headless)
+	if (outputs.size() > 1) outputPool.setup(bHeadless ? 1 : int(outputs.size()));
+
+	// Stages that replace keys after the Hungarian stage (e.g. decoders)
+	// would hide the keys it tracks from its next frame
+	bKeysReplacedAfterHungarian = false;
+	bool bHungarian = false;
+	for (auto& stage : stages) {
+		if (bHungarian && stage->replacesKeys()) bKeysReplacedAfterHungarian = true;
+		bHungarian |= stage->getType() == "hungarian";
+	}
 
-	// Setup the filters
-	filters.setup("RTLS-"+abbr, _filterList);
+	// All stages run on one thread until split into segments
+	stageSegments.assign(stages.size(), 0);
+	hungarianSegment = 0;
+	filtersSegment = 0;
+	setupBudget();
+
+	// Blink decoders read a track's off bits from the frames it is unseen,
+	// so tracks must keep their keys across them
+	bool bDecodeBlinks = false;
+	for (auto& stage : stages) bDecodeBlinks |= stage->getType() == "decodeBlinks";
+	for (auto& output : outputs) {
+		for (auto& stage : output->stages) bDecodeBlinks |= stage->getType() == "decodeBlinks";
+	}
+	if (bDecodeBlinks && !bReacquireLostTracks) {
+		ofLogWarning("ofxRTLSPostprocessor") << "Postprocessor " << name << " decodes blinks without reacquiring lost tracks. "
+			<< "Markers that blink off will get new keys and fail to decode. Enable hungarian > reacquire.";
+	}
 
-	startThread();
+	std::lock_guard<std::mutex> lk(diagnosticsMutex);
+	diagnostics.stages.resize(stages.size() + nOutputStages);
+}
+
+// --------------------------------------------------------------
+ofxRTLSPostprocessStage* ofxRTLSPostprocessor::createStage(ofJson entry, string outputName, uint64_t StageTimes::*& timeField) {
+
+	if (entry.is_string()) {
+		string type = entry.get<string>();
+		entry = ofJson::object();
+		entry["type"] = type;
+	}
+	if (!entry.is_object() || entry.find("type") == entry.end() || !entry["type"].is_string()) {
+		ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " cannot parse a stage of its pipeline" << 
+			(outputName.empty() ? "" : " (output \"" + outputName + "\")") << ".";
+		return NULL;
+	}
+	string type = entry["type"].get<string>();
+	bool bOutput = !outputName.empty();
+
+	// Create the stage
+	ofxRTLSPostprocessStage* stage = NULL;
+	timeField = &StageTimes::other;
+	bool bBuiltin = true;
+	if (type == "mapIDs") {
+		stage = new ofxRTLSBuiltinStage(this, &ofxRTLSPostprocessor::_process_mapIDs);
+		timeField = &StageTimes::mapIDs;
+	}
+	else if (type == "removeUnidentifiable") {
+		stage = new ofxRTLSBuiltinStage(this, &ofxRTLSPostprocessor::_process_removeUnidentifiable);
+		timeField = &StageTimes::removeUnidentifiable;
+	}
+	else if (type == "hungarian") {
+		if (bOutput) {
+			ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " cannot run the Hungarian stage in output \"" << outputName << "\". Run it before the outputs.";
+			return NULL;
+		}
+		stage = new ofxRTLSBuiltinStage(this, &ofxRTLSPostprocessor::_process_applyHungarian);
+		timeField = &StageTimes::hungarian;
+	}
+	else if (type == "filters") {
+		if (bOutput) {
+			// Each output has its own filters
+			stage = new ofxRTLSFilterStage();
+			if (entry.find("filterList") == entry.end()) entry["filterList"] = filterList;
+			entry["groupName"] = "RTLS-" + abbr + "-" + outputName + "-" + entry.value("name", type);
+		}
+		else {
+			stage = new ofxRTLSBuiltinStage(this, &ofxRTLSPostprocessor::_process_applyFilters);
+		}
+		timeField = &StageTimes::filters;
+	}
+	else {
+		bBuiltin = false;
+	}
+	if (bBuiltin) {
+		// Built-in stages use the postprocessor's settings (e.g. its "hungarian"
+		// object), so their entries only take the keys common to all stages
+		static const set<string> commonKeys = { "type", "name", "enabled", "optional", "costExponent", "filterList", "groupName" };
+		for (auto it = entry.begin(); it != entry.end(); ++it) {
+			if (commonKeys.count(it.key()) != 0 && (it.key() != "filterList" || bOutput)) continue;
+			ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " ignores \"" << it.key() << "\" in its \"" << type
+				<< "\" stage. Built-in stages are configured by the postprocessor's settings.";
+		}
+	}
+	else if (type == "decodeIDs") {
+		stage = new ofxRTLSIDDecodeStage();
+	}
+	else if (type == "decodeBlinks") {
+		stage = new ofxRTLSBlinkDecodeStage();
+	}
+	else if (type == "predict") {
+		stage = new ofxRTLSPredictStage();
+	}
+	else {
+		stage = ofxRTLSPostprocessStageRegistry::one()->create(type);
+	}
+	if (stage == NULL) {
+		ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " has no stage of type \"" << type << "\".";
+		return NULL;
+	}
+
+	stage->type = type;
+	stage->name = entry.value("name", type);
+	stage->stats.name = stage->name;
+	stage->bEnabled = entry.value("enabled", true);
+	stage->bOptional = entry.value("optional", false);
+	stage->costExponent = entry.value("costExponent", type == "hungarian" ? 2.0 : 1.0);
+	stage->setup(entry);
+	return stage;
+}
+
+// --------------------------------------------------------------
+vector<string> ofxRTLSPostprocessor::getOutputNames() {
+
+	vector<string> out;
+	for (auto& output : outputs) out.push_back(output->name);
+	return out;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::_processOutputs(const RTLSProtocol::TrackableFrame& frame, 
+	const ofxRTLSPostprocessStage::Context& context) {
+
+	if (outputs.empty()) return;
+
+	auto processOutput = [&](size_t k) {
+		Output& output = *outputs[k];
+
+		// Begin with the frame produced by the shared stages
+		output.data.frame = frame;
+		output.ws.load(output.data.frame);
+
+		uint64_t lastTime = ofGetElapsedTimeMicros();
+		for (auto& stage : output.stages) {
+			if (!stage->isEnabled()) continue;
+			if (stage->isOptional() && (context.degradations & ofxRTLSFrameBudget::DEGRADE_SKIP_OPTIONAL)) {
+				stage->count("skipped");
+				continue;
+			}
+			size_t nIn = output.ws.getNumActive();
+			stage->process(output.ws, context);
+			if (output.ws.getNumActive() < output.ws.size()) output.ws.compact();
+			uint64_t now = ofGetElapsedTimeMicros();
+			stage->recordFrame(now - lastTime, nIn, output.ws.getNumActive());
+			lastTime = now;
+		}
+		output.ws.writeBack();
+		output.bProcessed = true;
+	};
+
+	if (outputs.size() == 1) processOutput(0);
+	else outputPool.run(outputs.size(), processOutput);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::sendOutputs(const ofxRTLSPlaybackInfo& playback, const string& sourceID) {
+
+	for (auto& output : outputs) {
+		if (!output->bProcessed) continue;
+		output->bProcessed = false;
+		// Replayed frames only bring the outputs' stages up to date
+		if (playback.bReplay) continue;
+		output->data.playback = playback;
+		output->data.sourceID = sourceID;
+		ofNotifyEvent(outputReady, output->data);
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::setupBudget() {
+
+	vector<ofxRTLSFrameBudget::StageInfo> infos;
+	for (int i = 0; i < stages.size(); i++) {
+		ofxRTLSFrameBudget::StageInfo info;
+		info.costExponent = stages[i]->getCostExponent();
+		info.bOptional = stages[i]->isOptional();
+		info.bHungarian = stages[i]->getType() == "hungarian";
+		info.segment = stageSegments[i];
+		infos.push_back(info);
+	}
+
+	ofxRTLSFrameBudget::Settings settings;
+	settings.frameMicros = MAX(frameBudgetMicros, 0);
+	settings.smoothing = budgetSmoothing;
+	settings.priority = ofxRTLSFrameBudget::parseDegradations(degradationsStr);
+	settings.hungarianMaxSamples = degradedHungarianMaxSamples;
+	settings.recoverFrames = budgetRecoverFrames;
+	settings.recoverRatio = budgetRecoverRatio;
+	budget.setup(infos, settings);
+	lastDegradationLevel = 0;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::scheduleFrame(ofxRTLSPostprocessStage::Context& context) {
+
+	// Apply any changes to the params
+	budget.setFrameMicros(context.params->frameBudgetMicros);
+	budget.setHungarianMaxSamples(context.params->degradedHungarianMaxSamples);
+	if (context.params->degradations != budget.getPriority()) budget.setPriority(context.params->degradations);
+
+	context.degradations = budget.beginFrame(context.nTrackables);
+
+	// Report changes in the level of degradation
+	int level = budget.getLevel();
+	if (level == lastDegradationLevel) return;
+	ofxRTLSDegradationArgs args;
+	args.systemType = systemType;
+	args.trackableType = trackableType;
+	args.level = level;
+	for (int i = 0; i < 32; i++) {
+		uint32_t flag = 1u << i;
+		if (context.degradations & flag) {
+			args.degradations.push_back(ofxRTLSFrameBudget::getDegradationDescription(ofxRTLSFrameBudget::Degradation(flag)));
+		}
+	}
+	args.projectedMicros = budget.getProjectedMicros();
+	args.budgetMicros = budget.getFrameMicros();
+	ofLogNotice("ofxRTLSPostprocessor") << "Postprocessor " << name << (level > lastDegradationLevel ? " degraded" : " recovered")
+		<< " to level " << level << " (" << ofJoinString(args.degradations, ",") << "), projecting "
+		<< int(args.projectedMicros) << " of " << args.budgetMicros << " us per frame.";
+	lastDegradationLevel = level;
+	ofNotifyEvent(degradationChanged, args);
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSPostprocessor::isCoalescable(DataElem* elem) {
+
+	// Only live frames are dropped. States and played back frames must always
+	// be processed, so playback stays deterministic and matches its keyframes.
+	return !elem->bRestore && !elem->data.playback.bValid;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::setupSegments() {
+
+	stopSegments();
+
+	int nSegments = MIN(MAX(pipelineThreads, 1), MAX(int(stages.size()), 1));
+	if (nSegments <= 1) return;
+
+	// Split the stages into contiguous segments of (nearly) equal numbers of stages
+	for (int k = 0; k < nSegments; k++) {
+		Segment* segment = new Segment();
+		segment->beginStage = stages.size() * k / nSegments;
+		segment->endStage = stages.size() * (k + 1) / nSegments;
+		segment->input.setup(2);
+		segments.push_back(unique_ptr<Segment>(segment));
+		for (size_t i = segment->beginStage; i < segment->endStage; i++) stageSegments[i] = k;
+	}
+
+	// Find the segments that own the state in diagnostics
+	for (int i = int(stages.size()) - 1; i >= 0; i--) {
+		if (stages[i]->getType() == "hungarian") hungarianSegment = stageSegments[i];
+		if (stages[i]->getType() == "filters") filtersSegment = stageSegments[i];
+	}
+
+	// Create enough items for every segment to be busy
+	int nItems = nSegments + 1;
+	freeItems.setup(nItems);
+	for (int i = 0; i < nItems; i++) {
+		pipelineItems.push_back(unique_ptr<PipelineItem>(new PipelineItem()));
+		freeItems.push(pipelineItems.back().get());
+	}
+	nInFlight = 0;
+
+	// Project the cost of each segment separately
+	setupBudget();
+
+	// The processing thread runs the first segment. Start the others.
+	for (int k = 1; k < nSegments; k++) {
+		segments[k]->thread = std::thread(&ofxRTLSPostprocessor::segmentFunction, this, k);
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::stopSegments() {
+
+	if (segments.empty()) return;
+
+	for (auto& segment : segments) segment->input.close();
+	freeItems.close();
+	for (auto& segment : segments) {
+		if (segment->thread.joinable()) segment->thread.join();
+	}
+
+	// Delete any data left in the pipeline
+	for (auto& item : pipelineItems) {
+		if (item->elem != NULL) delete item->elem;
+		item->elem = NULL;
+	}
+	segments.clear();
+	pipelineItems.clear();
+	{
+		std::lock_guard<std::mutex> lk(pipelineMutex);
+		nInFlight = 0;
+	}
+	pipelineCv.notify_all();
+	stageSegments.assign(stages.size(), 0);
+	hungarianSegment = 0;
+	filtersSegment = 0;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::segmentFunction(int index) {
+
+	Segment& segment = *segments[index];
+	bool bLast = index + 1 == segments.size();
+
+	PipelineItem* item = NULL;
+	while (segment.input.pop(item)) {
+
+		_processStages(item->ws, item->context, segment.beginStage, segment.endStage, item->times);
+
+		if (bLast) {
+			finishItem(item);
+		}
+		else {
+			updateDiagnostics(index);
+			if (!segments[index + 1]->input.push(item)) break;
+		}
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::finishItem(PipelineItem* item) {
+
+	item->ws.writeBack();
+	_processOutputs(item->elem->data.frame, item->context);
+	item->times.total = ofGetElapsedTimeMicros() - item->startTime;
+	{
+		std::lock_guard<std::mutex> lk(diagnosticsMutex);
+		stageTimes = item->times;
+	}
+
+	// Keep this frame's working set for reference
+	lastWorkingSet.swap(item->ws);
+
+	// Send out this data, unless it was only replayed
+	DataElem* elem = item->elem;
+	item->elem = NULL;
+	if (elem->data.playback.bReplay) elem->data.nullify();
+	else ofNotifyEvent(*(elem->dataReadyEvent), elem->data);
+	sendOutputs(elem->data.playback, elem->data.sourceID);
+	delete elem;
+
+	updateDiagnostics(int(segments.size()) - 1);
+
+	// Return the item
+	freeItems.push(item);
+	{
+		std::lock_guard<std::mutex> lk(pipelineMutex);
+		nInFlight--;
+	}
+	pipelineCv.notify_all();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::waitForPipeline() {
+
+	if (!isPipelined()) return;
+
+	std::unique_lock<std::mutex> lk(pipelineMutex);
+	pipelineCv.wait(lk, [this] { return nInFlight == 0; });
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::applySettings(const ofJson& js) {
+	if (!js.is_object()) return;
+
+	bMapIDs = js.value("mapIDs", bMapIDs);
+	dictPath = js.value("dictPath", dictPath);
+	bDictAutoReload = js.value("dictAutoReload", bDictAutoReload);
+	bRemoveUnidentifiableBeforeHungarian = js.value("removeUnidentifiableBeforeHungarian", bRemoveUnidentifiableBeforeHungarian);
+	bApplyHungarian = js.value("applyHungarian", bApplyHungarian);
+	bRemoveUnidentifiableBeforeFilters = js.value("removeUnidentifiableBeforeFilters", bRemoveUnidentifiableBeforeFilters);
+	bApplyFilters = js.value("applyFilters", bApplyFilters);
+	if (js.find("pipeline") != js.end()) pipelineSettings = js["pipeline"];
+	pipelineThreads = js.value("pipelineThreads", pipelineThreads);
+	if (js.find("budget") != js.end() && js["budget"].is_object()) {
+		const ofJson& bu = js["budget"];
+		frameBudgetMicros = bu.value("frameMicros", frameBudgetMicros);
+		degradationsStr = bu.value("degradations", degradationsStr);
+		degradedHungarianMaxSamples = bu.value("hungarianMaxSamples", degradedHungarianMaxSamples);
+		budgetSmoothing = bu.value("smoothing", budgetSmoothing);
+		budgetRecoverFrames = bu.value("recoverFrames", budgetRecoverFrames);
+		budgetRecoverRatio = bu.value("recoverRatio", budgetRecoverRatio);
+	}
+	filterList = js.value("filterList", filterList);
+
+	if (js.find("hungarian") != js.end() && js["hungarian"].is_object()) {
+		const ofJson& hu = js["hungarian"];
+		tempKeyTypesStr = hu.value("temporaryKeyTypes", tempKeyTypesStr);
+		permKeyTypesStr = hu.value("permanentKeyTypes", permKeyTypesStr);
+		hungarianRadius = hu.value("radius", hungarianRadius);
+		vector<string> mappings = { "temporary", "permanent", "both" };
+		for (int i = 0; i < mappings.size(); i++) {
+			if (ofToLower(hu.value("from", string(""))) == mappings[i]) hungarianMappingFrom = HungarianMapping(i);
+			if (ofToLower(hu.value("to", string(""))) == mappings[i]) hungarianMappingTo = HungarianMapping(i);
+		}
+		mappingHorizonSec = hu.value("mappingHorizonSec", mappingHorizonSec);
+		mappingHorizonFrames = hu.value("mappingHorizonFrames", mappingHorizonFrames);
+		bRemoveMatchingKeysBeforeSolve = hu.value("removeMatchingKeys", bRemoveMatchingKeysBeforeSolve);
+		bAssignCuidsToUnidentifiableTrackables = hu.value("assignCuids", bAssignCuidsToUnidentifiableTrackables);
+		cuidStartCounter = hu.value("cuidStartCounter", cuidStartCounter);
+		bAllowRemappingFromPermKeyTypes = hu.value("allowRemapFromPerm", bAllowRemappingFromPermKeyTypes);
+		bAllowRemappingToPermKeyTypes = hu.value("allowRemapToPerm", bAllowRemappingToPermKeyTypes);
+		bReacquireLostTracks = hu.value("reacquire", bReacquireLostTracks);
+		reacquireRadius = hu.value("reacquireRadius", reacquireRadius);
+		reacquireMaxSec = hu.value("reacquireMaxSec", reacquireMaxSec);
+		reacquireMaxFrames = hu.value("reacquireMaxFrames", reacquireMaxFrames);
+		reacquireMaxPredictionSec = hu.value("reacquireMaxPredictionSec", reacquireMaxPredictionSec);
+	}
 }
 
 // --------------------------------------------------------------
@@ -121,29 +828,114 @@ void ofxRTLSPostprocessor::threadedFunction() {
 				// The queue contains elements. Get an element.
 				elem = dataQueue.front();
 				dataQueue.pop();
+				bProcessingElem = true;
+
+				// When degraded, skip frames for which newer frames are waiting
+				while ((budget.getFlags() & ofxRTLSFrameBudget::DEGRADE_COALESCE) && 
+					!dataQueue.empty() && isCoalescable(elem) && isCoalescable(dataQueue.front())) {
+					elem->data.nullify();
+					delete elem;
+					nCoalescedFrames++;
+					elem = dataQueue.front();
+					dataQueue.pop();
+				}
 			}
 		}
 
 		// Reset the postprocessors, if necessary
 		if (flagReset) {
 			flagReset = false;
+			waitForPipeline();
 			resetInternalStates();
 		}
 
 		// If an element has been received, process it.
 		if (elem) {
 
-			// Process this element
-			_process(elem->data.frame);
+			if (elem->bRestore) {
+				// Restore the state contained in this element
+				waitForPipeline();
+				deserializeState(elem->state);
+			}
+			else if (isPipelined()) {
+				// Capture the state before this frame, once all previous 
+				// frames have been processed
+				if (elem->data.playback.bKeyframe) {
+					waitForPipeline();
+					ofxRTLSPostprocessorStateArgs args;
+					args.systemType = systemType;
+					args.trackableType = trackableType;
+					args.playback = elem->data.playback;
+					args.state = serializeState();
+					ofNotifyEvent(stateCaptured, args);
+				}
 
-			// Send out this data
-			ofNotifyEvent(*(elem->dataReadyEvent), elem->data);
+				// Run the first segment, then pass this element on
+				PipelineItem* item = NULL;
+				if (!freeItems.pop(item)) {
+					delete elem;
+					{
+						std::lock_guard<std::mutex> lk(mutex);
+						bProcessingElem = false;
+					}
+					drainCv.notify_all();
+					break;
+				}
+				{
+					std::lock_guard<std::mutex> lk(pipelineMutex);
+					nInFlight++;
+				}
+				item->elem = elem;
+				item->context.systemType = systemType;
+				item->context.trackableType = trackableType;
+				item->context.timeMicros = getFrameTimeMicros(elem->data);
+				item->context.timeMS = item->context.timeMicros / 1000;
+				item->context.bPlayback = elem->data.playback.bValid;
+				item->context.nTrackables = elem->data.frame.trackables_size();
+				item->context.params = acquireParams();
+				scheduleFrame(item->context);
+				item->times = StageTimes();
+				item->startTime = ofGetElapsedTimeMicros();
+				item->ws.load(elem->data.frame);
+				_processStages(item->ws, item->context, segments[0]->beginStage, segments[0]->endStage, item->times);
+				updateDiagnostics(0);
+				segments[1]->input.push(item);
+
+				// The element is deleted once it leaves the pipeline
+				elem = NULL;
+			}
+			else {
+				// Capture the state before this frame, if requested
+				if (elem->data.playback.bKeyframe) {
+					ofxRTLSPostprocessorStateArgs args;
+					args.systemType = systemType;
+					args.trackableType = trackableType;
+					args.playback = elem->data.playback;
+					args.state = serializeState();
+					ofNotifyEvent(stateCaptured, args);
+				}
+
+				// Process this element
+				processTimeMicros = getFrameTimeMicros(elem->data);
+				bProcessPlayback = elem->data.playback.bValid;
+				_process(elem->data.frame);
 
-			// Save the last data frame for reference
-			lastFrame = elem->data.frame;
+				// Send out this data, unless it was only replayed
+				if (elem->data.playback.bReplay) elem->data.nullify();
+				else ofNotifyEvent(*(elem->dataReadyEvent), elem->data);
+				sendOutputs(elem->data.playback, elem->data.sourceID);
+
+				updateDiagnostics();
+			}
 
 			// Delete this data
 			delete elem;
+
+			{
+				std::lock_guard<std::mutex> lk(mutex);
+				bProcessingElem = false;
+			}
+			drainCv.notify_all();
 		}
 	}
 }
@@ -153,6 +945,30 @@ void ofxRTLSPostprocessor::exit() {
 
 }
 
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::drain() {
+
+	if (bHeadless || !isThreadRunning()) return;
+
+	// Wait for the processing thread to empty the queue, then for the 
+	// remaining frames to leave the pipeline
+	{
+		std::unique_lock<std::mutex> lk(mutex);
+		drainCv.wait(lk, [this] { return (dataQueue.empty() && !bProcessingElem) || flagUnlock; });
+	}
+	waitForPipeline();
+}
+
+// --------------------------------------------------------------
+uint64_t ofxRTLSPostprocessor::getFrameTimeMicros(const ofxRTLSEventArgs& data) {
+
+	// Played back data uses its time in the take, so processing is repeatable
+	if (data.playback.bValid) return data.playback.timeMS * 1000;
+	// Live data uses the time it was captured, if known
+	if (data.timeMicros != 0) return data.timeMicros;
+	return ofGetElapsedTimeMicros();
+}
+
 // --------------------------------------------------------------
 void ofxRTLSPostprocessor::processAndSend(ofxRTLSEventArgs& data, 
 	ofEvent<ofxRTLSEventArgs>& dataReadyEvent) {
@@ -173,65 +989,190 @@ void ofxRTLSPostprocessor::processAndSend(ofxRTLSEventArgs& data,
 }
 
 // --------------------------------------------------------------
-void ofxRTLSPostprocessor::_process(RTLSProtocol::TrackableFrame& frame) {
-	
-	if (bMapIDs) _process_mapIDs(frame);
+void ofxRTLSPostprocessor::process(RTLSProtocol::TrackableFrame& frame) {
+
+	// Reset the postprocessor, if necessary
+	if (flagReset) {
+		flagReset = false;
+		resetInternalStates();
+	}
+
+	// Process this frame. Headless frames are timed by their take (or
+	// scenario), not by the server's clock.
+	processTimeMicros = frame.timestamp() * 1000;
+	bProcessPlayback = true;
+	_process(frame);
+	sendOutputs(ofxRTLSPlaybackInfo(), "");
+	updateDiagnostics();
+}
+
+// --------------------------------------------------------------
+ofxRTLSPostprocessor::Diagnostics ofxRTLSPostprocessor::getDiagnostics() {
 
-	if (bRemoveUnidentifiableBeforeHungarian) _process_removeUnidentifiable(frame);
+	Diagnostics out;
+	{
+		std::lock_guard<std::mutex> lk(diagnosticsMutex);
+		out = diagnostics;
+	}
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		out.nQueued = dataQueue.size();
+	}
+	return out;
+}
 
-	if (bApplyHungarian) _process_applyHungarian(frame);
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::updateDiagnostics(int segment) {
+
+	// Only read the state that is updated on this segment's thread
+	int lastSegment = MAX(int(segments.size()) - 1, 0);
+	std::lock_guard<std::mutex> lk(diagnosticsMutex);
+	if (segment == 0) {
+		diagnostics.degradationLevel = budget.getLevel();
+		diagnostics.projectedMicros = budget.getProjectedMicros();
+		diagnostics.nDegradedFrames = budget.getNumDegradedFrames();
+		diagnostics.nCoalescedFrames = nCoalescedFrames;
+	}
+	if (segment == lastSegment) {
+		diagnostics.nFramesProcessed++;
+		diagnostics.nLastFrameTrackables = lastWorkingSet.size();
+	}
+	if (segment == hungarianSegment) {
+		diagnostics.nKeyMappings = identities.getNumMappings();
+		diagnostics.nLostTracks = lostTracks.size();
+		diagnostics.cuidCounter = cuidGen != NULL ? cuidGen->getCounter() : 0;
+	}
+	if (segment == filtersSegment) {
+		diagnostics.nFilters = filterState.filters.getFilters().size();
+	}
+	for (int i = 0; i < stages.size(); i++) {
+		if (stageSegments[i] == segment) diagnostics.stages[i] = stages[i]->getStats();
+	}
+	// Outputs run after the last segment
+	if (segment == lastSegment) {
+		size_t index = stages.size();
+		for (auto& output : outputs) {
+			for (auto& stage : output->stages) diagnostics.stages[index++] = stage->getStats();
+		}
+	}
+}
 
-	if (bRemoveUnidentifiableBeforeFilters) _process_removeUnidentifiable(frame);
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::_process(RTLSProtocol::TrackableFrame& frame) {
 
-	if (bApplyFilters) _process_applyFilters(frame);
+	StageTimes times;
+	uint64_t startTime = ofGetElapsedTimeMicros();
+	
+	// Read the frame into the working set once. Stages operate on the 
+	// working set, and the frame is only updated at the end.
+	workingSet.load(frame);
+
+	ofxRTLSPostprocessStage::Context context;
+	context.systemType = systemType;
+	context.trackableType = trackableType;
+	context.timeMicros = processTimeMicros;
+	context.timeMS = processTimeMicros / 1000;
+	context.bPlayback = bProcessPlayback;
+	context.nTrackables = frame.trackables_size();
+	context.params = acquireParams();
+	scheduleFrame(context);
+	_processStages(workingSet, context, 0, stages.size(), times);
+
+	workingSet.writeBack();
+	_processOutputs(frame, context);
+
+	// Keep this frame's working set for reference (and reuse the 
+	// last one's memory for the next frame)
+	lastWorkingSet.swap(workingSet);
+
+	times.total = ofGetElapsedTimeMicros() - startTime;
+	std::lock_guard<std::mutex> lk(diagnosticsMutex);
+	stageTimes = times;
 }
 
 // --------------------------------------------------------------
-void ofxRTLSPostprocessor::_process_mapIDs(RTLSProtocol::TrackableFrame& frame) {
+ofxRTLSPostprocessor::StageTimes ofxRTLSPostprocessor::getLastStageTimes() {
+	std::lock_guard<std::mutex> lk(diagnosticsMutex);
+	return stageTimes;
+}
 
-	for (int i = 0; i < frame.trackables_size(); i++) {
-		if (!isTrackableIdentifiableByType(frame.trackables(i), KEY_ID) || 
-			!isTrackableIDValid(frame.trackables(i))) continue;
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::_processStages(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context,
+	size_t beginStage, size_t endStage, StageTimes& times) {
+
+	uint64_t lastTime = ofGetElapsedTimeMicros();
+	for (size_t i = beginStage; i < endStage; i++) {
+		if (!stages[i]->isEnabled()) continue;
+		// Stages of the default pipeline are toggled by the postprocessor's params
+		if (stageToggles[i] != NULL && !(context.params.get()->*stageToggles[i])) continue;
+		if (stages[i]->isOptional() && (context.degradations & ofxRTLSFrameBudget::DEGRADE_SKIP_OPTIONAL)) {
+			stages[i]->count("skipped");
+			continue;
+		}
 
-		int ID = frame.trackables(i).id();
-		frame.mutable_trackables(i)->set_id(dict.lookup(ID));
+		size_t nIn = ws.getNumActive();
+		stages[i]->process(ws, context);
+		// Later stages only see the remaining trackables
+		if (ws.getNumActive() < ws.size()) ws.compact();
+		uint64_t now = ofGetElapsedTimeMicros();
+		uint64_t elapsed = now - lastTime;
+		lastTime = now;
+		stages[i]->recordFrame(elapsed, nIn, ws.getNumActive());
+		budget.recordStage(i, elapsed, nIn, context.nTrackables, context.degradations);
+		times.*stageTimeFields[i] += elapsed;
 	}
 }
 
 // --------------------------------------------------------------
-void ofxRTLSPostprocessor::_process_removeUnidentifiable(RTLSProtocol::TrackableFrame& frame) {
+void ofxRTLSPostprocessor::_process_mapIDs(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& /*context*/) {
+
+	// Use the same table for the whole frame, even if the dictionary is
+	// reloaded in the meantime
+	shared_ptr<const IDDictionary::Table> table = dict.getTable();
+	if (!table) return;
+
+	for (size_t i = 0; i < ws.size(); i++) {
+		if (ws.getKeyType(i) != KEY_ID) continue;
+		Trackable* t = ws.getSource(i);
+		if (t == NULL || !isTrackableIDValid(*t)) continue;
+
+		int ID = t->id();
+		int mappedID = table->lookup(ID);
+		if (mappedID == ID) continue;
+		t->set_id(mappedID);
+		ws.updateKeyFromSource(i);
+	}
+}
 
-	int i = 0;
-	while (i < frame.trackables_size()) {
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::_process_removeUnidentifiable(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& /*context*/) {
 
+	for (size_t i = 0; i < ws.size(); i++) {
 		// Check if this trackable can be identified
-		if (!isTrackableIdentifiable(frame.trackables(i))) {
-			// Arbitrary elements cannot be deleted. Swap this element with the last
-			// and remove the last element.
-			frame.mutable_trackables()->SwapElements(i, frame.trackables_size() - 1);
-			frame.mutable_trackables()->RemoveLast();
-		}
-		else {
-			i++;
-		}
+		if (!isTrackableIdentifiable(ws.getKeyType(i))) ws.remove(i);
 	}
+	// Later stages only see the remaining trackables
+	ws.compact();
 }
 
 // --------------------------------------------------------------
-void ofxRTLSPostprocessor::_process_applyHungarian(RTLSProtocol::TrackableFrame& frame) {
+void ofxRTLSPostprocessor::_process_applyHungarian(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context) {
 
 	// Use the hungarian algorithm to attempt to identify continuity across samples.
+	const ofxRTLSPostprocessorParams& p = *context.params;
 
 	// ---------------------------------------
 	// ------- APPLY EXISTING MAPPINGS -------
 	// ---------------------------------------
 
 	// First, apply existing mappings to the current frame
-	for (int i = 0; i < frame.trackables_size(); i++) {
-		string key = getTrackableKey(frame.trackables(i));
-		if (keyMappings.find(key) != keyMappings.end()) {
+	identities.setHorizon(uint64_t(MAX(p.mappingHorizonSec, 0.0f) * 1000.0), uint64_t(MAX(p.mappingHorizonFrames, 0)));
+	identities.beginFrame(context.timeMS);
+	string identityKey;
+	for (size_t i = 0; i < ws.size(); i++) {
+		if (identities.resolve(ws.getKey(i), identityKey)) {
 			// found a mapping
-			reconcileTrackableWithKey(*frame.mutable_trackables(i), keyMappings[key]);
+			ws.setKey(i, identityKey);
 		}
 	}
 
@@ -242,20 +1183,23 @@ void ofxRTLSPostprocessor::_process_applyHungarian(RTLSProtocol::TrackableFrame&
 
 	// Collect data that will be passed to the solver.
 
+	// The last frame is the reference (see pipelineThreads)
+	ofxRTLSWorkingSet& reference = hasHungarianReference() ? hungarianReference : lastWorkingSet;
+
 	// Optionally (and by recommendation) remove matching keys from this dataset
 	set<string> matchingKeys;
-	if (bRemoveMatchingKeysBeforeSolve) {
+	if (p.bRemoveMatchingKeysBeforeSolve) {
 
 		// Collect keys
 		vector<string> fromKeys;
-		for (int i = 0; i < lastFrame.trackables_size(); i++) {
-			if (!isTrackableIdentifiable(lastFrame.trackables(i))) continue;
-			fromKeys.push_back(getTrackableKey(lastFrame.trackables(i)));
+		for (size_t i = 0; i < reference.size(); i++) {
+			if (!isTrackableIdentifiable(reference.getKeyType(i))) continue;
+			fromKeys.push_back(reference.getKey(i));
 		}
 		vector<string> toKeys;
-		for (int i = 0; i < frame.trackables_size(); i++) {
-			if (!isTrackableIdentifiable(frame.trackables(i))) continue;
-			toKeys.push_back(getTrackableKey(frame.trackables(i)));
+		for (size_t i = 0; i < ws.size(); i++) {
+			if (!isTrackableIdentifiable(ws.getKeyType(i))) continue;
+			toKeys.push_back(ws.getKey(i));
 		}
 
 		// Sort keys
@@ -276,58 +1220,73 @@ void ofxRTLSPostprocessor::_process_applyHungarian(RTLSProtocol::TrackableFrame&
 
 	// Collect data from the previous frame.
 	vector<HungarianSample> fromSamples;
-	for (int i = 0; i < lastFrame.trackables_size(); i++) {
+	for (size_t i = 0; i < reference.size(); i++) {
 
-		TrackableKeyType keyType;
-		string key = getTrackableKey(lastFrame.trackables(i), keyType);
+		TrackableKeyType keyType = reference.getKeyType(i);
+		const string& key = reference.getKey(i);
 
 		// Confirm that this sample should be in the dataset which the solver operates on.
-		if ((bRemoveMatchingKeysBeforeSolve && matchingKeys.find(key) != matchingKeys.end())) continue;
-		if (!isIncludedInHungarianMapping(keyType, hungarianMappingFrom)) continue;
+		if ((p.bRemoveMatchingKeysBeforeSolve && matchingKeys.find(key) != matchingKeys.end())) continue;
+		if (!p.isIncludedInHungarianMapping(keyType, p.hungarianMappingFrom)) continue;
 
 		// Found a sample in the "FROM" set
 		HungarianSample sample;
 		sample.key = key;
 		sample.index = i;
-		sample.position = glm::vec3(
-			lastFrame.trackables(i).position().x(),
-			lastFrame.trackables(i).position().y(),
-			lastFrame.trackables(i).position().z());
+		sample.position = reference.getPosition(i);
 		fromSamples.push_back(sample);
 	}
 
 	// Collect data from the current frame.
 	vector<HungarianSample> toSamples;
-	for (int i = 0; i < frame.trackables_size(); i++) {
+	for (size_t i = 0; i < ws.size(); i++) {
 
-		TrackableKeyType keyType;
-		string key = getTrackableKey(frame.trackables(i), keyType);
+		TrackableKeyType keyType = ws.getKeyType(i);
+		const string& key = ws.getKey(i);
 
 		// Confirm that this sample should be in the dataset which the solver operates on.
-		if ((bRemoveMatchingKeysBeforeSolve && matchingKeys.find(key) != matchingKeys.end())) continue;
-		if (!isIncludedInHungarianMapping(keyType, hungarianMappingTo)) continue;
+		if ((p.bRemoveMatchingKeysBeforeSolve && matchingKeys.find(key) != matchingKeys.end())) continue;
+		if (!p.isIncludedInHungarianMapping(keyType, p.hungarianMappingTo)) continue;
 
 		// Found a sample in the "TO" set
 		HungarianSample sample;
 		sample.key = key;
 		sample.index = i;
-		sample.position = glm::vec3(
-			frame.trackables(i).position().x(),
-			frame.trackables(i).position().y(),
-			frame.trackables(i).position().z());
+		sample.position = ws.getPosition(i);
 		toSamples.push_back(sample);
 	}
 
 	// TODO: Would this work if no IDs were provided?
 	// If a marker is unidentifiable, include it.
 
+	// When over budget, only solve for a limited number of samples: the TO
+	// samples nearest to any FROM sample (those without one within the radius
+	// could not be matched anyway), then the FROM samples nearest to those.
+	// The remaining TO samples are left unmatched.
+	vector<HungarianSample> excludedToSamples;
+	if (context.degradations & ofxRTLSFrameBudget::DEGRADE_SHRINK_HUNGARIAN) {
+		size_t maxSamples = budget.getHungarianMaxSamples();
+		vector<float> distances;
+		if (toSamples.size() > maxSamples) {
+			if (p.hungarianRadius > 0) getNearestDistances(toSamples, fromSamples, p.hungarianRadius, distances);
+			else distances.assign(toSamples.size(), FLT_MAX);
+			keepNearestSamples(toSamples, distances, maxSamples, &excludedToSamples);
+		}
+		if (fromSamples.size() > maxSamples) {
+			if (p.hungarianRadius > 0) getNearestDistances(fromSamples, toSamples, p.hungarianRadius, distances);
+			else distances.assign(fromSamples.size(), FLT_MAX);
+			keepNearestSamples(fromSamples, distances, maxSamples, NULL);
+		}
+	}
+
 
 	// ---------------------------------------
 	// ------- SOLVE FOR NEW MAPPINGS --------
 	// ---------------------------------------
 
 	// Solve the assignment problem
-	ofxHungarian::solve(fromSamples, toSamples, hungarianRadius);
+	ofxHungarian::solve(fromSamples, toSamples, p.hungarianRadius);
+	toSamples.insert(toSamples.end(), excludedToSamples.begin(), excludedToSamples.end());
 
 
 	// ---------------------------------------
@@ -340,11 +1299,11 @@ void ofxRTLSPostprocessor::_process_applyHungarian(RTLSProtocol::TrackableFrame&
 	// set for which mappings are changed? (e.g. if both mappings are temporary, we are
 	// throwing away a-priori information about permanent, given points that may influence 
 	// the assignment)?
+	vector<HungarianSample*> unmatchedSamples;
 	for (auto& toSample : toSamples) {
 
 		// If this sample's key is permanent, then don't remap or reconcile it.
-		if (!bAllowRemappingToPermKeyTypes &&
-			permKeyTypes.find(getTrackableKeyType(toSample.key)) != permKeyTypes.end()) {
+		if (!p.bAllowRemappingToPermKeyTypes && p.isPermanent(getTrackableKeyType(toSample.key))) {
 			continue;
 		}
 
@@ -366,135 +1325,151 @@ void ofxRTLSPostprocessor::_process_applyHungarian(RTLSProtocol::TrackableFrame&
 			// Always remove matching keys after the solve.
 			if (newKey.compare(existingKey) == 0) continue;
 
-			// Make sure the existing key is at the lowest depth possible.
-			if (isTrackableIdentifiable(newKey)) {
-
-				// Check if the existing key is already in the mappings. If so, find the last key
-				// in the chain.
-				// This shouldn't happen, but let's do it anyway (stop if overflow).
-				int counter = keyMappingRecursionLimit;
-				while (counter > 0 && keyMappings.find(existingKey) != keyMappings.end()) {
-					existingKey = keyMappings[existingKey];
-					counter--;
-				}
-				if (counter == 0) {
-					ofLogError("ofxRTLSPostprocessor") << "Hungarian algorithm key mapping depth exceeded recursion limit of " << keyMappingRecursionLimit;
-				}
-			}
+			// Make sure the existing key is the key of its identity.
+			if (isTrackableIdentifiable(newKey)) existingKey = identities.getIdentity(existingKey);
 
 			// If we're mapping from a permanent key type, we may need to skip
-			if (!bAllowRemappingFromPermKeyTypes &&
-				permKeyTypes.find(getTrackableKeyType(existingKey)) != permKeyTypes.end()) {
+			if (!p.bAllowRemappingFromPermKeyTypes && p.isPermanent(getTrackableKeyType(existingKey))) {
 				continue;
 			}
 
 			// If the new key is identifiable, add a new mapping.
-			if (isTrackableIdentifiable(newKey)) keyMappings[newKey] = existingKey;
+			if (isTrackableIdentifiable(newKey)) identities.link(newKey, existingKey);
 
 			// Reconcile the trackable by setting its new information. Set the new identifiable information.
-			reconcileTrackableWithKey(*(frame.mutable_trackables(toSample.index)), existingKey);
+			ws.setKey(toSample.index, existingKey);
 
 		}
 		else {
 			// Invalid mapping...
+			unmatchedSamples.push_back(&toSample);
+		}
+	}
+
+	// Samples that could not be matched to the last frame may belong to 
+	// tracks lost in earlier frames.
+	if (p.bReacquireLostTracks) _process_reacquireLostTracks(ws, unmatchedSamples, context);
 
-			// ... If this sample is unidentifiable and we're assigning CUIDs, then give it a CUID.
-			if (bAssignCuidsToUnidentifiableTrackables && !isTrackableIdentifiable(toSample.key)) {
+	for (auto* toSample : unmatchedSamples) {
+
+		// If this sample is unidentifiable and we're assigning CUIDs, then give it a CUID.
+		if (p.bAssignCuidsToUnidentifiableTrackables && !isTrackableIdentifiable(toSample->key)) {
 			
-				// Create a CUID
-				uint64_t cuid = cuidGen->getNewCuid();
+			// Create a CUID
+			uint64_t cuid = cuidGen->getNewCuid();
 
-				// Create a key
-				string key = getTrackableKey(KEY_CUID, ofToString(cuid));
+			// Create a key
+			string key = getTrackableKey(KEY_CUID, ofToString(cuid));
 
-				// Reconcile
-				reconcileTrackableWithKey(*(frame.mutable_trackables(toSample.index)), key);
-			}
+			// Reconcile
+			ws.setKey(toSample->index, key);
 		}
 	}
+
+	// Remember which tracks were lost in this frame
+	if (p.bReacquireLostTracks) _process_updateLostTracks(ws, context);
+	else if (!lostTracks.empty() || !trackMotions.empty()) {
+		lostTracks.clear();
+		trackMotions.clear();
+	}
+
+	if (hasHungarianReference()) hungarianReference.copyFrom(ws);
 }
 
 // --------------------------------------------------------------
-void ofxRTLSPostprocessor::_process_applyFilters(RTLSProtocol::TrackableFrame& frame) {
+void ofxRTLSPostprocessor::_process_reacquireLostTracks(ofxRTLSWorkingSet& ws, 
+	vector<HungarianSample*>& samples, const ofxRTLSPostprocessStage::Context& context) {
 
-	// For all that remain in the filter, set their new coordinates and export them
+	if (samples.empty() || lostTracks.empty()) return;
 
-	// Input the new data
-	for (int i = 0; i < frame.trackables_size(); i++) {
-		// Add new data to the filter 
-		glm::vec3 position = glm::vec3(
-			frame.trackables(i).position().x(),
-			frame.trackables(i).position().y(),
-			frame.trackables(i).position().z());
-		auto* filter = filters.getFilter(getTrackableKey(frame.trackables(i)));
-		filter->process(position);
+	// Tracks that are present in this frame are no longer lost
+	for (size_t i = 0; i < ws.size(); i++) {
+		lostTracks.remove(ws.getKey(i));
 	}
+	if (lostTracks.empty()) return;
 
-	// Process any remaining filters that haven't seen data
-	filters.processRemaining();
-
-	// Delete any data that is invalid.
-	// Also save IDs for all data that is valid.
-	set<string> existingDataIDs;
-	int i = 0;
-	while (i < frame.trackables_size()) {
-		// Check if this trackable's data is invalid.
-		ofxFilter* filter = filters.getFilter(getTrackableKey(frame.trackables(i)));
-		if (!filter->isDataValid()) {
-			// If not, delete it
-			frame.mutable_trackables()->SwapElements(i, frame.trackables_size() - 1);
-			frame.mutable_trackables()->RemoveLast();
-		}
-		else {
-			// Save that this ID has valid data
-			existingDataIDs.insert(getTrackableKey(frame.trackables(i)));
-
-			// Set this new processed data
-			glm::vec3 data = filter->getPosition();
-			frame.mutable_trackables(i)->mutable_position()->set_x(data.x);
-			frame.mutable_trackables(i)->mutable_position()->set_y(data.y);
-			frame.mutable_trackables(i)->mutable_position()->set_z(data.z);
-
-			i++;
+	// Match samples to the predicted positions of lost tracks
+	vector<glm::vec3> positions(samples.size());
+	for (int i = 0; i < samples.size(); i++) {
+		positions[i] = ws.getPosition(samples[i]->index);
+	}
+	vector<int> matches;
+	lostTracks.match(positions, context.params->reacquireRadius, context.timeMS, context.params->reacquireMaxPredictionSec, matches);
+
+	// Carry over the identities of matched tracks, as above
+	vector<string> reacquiredKeys;
+	vector<HungarianSample*> remainingSamples;
+	for (int i = 0; i < samples.size(); i++) {
+		if (matches[i] < 0) {
+			remainingSamples.push_back(samples[i]);
+			continue;
 		}
+		string newKey = samples[i]->key;
+		string existingKey = identities.getIdentity(lostTracks.get(matches[i]).key);
+		if (isTrackableIdentifiable(newKey)) identities.link(newKey, existingKey);
+		ws.setKey(samples[i]->index, existingKey);
+		reacquiredKeys.push_back(lostTracks.get(matches[i]).key);
 	}
+	for (auto& key : reacquiredKeys) lostTracks.remove(key);
+	samples.swap(remainingSamples);
+}
 
-	// Add any data that isn't present
-	for (auto& it : filters.getFilters()) {
-		// Check if this is a new ID and if it has valid data.
-		if (existingDataIDs.find(it.first) == existingDataIDs.end() && it.second->isDataValid()) {
-			// If so, add a trackable			
-			Trackable* trackable = frame.add_trackables();
-			// Set the identifiable information of this trackable
-			reconcileTrackableWithKey(*trackable, it.first);
-			// Set the position
-			Trackable::Position* position = trackable->mutable_position();
-			glm::vec3 data = it.second->getPosition();
-			position->set_x(data.x);
-			position->set_y(data.y);
-			position->set_z(data.z);
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::_process_updateLostTracks(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context) {
+
+	const ofxRTLSPostprocessorParams& p = *context.params;
+	uint64_t timeMS = context.timeMS;
+	lostTrackFrame++;
+
+	// Update the motion of every identifiable track in this frame
+	unordered_map<string, TrackMotion> motions;
+	motions.reserve(ws.size());
+	for (size_t i = 0; i < ws.size(); i++) {
+		if (!isTrackableIdentifiable(ws.getKeyType(i))) continue;
+		const string& key = ws.getKey(i);
+
+		TrackMotion m;
+		m.position = ws.getPosition(i);
+		m.timeMS = timeMS;
+		auto it = trackMotions.find(key);
+		if (it != trackMotions.end()) {
+			if (timeMS > it->second.timeMS) {
+				m.velocity = (m.position - it->second.position) / (float(timeMS - it->second.timeMS) / 1000.0f);
+			}
+			else {
+				m.velocity = it->second.velocity;
+			}
 		}
+		motions[key] = m;
 	}
 
-	// Delete any filters that haven't been used recently
-	if (ofGetElapsedTimeMillis() - lastFilterCullingTime > filterCullingPeriod) {
-		lastFilterCullingTime = ofGetElapsedTimeMillis();
-		filters.removeUnused();
+	// Tracks that were present in the last frame, but not this one, are lost
+	for (auto& it : trackMotions) {
+		if (motions.find(it.first) != motions.end()) continue;
+
+		// Only keep tracks that could be mapped to
+		TrackableKeyType keyType = getTrackableKeyType(it.first);
+		if (!p.isIncludedInHungarianMapping(keyType, p.hungarianMappingFrom)) continue;
+		if (!p.bAllowRemappingFromPermKeyTypes && p.isPermanent(keyType)) continue;
+
+		ofxRTLSLostTrackIndex::LostTrack track;
+		track.key = it.first;
+		track.position = it.second.position;
+		track.velocity = it.second.velocity;
+		track.timeMS = it.second.timeMS;
+		track.frame = lostTrackFrame - 1;
+		lostTracks.add(track);
 	}
+	trackMotions.swap(motions);
+
+	lostTracks.expire(timeMS, lostTrackFrame, uint64_t(MAX(p.reacquireMaxSec, 0.0f) * 1000.0), 
+		uint64_t(MAX(p.reacquireMaxFrames, 0)));
 }
 
 // --------------------------------------------------------------
-bool ofxRTLSPostprocessor::isIncludedInHungarianMapping(TrackableKeyType keyType, HungarianMapping mapping) {
+void ofxRTLSPostprocessor::_process_applyFilters(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context) {
 
-	if (mapping == HungarianMapping::TEMPORARY || mapping == HungarianMapping::TEMPORARY_AND_PERMANENT) {
-		if (tempKeyTypes.find(keyType) != tempKeyTypes.end()) return true;
-	}
-
-	if (mapping == HungarianMapping::PERMANENT || mapping == HungarianMapping::TEMPORARY_AND_PERMANENT) {
-		if (permKeyTypes.find(keyType) != permKeyTypes.end()) return true;
-	}
-
-	return false;
+	ofxRTLSFilterStage::apply(ws, context.timeMS, filterState);
 }
 
 // --------------------------------------------------------------
@@ -511,13 +1486,24 @@ void ofxRTLSPostprocessor::resetInternalStates() {
 	//	dataQueue.pop();
 	//}
 
-	lastFrame.Clear();
+	lastWorkingSet.clear();
+	hungarianReference.clear();
 
 	// Clear and reset keyTypes?
 
-	keyMappings.clear();
+	identities.clear();
+
+	lostTracks.clear();
+	trackMotions.clear();
+	lostTrackFrame = 0;
+
+	filterState.filters.reset();
+	filterState.lastCullingTime = 0;
 
-	filters.reset();
+	for (auto& stage : stages) stage->reset();
+	for (auto& output : outputs) {
+		for (auto& stage : output->stages) stage->reset();
+	}
 }
 
 // --------------------------------------------------------------
@@ -537,3 +1523,143 @@ void ofxRTLSPostprocessor::resetEventReceved(ofxRTLSPlayerLoopedArgs& args) {
 }
 
 // --------------------------------------------------------------
+string ofxRTLSPostprocessor::serializeState() {
+
+	// The state is a sequence of fields:
+	// [version][cuid counter][last filter culling time][identity map][last frame]
+	// [lost track frame][lost tracks][number of track motions][track motions]
+	// Strings are preceded by their length.
+	string out;
+	auto writeU64 = [&out](uint64_t value) {
+		out.append((const char*)&value, sizeof(value));
+	};
+	auto writeString = [&](const string& str) {
+		writeU64(str.size());
+		out.append(str);
+	};
+
+	writeU64(stateVersion);
+	writeU64(cuidGen != NULL ? cuidGen->getCounter() : uint64_t(cuidStartCounter));
+	writeU64(filterState.lastCullingTime);
+	writeString(identities.serialize());
+	RTLSProtocol::TrackableFrame lastFrame;
+	lastWorkingSet.toFrame(lastFrame);
+	writeString(lastFrame.SerializeAsString());
+	writeU64(lostTrackFrame);
+	writeString(lostTracks.serialize());
+	writeU64(trackMotions.size());
+	for (auto& it : trackMotions) {
+		writeString(it.first);
+		out.append((const char*)&it.second.position, sizeof(glm::vec3));
+		out.append((const char*)&it.second.velocity, sizeof(glm::vec3));
+		writeU64(it.second.timeMS);
+	}
+	return out;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSPostprocessor::deserializeState(const string& state) {
+
+	if (state.empty()) {
+		resetInternalStates();
+		return true;
+	}
+
+	size_t pos = 0;
+	bool bValid = true;
+	auto readU64 = [&]() -> uint64_t {
+		uint64_t value = 0;
+		if (pos + sizeof(value) > state.size()) {
+			bValid = false;
+			return value;
+		}
+		memcpy(&value, state.data() + pos, sizeof(value));
+		pos += sizeof(value);
+		return value;
+	};
+	auto readString = [&]() -> string {
+		uint64_t size = readU64();
+		if (!bValid || size > state.size() - pos) {
+			bValid = false;
+			return "";
+		}
+		string str = state.substr(pos, size);
+		pos += size;
+		return str;
+	};
+
+	if (readU64() != stateVersion) {
+		ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " cannot restore a state of a different version.";
+		return false;
+	}
+	uint64_t counter = readU64();
+	uint64_t cullingTime = readU64();
+	string identitiesStr = readString();
+	RTLSProtocol::TrackableFrame frame;
+	string frameStr = readString();
+	uint64_t restoredLostTrackFrame = readU64();
+	string lostTracksStr = readString();
+	unordered_map<string, TrackMotion> motions;
+	uint64_t nMotions = readU64();
+	for (uint64_t i = 0; i < nMotions && bValid; i++) {
+		string key = readString();
+		TrackMotion m;
+		if (pos + 2 * sizeof(glm::vec3) > state.size()) {
+			bValid = false;
+			break;
+		}
+		memcpy(&m.position, state.data() + pos, sizeof(glm::vec3));
+		memcpy(&m.velocity, state.data() + pos + sizeof(glm::vec3), sizeof(glm::vec3));
+		pos += 2 * sizeof(glm::vec3);
+		m.timeMS = readU64();
+		motions[key] = m;
+	}
+	ofxRTLSIdentityMap restoredIdentities;
+	ofxRTLSLostTrackIndex restoredLostTracks;
+	if (!bValid || !restoredIdentities.deserialize(identitiesStr) || !frame.ParseFromString(frameStr) ||
+		!restoredLostTracks.deserialize(lostTracksStr)) {
+		ofLogError("ofxRTLSPostprocessor") << "Postprocessor " << name << " could not parse the state to restore.";
+		return false;
+	}
+
+	// Filters cannot be restored, so they begin again.
+	resetInternalStates();
+	identities = restoredIdentities;
+	lastWorkingSet.load(frame);
+	lastWorkingSet.writeBack();
+	if (hasHungarianReference()) hungarianReference.copyFrom(lastWorkingSet);
+	lostTrackFrame = restoredLostTrackFrame;
+	lostTracks = restoredLostTracks;
+	trackMotions.swap(motions);
+	if (cuidGen != NULL) cuidGen->setCounter(counter);
+	filterState.lastCullingTime = cullingTime;
+	return true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPostprocessor::restoreEventReceived(ofxRTLSPlayerRestoreArgs& args) {
+
+	// Only proceed if internal types are valid
+	if (systemType == RTLS_SYSTEM_TYPE_INVALID) return;
+	if (trackableType == RTLS_TRACKABLE_TYPE_INVALID) return;
+
+	for (auto& entry : args.entries) {
+		if (entry.systemType != systemType || entry.trackableType != trackableType) continue;
+
+		// Queue the state, so it is restored after all data that 
+		// has already been received is processed
+		DataElem* elem = new DataElem();
+		elem->data.nullify();
+		elem->dataReadyEvent = NULL;
+		elem->bRestore = true;
+		elem->state = entry.state;
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			dataQueue.push(elem);
+		}
+		cv.notify_one();
+		return;
+	}
+}
+
+// --------------------------------------------------------------
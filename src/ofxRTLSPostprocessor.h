@@ -6,10 +6,19 @@
 #include "Trackable.pb.h"
 using namespace RTLSProtocol;
 #include "ofxRTLSTrackableKey.h"
+#include "ofxRTLSIdentityMap.h"
+#include "ofxRTLSLostTrackIndex.h"
+#include "ofxRTLSWorkingSet.h"
+#include "ofxRTLSPostprocessStage.h"
+#include "ofxRTLSSpscQueue.h"
+#include "ofxRTLSFrameBudget.h"
+#include "ofxRTLSWorkerPool.h"
+#include "ofxRTLSPostprocessorParams.h"
 
 #include "IDDictionary.h"
 #include "ofxFDeep.h"
 #include "ofxFilterGroup.h"
+#include "ofxRTLSFilterStage.h"
 #include "ofxHungarian.h"
 #include "ofxRTLSTypes.h"
 
@@ -32,11 +41,15 @@ public:
 	CuidGenerator(uint64_t startCounter) { counter = startCounter; }
 	~CuidGenerator() {};
 	uint64_t getNewCuid() { counter++; return counter; }
+	uint64_t getCounter() { return counter; }
+	void setCounter(uint64_t _counter) { counter = _counter; }
 private:
 	uint64_t counter = 0;
 };
 
 class ofxRTLSPostprocessor : public ofThread {
+	// Measures the stages of processing directly
+	friend class ofxRTLSMicrobenchmark;
 public:
 
 	// Create an object postprocess data.
@@ -46,7 +59,26 @@ public:
 	// Setup this postprocessor.
 	void setup(RTLSSystemType systemType, RTLSTrackableType trackableType, string name, string abbr, string dictPath="", string filterList="");
 
-	// Process data and send it when ready
+	// Setup this postprocessor to run synchronously on the calling thread,
+	// without a processing thread or RemoteUI parameters. Parameters are 
+	// applied from json (see applySettings). Frames must be passed to process().
+	void setupHeadless(RTLSSystemType systemType, RTLSTrackableType trackableType, string name, string abbr, const ofJson& settings);
+
+	// Apply parameters from json. Keys include "mapIDs", "dictPath", "dictAutoReload",
+	// "removeUnidentifiableBeforeHungarian", "applyHungarian", 
+	// "removeUnidentifiableBeforeFilters", "applyFilters", "filterList",
+	// a "hungarian" object (see the README for all keys), a "pipeline"
+	// (see ofxRTLSPostprocessStage), "pipelineThreads" and a "budget" object.
+	// This must be called before the postprocessor is setup.
+	void applySettings(const ofJson& settings);
+
+	// Process a frame on the calling thread. Frames are timed by their
+	// timestamps, as if played back from a take.
+	// (Only use this with headless postprocessors.)
+	void process(RTLSProtocol::TrackableFrame& frame);
+
+	// Process data and send it when ready. It is sent on the processing thread,
+	// or, when pipelined, on the thread of the last segment.
 	void processAndSend(ofxRTLSEventArgs& data, ofEvent<ofxRTLSEventArgs>& dataReadyEvent);
 
 	// Reset the postprocessor.
@@ -56,8 +88,74 @@ public:
 
 	void exit();
 
+	// Wait until every frame that has been passed to processAndSend() has
+	// been processed and sent. Stop adding frames before draining.
+	void drain();
+
 	void resetEventReceved(ofxRTLSPlayerLoopedArgs& args);
 
+	// Serialize the internal state (key mappings, cuid counter and last frame)
+	// into a binary blob, from which processing can later resume.
+	// Filter states cannot be serialized. Instead, filters must be warmed up 
+	// by processing the frames preceding the point of resumption.
+	// (Only call this from the processing thread or on headless postprocessors.)
+	string serializeState();
+	// Restore a state returned by serializeState(). Filters are reset.
+	// An empty state resets the postprocessor.
+	bool deserializeState(const string& state);
+
+	// This event is notified with the internal state before processing any
+	// frame that the player has flagged as a keyframe.
+	ofEvent<ofxRTLSPostprocessorStateArgs> stateCaptured;
+
+	// Restore a state in order with incoming data.
+	void restoreEventReceived(ofxRTLSPlayerRestoreArgs& args);
+
+	// This event is notified with the frame of each output declared in the
+	// pipeline, after the main frame is sent, on the same thread (the
+	// processing thread, or, when pipelined, the last segment's thread).
+	// The name of the output is set in the args.
+	ofEvent<ofxRTLSEventArgs> outputReady;
+	// Get the names of the outputs declared in the pipeline
+	vector<string> getOutputNames();
+
+	// This event is notified (on the processing thread) when the postprocessor
+	// changes how much it degrades processing to meet its frame budget.
+	ofEvent<ofxRTLSDegradationArgs> degradationChanged;
+
+	// Time spent in each stage of the last processed frame (microseconds)
+	struct StageTimes {
+		uint64_t mapIDs = 0;
+		uint64_t removeUnidentifiable = 0;
+		uint64_t hungarian = 0;
+		uint64_t filters = 0;
+		uint64_t other = 0;					// stages that are not built in
+		uint64_t total = 0;
+	};
+	// (This can be called from any thread.)
+	StageTimes getLastStageTimes();
+
+	// Sizes of the internal structures, for monitoring growth over long runs.
+	// (These are updated after each frame is processed.)
+	struct Diagnostics {
+		uint64_t nFramesProcessed = 0;
+		uint64_t nQueued = 0;				// frames waiting to be processed
+		uint64_t nKeyMappings = 0;
+		uint64_t nLostTracks = 0;
+		uint64_t nFilters = 0;
+		uint64_t nLastFrameTrackables = 0;
+		uint64_t cuidCounter = 0;
+		// Degradation to meet the frame budget
+		int degradationLevel = 0;
+		double projectedMicros = 0;
+		uint64_t nDegradedFrames = 0;
+		uint64_t nCoalescedFrames = 0;		// frames skipped for newer frames
+		// Timing and counters of each stage of the pipeline
+		vector<ofxRTLSPostprocessStage::Stats> stages;
+	};
+	// (Safe to call from any thread.)
+	Diagnostics getDiagnostics();
+
 private:
 
 	// Postprocessor Parameters
@@ -65,6 +163,29 @@ private:
 	RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
 	string name = "";
 	string abbr = "";
+	string filterList = "";
+
+	// Headless postprocessors have no thread and no RemoteUI params
+	bool bHeadless = false;
+
+	// The params below are changed by RemoteUI on the UI thread. Those read
+	// while processing are copied into a snapshot (see 
+	// ofxRTLSPostprocessorParams) whenever they change, and the snapshot is
+	// handed to the processing thread by swapping a pointer. The processing 
+	// thread takes the latest snapshot at the beginning of each frame, and 
+	// the frame carries it through every stage.
+	void paramChanged(RemoteUIServerCallBackArg& arg);
+	// Publish a snapshot of the current params (on the thread that sets them)
+	void publishParams();
+	// Get the latest snapshot (only on the processing thread)
+	shared_ptr<const ofxRTLSPostprocessorParams> acquireParams();
+	// A snapshot that has been published, but not yet acquired
+	atomic<ofxRTLSPostprocessorParams*> pendingParams = NULL;
+	// The snapshot acquired most recently
+	shared_ptr<const ofxRTLSPostprocessorParams> params;
+
+	// Parse the key types, load the dictionary and setup the filters
+	void setupInternals();
 
 	void threadedFunction();
 	std::condition_variable cv;
@@ -74,52 +195,174 @@ private:
 	struct DataElem {
 		ofxRTLSEventArgs data;
 		ofEvent<ofxRTLSEventArgs>* dataReadyEvent;
+		// Instead of data, this element may contain a state to restore
+		bool bRestore = false;
+		string state = "";
 	};
 	queue< DataElem* > dataQueue;
+	// Is the processing thread handling an element from the queue?
+	bool bProcessingElem = false;
+	std::condition_variable drainCv;
+
+	// The pipeline of stages. If no pipeline is declared, the built-in 
+	// stages run in their default order and are toggled by the params below.
+	ofJson pipelineSettings;
+	vector< unique_ptr<ofxRTLSPostprocessStage> > stages;
+	// Stage times that each stage adds to
+	vector<uint64_t StageTimes::*> stageTimeFields;
+	// Params that toggle the stages of the default pipeline (or null)
+	vector<bool ofxRTLSPostprocessorParams::*> stageToggles;
+	void setupPipeline();
+	// Create a stage from its entry in a pipeline (NULL if it can't be created)
+	ofxRTLSPostprocessStage* createStage(ofJson entry, string outputName, uint64_t StageTimes::*& timeField);
+
+	// A pipeline may also declare outputs, which branch from the end of its
+	// stages (see the README). Each output runs its own stages on a copy of 
+	// the frame that the shared stages produced, and is sent on outputReady.
+	// Outputs run in parallel. Stages of outputs keep their own state (e.g. 
+	// each "filters" stage has its own filters), so the Hungarian stage, 
+	// whose state belongs to the postprocessor, can't be used in an output.
+	struct Output {
+		string name;
+		vector< unique_ptr<ofxRTLSPostprocessStage> > stages;
+		ofxRTLSWorkingSet ws;
+		ofxRTLSEventArgs data;
+		bool bProcessed = false;
+	};
+	vector< unique_ptr<Output> > outputs;
+	ofxRTLSWorkerPool outputPool;
+	// Process the outputs of a frame once it has passed through the stages
+	void _processOutputs(const RTLSProtocol::TrackableFrame& frame, const ofxRTLSPostprocessStage::Context& context);
+	// Send the processed outputs (unless their frame was only replayed)
+	void sendOutputs(const ofxRTLSPlaybackInfo& playback, const string& sourceID);
+	// Run a range of stages on a working set
+	void _processStages(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context,
+		size_t beginStage, size_t endStage, StageTimes& times);
+
+	// The stages can be split into segments that run on separate threads, 
+	// so successive frames are processed by different segments at the same
+	// time. The processing thread runs the first segment. Frames are passed 
+	// between segments in order through single-producer/single-consumer
+	// queues, and each stage only runs on one thread, so its state is 
+	// updated in the order of the frames. (Headless postprocessors always
+	// run on a single thread.)
+	// Since the Hungarian stage of a frame may run before the previous frame
+	// has been filtered, a pipelined Hungarian stage refers to the previous
+	// frame as the Hungarian stage output it, not as it was output by the 
+	// postprocessor. (So does the Hungarian stage of a pipeline in which 
+	// later stages replace keys.)
+	int pipelineThreads = 1;
+	struct PipelineItem {
+		DataElem* elem = NULL;
+		ofxRTLSWorkingSet ws;
+		ofxRTLSPostprocessStage::Context context;
+		StageTimes times;
+		uint64_t startTime = 0;
+	};
+	struct Segment {
+		size_t beginStage = 0;
+		size_t endStage = 0;
+		ofxRTLSSpscQueue<PipelineItem*> input;
+		std::thread thread;
+	};
+	vector< unique_ptr<Segment> > segments;
+	// Items that are not in the pipeline (returned by the last segment)
+	vector< unique_ptr<PipelineItem> > pipelineItems;
+	ofxRTLSSpscQueue<PipelineItem*> freeItems;
+	// Number of items in the pipeline
+	int nInFlight = 0;
+	std::mutex pipelineMutex;
+	std::condition_variable pipelineCv;
+	bool isPipelined() { return segments.size() > 1; }
+	// Does a stage after the Hungarian stage replace its keys?
+	bool bKeysReplacedAfterHungarian = false;
+	// Does the Hungarian stage refer to its own output of the last frame?
+	bool hasHungarianReference() { return isPipelined() || bKeysReplacedAfterHungarian; }
+	void setupSegments();
+	void stopSegments();
+	void segmentFunction(int index);
+	// Finish an item that has passed through every segment
+	void finishItem(PipelineItem* item);
+	// Wait until all items have left the pipeline
+	void waitForPipeline();
+	// The previous frame as output by the Hungarian stage (when pipelined,
+	// or when later stages replace its keys)
+	ofxRTLSWorkingSet hungarianReference;
+	// Segment of each stage, and the segments which own the state 
+	// reported in diagnostics
+	vector<int> stageSegments;
+	int hungarianSegment = 0;
+	int filtersSegment = 0;
+
+	// Processing is degraded when a frame is projected to exceed its budget
+	// (see ofxRTLSFrameBudget). The degradations of each frame are passed to
+	// the stages in its context.
+	int frameBudgetMicros = 0;		// 0 disables
+	string degradationsStr = "shrinkHungarian,skipOptional,coalesce";	// in order of priority
+	int degradedHungarianMaxSamples = 32;
+	float budgetSmoothing = 0.1;
+	int budgetRecoverFrames = 30;
+	float budgetRecoverRatio = 0.8;
+	ofxRTLSFrameBudget budget;
+	void setupBudget();
+	// Choose the degradations of a frame and report changes
+	void scheduleFrame(ofxRTLSPostprocessStage::Context& context);
+	int lastDegradationLevel = 0;
+	// Can this element be skipped when a newer frame is waiting?
+	bool isCoalescable(DataElem* elem);
+	uint64_t nCoalescedFrames = 0;
 
 	// Process a data element
 	void _process(RTLSProtocol::TrackableFrame& frame);
-	void _process_mapIDs(RTLSProtocol::TrackableFrame& frame);
-	void _process_applyHungarian(RTLSProtocol::TrackableFrame& frame);
-	void _process_removeUnidentifiable(RTLSProtocol::TrackableFrame& frame);
-	void _process_applyFilters(RTLSProtocol::TrackableFrame& frame);
+	void _process_mapIDs(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context);
+	void _process_applyHungarian(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context);
+	void _process_reacquireLostTracks(ofxRTLSWorkingSet& ws, vector<HungarianSample*>& samples, const ofxRTLSPostprocessStage::Context& context);
+	void _process_updateLostTracks(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context);
+	void _process_removeUnidentifiable(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context);
+	void _process_applyFilters(ofxRTLSWorkingSet& ws, const ofxRTLSPostprocessStage::Context& context);
 	bool bMapIDs = true;
 	bool bRemoveUnidentifiableBeforeHungarian = true;
 	bool bApplyHungarian = true;
 	bool bRemoveUnidentifiableBeforeFilters = true;
 	bool bApplyFilters = true;
+	// Published when each frame is finished (guarded by diagnosticsMutex)
+	StageTimes stageTimes;
+	std::mutex diagnosticsMutex;
+	Diagnostics diagnostics;
+	// Update the diagnostics owned by a segment
+	void updateDiagnostics(int segment = 0);
 
-	RTLSProtocol::TrackableFrame lastFrame;
+	// Keys and positions of the frame being processed, and of the last 
+	// frame processed (as output)
+	ofxRTLSWorkingSet workingSet;
+	ofxRTLSWorkingSet lastWorkingSet;
 
 	// Dictionary for mapping IDs
 	IDDictionary dict;
 	string dictPath = "";
+	// Reload the dictionary when its file changes
+	bool bDictAutoReload = false;
 
 
 	// Hungarian Algorithm-related Parameters
 	// Temporary and Permanently Identifiable Fields
 	string tempKeyTypesStr = "cuid,none";	// key types that may change per trackable
 	string permKeyTypesStr = "id,name";	// key types that will not change per trackable
-	set<TrackableKeyType> tempKeyTypes;
-	set<TrackableKeyType> permKeyTypes;
 	// Radius of the items (for calculating intersection)
 	// (If items are farther apart then this, no intersection is calculated and 
 	// the item cannot be tracked).
 	float hungarianRadius = 0.1;
 	// How are samples mapped?
-	enum HungarianMapping {
-		TEMPORARY = 0,
-		PERMANENT,
-		TEMPORARY_AND_PERMANENT
-	};
-	HungarianMapping hungarianMappingFrom = TEMPORARY;
-	HungarianMapping hungarianMappingTo = TEMPORARY;
-	bool isIncludedInHungarianMapping(TrackableKeyType keyType, HungarianMapping mapping);
+	typedef ofxRTLSPostprocessorParams::HungarianMapping HungarianMapping;
+	HungarianMapping hungarianMappingFrom = HungarianMapping::TEMPORARY;
+	HungarianMapping hungarianMappingTo = HungarianMapping::TEMPORARY;
 	// These key mappings are the byproduct of the hungarian algorithm, and
 	// should be applied in the step before filtering.
-	map<string, string> keyMappings;
-	// What is the recursion limit of the mappings? (for safety)
-	int keyMappingRecursionLimit = 100;
+	ofxRTLSIdentityMap identities;
+	// Mappings are forgotten once their tracks have not been seen for this
+	// many seconds or frames (0 disables either criterion).
+	float mappingHorizonSec = 60.0;
+	int mappingHorizonFrames = 0;
 	// Before solving, should samples with keys that appear in both the FROM and 
 	// TO sets be removed? This likely speeds up the solver by removing superfluous
 	// samples for which there are already matches.
@@ -128,7 +371,7 @@ private:
 	bool bAssignCuidsToUnidentifiableTrackables = false;
 	// What number should the counter start at?
 	int cuidStartCounter = 80000;
-	CuidGenerator* cuidGen;
+	CuidGenerator* cuidGen = NULL;
 	// Are remappings from permanent key types allowed?
 	// (If so, it is highly recommended that you remove matching keys before solve, 
 	// since this will prevent permanent IDs from separating during tracking.)
@@ -139,14 +382,41 @@ private:
 	// For example, what if a trackable with a temporary CUID suddently turns
 	// into an identifiable trackable with a permanent ID?
 	bool bAllowRemappingToPermKeyTypes = false;
+	// Should tracks that disappear for a few frames be reacquired?
+	// Samples that the solver could not match to the last frame are matched
+	// to the predicted positions of recently lost tracks (within the reacquire
+	// radius), and take on their identities instead of new ones.
+	bool bReacquireLostTracks = false;
+	float reacquireRadius = 0.1;
+	// Lost tracks are forgotten after this many seconds or frames 
+	// (0 disables either criterion)
+	float reacquireMaxSec = 0.5;
+	int reacquireMaxFrames = 30;
+	// Positions are predicted with constant velocity for at most this long
+	float reacquireMaxPredictionSec = 0.2;
+	ofxRTLSLostTrackIndex lostTracks;
+	// Motion of the identifiable tracks in the last frame
+	struct TrackMotion {
+		glm::vec3 position = glm::vec3(0, 0, 0);
+		glm::vec3 velocity = glm::vec3(0, 0, 0);	// units per second
+		uint64_t timeMS = 0;
+	};
+	unordered_map<string, TrackMotion> trackMotions;
+	// Frames seen by the lost track index
+	uint64_t lostTrackFrame = 0;
 
 
 	// Filters for smoothing data, etc.
-	ofxFilterGroup filters;
-	// When was the last time filters were culled? (ms)
-	uint64_t lastFilterCullingTime = 0;
-	// What is the period by which filters are culled? (ms)
-	uint64_t filterCullingPeriod = 1000; // each second
+	ofxRTLSFilterStage::State filterState;
+	// Time of the data currently being processed (us). Played back data
+	// uses its time in the take, so processing is repeatable.
+	uint64_t processTimeMicros = 0;
+	bool bProcessPlayback = false;
+	// Get the time at which a frame was captured (us)
+	static uint64_t getFrameTimeMicros(const ofxRTLSEventArgs& data);
+
+	// Version of the serialized state format
+	const uint64_t stateVersion = 3;
 
 	atomic<bool> flagReset = false;
 	void resetInternalStates();
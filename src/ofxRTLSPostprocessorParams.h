@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSTrackableKey.h"
+#include "ofxRTLSFrameBudget.h"
+
+// The parameters of a postprocessor that are read while processing frames.
+// RemoteUI changes parameters on the UI thread, while frames are processed on
+// other threads. Whenever parameters change, the postprocessor publishes a new
+// snapshot of them, and each frame uses the latest snapshot from its
+// beginning to its end (see ofxRTLSPostprocessStage::Context). Snapshots are
+// never modified once published, so they can be read without locks.
+struct ofxRTLSPostprocessorParams {
+
+	// Toggles of the stages of the default pipeline
+	bool bMapIDs = true;
+	bool bRemoveUnidentifiableBeforeHungarian = true;
+	bool bApplyHungarian = true;
+	bool bRemoveUnidentifiableBeforeFilters = true;
+	bool bApplyFilters = true;
+
+	// Frame budget
+	int frameBudgetMicros = 0;
+	int degradedHungarianMaxSamples = 32;
+	// Degradations in order of priority, parsed from their list
+	vector<ofxRTLSFrameBudget::Degradation> degradations;
+
+	// Hungarian (see ofxRTLSPostprocessor for descriptions)
+	// Key types, parsed from their lists when the snapshot is made
+	set<TrackableKeyType> tempKeyTypes;
+	set<TrackableKeyType> permKeyTypes;
+	float hungarianRadius = 0.1;
+	enum HungarianMapping {
+		TEMPORARY = 0,
+		PERMANENT,
+		TEMPORARY_AND_PERMANENT
+	};
+	HungarianMapping hungarianMappingFrom = TEMPORARY;
+	HungarianMapping hungarianMappingTo = TEMPORARY;
+	float mappingHorizonSec = 60.0;
+	int mappingHorizonFrames = 0;
+	bool bRemoveMatchingKeysBeforeSolve = true;
+	bool bAssignCuidsToUnidentifiableTrackables = false;
+	bool bAllowRemappingFromPermKeyTypes = false;
+	bool bAllowRemappingToPermKeyTypes = false;
+	bool bReacquireLostTracks = false;
+	float reacquireRadius = 0.1;
+	float reacquireMaxSec = 0.5;
+	int reacquireMaxFrames = 30;
+	float reacquireMaxPredictionSec = 0.2;
+
+	// Is this key type in the dataset of a mapping?
+	bool isIncludedInHungarianMapping(TrackableKeyType keyType, HungarianMapping mapping) const {
+		if (mapping == TEMPORARY || mapping == TEMPORARY_AND_PERMANENT) {
+			if (tempKeyTypes.find(keyType) != tempKeyTypes.end()) return true;
+		}
+		if (mapping == PERMANENT || mapping == TEMPORARY_AND_PERMANENT) {
+			if (permKeyTypes.find(keyType) != permKeyTypes.end()) return true;
+		}
+		return false;
+	}
+	bool isPermanent(TrackableKeyType keyType) const {
+		return permKeyTypes.find(keyType) != permKeyTypes.end();
+	}
+};
@@ -0,0 +1,115 @@
+#include "ofxRTLSPredictStage.h"
+
+// --------------------------------------------------------------
+ofxRTLSPredictStage::ofxRTLSPredictStage() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSPredictStage::~ofxRTLSPredictStage() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPredictStage::setup(const ofJson& settings) {
+
+	leadMicros = uint64_t(MAX(settings.value("leadMS", 0.0), 0.0) * 1000.0);
+	bCompensateCapture = settings.value("compensateCapture", bCompensateCapture);
+	maxPredictionMicros = uint64_t(MAX(settings.value("maxPredictionMS", 50.0), 0.0) * 1000.0);
+	alpha = ofClamp(settings.value("alpha", alpha), 0, 1);
+	beta = ofClamp(settings.value("beta", beta), 0, 2);
+	gamma = ofClamp(settings.value("gamma", gamma), 0, 2);
+	warmupFrames = MAX(settings.value("warmupFrames", warmupFrames), 1);
+	residualScale = MAX(settings.value("residualScale", residualScale), 1.0E-6f);
+	forgetMicros = uint64_t(MAX(settings.value("forgetMS", 1000.0), 0.0) * 1000.0);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPredictStage::reset() {
+
+	tracks.clear();
+	lastCullTime = 0;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPredictStage::process(ofxRTLSWorkingSet& ws, const Context& context) {
+
+	uint64_t frameTime = context.timeMicros != 0 ? context.timeMicros : context.timeMS * 1000;
+
+	// Predict to the present (plus the lead). Played back frames are timed
+	// in their take, so only their lead is compensated.
+	uint64_t horizon = leadMicros;
+	if (bCompensateCapture && !context.bPlayback) {
+		uint64_t now = ofGetElapsedTimeMicros();
+		if (now > frameTime) horizon += now - frameTime;
+	}
+	uint64_t boundedHorizon = MIN(horizon, maxPredictionMicros);
+	if (boundedHorizon < horizon) count("bounded");
+
+	for (size_t i = 0; i < ws.size(); i++) {
+		if (ws.isRemoved(i) || ws.getKeyType(i) == KEY_NONE) continue;
+
+		// Update the track with the position received
+		auto it = tracks.find(ws.getKey(i));
+		if (it == tracks.end()) {
+			Track track;
+			track.position = ws.getPosition(i);
+			track.timeMicros = frameTime;
+			track.nFrames = 1;
+			tracks[ws.getKey(i)] = track;
+			continue;
+		}
+		Track& track = it->second;
+		update(track, ws.getPosition(i), frameTime);
+
+		// Predict the track as far as its confidence allows
+		float h = float(boundedHorizon) * 1.0E-6f * getConfidence(track);
+		if (h <= 0) continue;
+		ws.setPosition(i, track.position + track.velocity * h + 0.5f * track.acceleration * h * h);
+		count("predicted");
+	}
+
+	// Forget tracks that haven't been seen recently
+	if (frameTime > lastCullTime + forgetMicros || frameTime < lastCullTime) {
+		lastCullTime = frameTime;
+		for (auto it = tracks.begin(); it != tracks.end(); ) {
+			if (it->second.timeMicros + forgetMicros < frameTime || it->second.timeMicros > frameTime) it = tracks.erase(it);
+			else it++;
+		}
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSPredictStage::update(Track& track, const glm::vec3& position, uint64_t timeMicros) {
+
+	// Restart tracks that were lost, or that go back in time (e.g. when
+	// playback loops)
+	if (timeMicros <= track.timeMicros || timeMicros - track.timeMicros > forgetMicros) {
+		track = Track();
+		track.position = position;
+		track.timeMicros = timeMicros;
+		track.nFrames = 1;
+		return;
+	}
+
+	float dt = float(timeMicros - track.timeMicros) * 1.0E-6f;
+	glm::vec3 predicted = track.position + track.velocity * dt + 0.5f * track.acceleration * dt * dt;
+	glm::vec3 residual = position - predicted;
+
+	track.position = predicted + alpha * residual;
+	track.velocity += track.acceleration * dt + (beta / dt) * residual;
+	// Acceleration needs three frames to be estimated
+	if (track.nFrames >= 2) track.acceleration += (2.0f * gamma / (dt * dt)) * residual;
+	// Until then, the residual only reflects the missing velocity
+	if (track.nFrames >= 2) track.residual = 0.8f * track.residual + 0.2f * glm::length(residual);
+	track.timeMicros = timeMicros;
+	track.nFrames++;
+}
+
+// --------------------------------------------------------------
+float ofxRTLSPredictStage::getConfidence(const Track& track) {
+
+	float warmup = MIN(float(track.nFrames - 1) / float(warmupFrames), 1.0f);
+	float r = track.residual / residualScale;
+	return warmup / (1.0f + r * r);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSPostprocessStage.h"
+
+// Compensates latency by predicting where each track will be at a target
+// time: the time of the frame, plus the time that has passed since it was
+// captured, plus a lead for the latency downstream (e.g. rendering and
+// projection).
+//
+// Each track (by its key) keeps estimates of its position, velocity and
+// acceleration, updated by an alpha-beta-gamma filter from the positions it
+// receives, and is extrapolated along them. The prediction horizon of a track
+// is bounded, and scaled by its confidence: confidence grows as a track is
+// seen over more frames, and falls as its positions depart from what was
+// predicted for them (e.g. when it turns sharply), so erratic tracks are
+// predicted less far. Tracks without keys are not predicted.
+//
+// This stage should follow the filters, and is best used in an output (see
+// ofxRTLSPostprocessor), so the Hungarian stage matches the next frame to
+// measured rather than predicted positions. Stage settings (see
+// ofxRTLSPostprocessStage):
+//	"leadMS"				latency downstream to compensate (default 0)
+//	"compensateCapture"		also compensate the time since the frame was
+//							captured (default true)
+//	"maxPredictionMS"		bound on the prediction horizon (default 50)
+//	"alpha", "beta", "gamma"	gains of the filter (defaults 0.5, 0.4, 0.1)
+//	"warmupFrames"			frames before a track is fully confident (default 10)
+//	"residualScale"			distance from the predicted position at which a
+//							track's confidence halves (default 0.01)
+//	"forgetMS"				time after which unseen tracks are forgotten (default 1000)
+class ofxRTLSPredictStage : public ofxRTLSPostprocessStage {
+public:
+
+	ofxRTLSPredictStage();
+	~ofxRTLSPredictStage();
+
+	void setup(const ofJson& settings);
+	void process(ofxRTLSWorkingSet& ws, const Context& context);
+	void reset();
+
+	size_t getNumTracks() { return tracks.size(); }
+
+private:
+
+	uint64_t leadMicros = 0;
+	bool bCompensateCapture = true;
+	uint64_t maxPredictionMicros = 50000;
+	float alpha = 0.5;
+	float beta = 0.4;
+	float gamma = 0.1;
+	int warmupFrames = 10;
+	float residualScale = 0.01;
+	uint64_t forgetMicros = 1000000;
+
+	struct Track {
+		glm::vec3 position;
+		glm::vec3 velocity;		// units per second
+		glm::vec3 acceleration;	// units per second squared
+		uint64_t timeMicros = 0;
+		int nFrames = 0;
+		// Smoothed distance of positions from their predictions
+		float residual = 0;
+	};
+	unordered_map<string, Track> tracks;
+
+	// Update a track with a position at a time
+	void update(Track& track, const glm::vec3& position, uint64_t timeMicros);
+	// Confidence of a track, in [0, 1]
+	float getConfidence(const Track& track);
+
+	uint64_t lastCullTime = 0;
+};
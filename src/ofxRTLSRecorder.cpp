@@ -133,27 +133,11 @@ void ofxRTLSRecorder::add(int systemIndex, float systemFPS, RTLSProtocol::Tracka
 	// Get the last take
 	auto take = takeQueue.back();
 
-	// Ensure this system has been approved by the take
-	if (!take->systemExists(systemIndex)) {
-		// If not, will it?
-		if (take->fps < 0) take->fps = systemFPS;
-		else if (abs(take->fps - systemFPS) > 0.001) {
-			ofLogWarning("ofxRTLSRecorder") << "Cannot record from multiple systems at once that have different frame rates";
-			return;
-		}
-		// Take can accept system, so add it
-		take->data[systemIndex] = RTLSTake::RTLSTakeSystemData();
-	}
+	// Add this frame
+	if (!take->add(systemIndex, systemFPS, _frame)) return;
 
 	// If this is the first frame, set the start time
 	if (take->startTimeMS == 0) take->startTimeMS = ofGetElapsedTimeMillis();
-
-	// Get the system data
-	auto& data = take->data[systemIndex];
-
-	// Add this frame
-	RTLSProtocol::TrackableFrame* frame = new RTLSProtocol::TrackableFrame(_frame);
-	data.nextFrame.push_back(frame);
 }
 
 // --------------------------------------------------------------
@@ -172,56 +156,21 @@ void ofxRTLSRecorder::update(int systemIndex) {
 	// Get the last take
 	auto take = takeQueue.back();
 
-	// Make sure this system is present in the recording
-	if (!take->systemExists(systemIndex)) return;
-
-	// Get this system data
-	auto& data = take->data[systemIndex];
-
-	// Include all trackable keys in the label set
-	for (auto& frame : data.nextFrame) {
-		for (int i = 0; i < frame->trackables_size(); i++) {
-			auto& tk = frame->trackables(i);
-			string key = getTrackableKey(tk);
-			auto ret = take->c3dPointLabels.insert(key);
-			
-			// Add a description if it is a new element
-			if (ret.second) {
+	// Collect the labels of this system's frame and add it to the take
+	take->update(systemIndex);
+}
 
-				// Parse the frame-specific context
-				ofJson frameContext;
-				try {
-					frameContext = ofJson::parse(frame->context());
-				}
-				catch (const std::exception&) {
-					// Could not parse
-				}
-				
-				// Parse the trackable-specific context
-				ofJson trackableContext;
-				try {
-					trackableContext = ofJson::parse(frame->trackables(i).context());
-				}
-				catch (const std::exception&) {
-					// Could not parse
-				}
+// --------------------------------------------------------------
+ofxRTLSRecorder::Diagnostics ofxRTLSRecorder::getDiagnostics() {
 
-				// Add all information to the descriptions
-				// TODO: Allow both trackable and frame context to pass calibration flags 'm'
-				ofJson js;
-				if (frameContext.find("s") != frameContext.end()) js["frame"]["context"]["s"] = frameContext["s"];
-				if (frameContext.find("t") != frameContext.end()) js["frame"]["context"]["t"] = frameContext["t"];
-				if (!trackableContext.empty()) js["trackable"]["context"] = trackableContext;				
-				if (!tk.name().empty()) js["trackable"]["name"] = tk.name();
-				if (!tk.cuid().empty()) js["trackable"]["cuid"] = tk.cuid();
-				if (tk.id() != 0) js["trackable"]["id"] = tk.id();
-				take->c3dPointLabels2Desc[key] = js.dump();
-			}
-		}
+	Diagnostics out;
+	std::lock_guard<std::mutex> lk(mutex);
+	out.nQueuedTakes = takeQueue.size();
+	if (bRecording && !takeQueue.empty()) {
+		out.nRecordingFrames = takeQueue.back()->getNumFrames();
+		out.nRecordingLabels = takeQueue.back()->c3dPointLabels.size();
 	}
-
-	// Add the vector of frames to the queue and clear the vector
-	data.addNextFrame();
+	return out;
 }
 
 // --------------------------------------------------------------
@@ -329,129 +278,7 @@ bool ofxRTLSRecorder::saveTake(RTLSTake* take) {
 	isTakeSaving = true;
 	
 	// Proceed with saving the take
-	auto& c3d = take->c3d;
-
-	// Add all point labels
-	for (auto& label : take->c3dPointLabels) {
-		c3d.point(label);
-	}
-
-	// Create a map from point labels to their index
-	map<string, int> c3dPointLabels2Index;
-	uint64_t counter = 0;
-	for (auto& label : take->c3dPointLabels) {
-		c3dPointLabels2Index[label] = counter;
-		counter++;
-	}
-	
-	// Set the recording's properties, after adding the points.
-
-	// Point Properties
-	ezc3d::ParametersNS::GroupNS::Parameter pointRate("RATE");
-	pointRate.set(take->fps);
-	c3d.parameter("POINT", pointRate);
-	ezc3d::ParametersNS::GroupNS::Parameter pointScale("SCALE");
-	pointScale.set(-1.0);
-	c3d.parameter("POINT", pointScale);
-	ezc3d::ParametersNS::GroupNS::Parameter pointUnits("UNITS");
-	pointUnits.set("m");
-	c3d.parameter("POINT", pointUnits);
-	ezc3d::ParametersNS::GroupNS::Parameter pointDescriptions("DESCRIPTIONS");
-	vector<string> pointDesc;
-	for (auto& label : take->c3dPointLabels) {
-		if (take->c3dPointLabels2Desc.find(label) != take->c3dPointLabels2Desc.end()) {
-			pointDesc.push_back(take->c3dPointLabels2Desc[label]);
-		}
-		else {
-			pointDesc.push_back("");
-		}
-	}
-	pointDescriptions.set(pointDesc);
-	c3d.parameter("POINT", pointDescriptions);
-
-	// Manufacturer Properties
-	ezc3d::ParametersNS::GroupNS::Parameter mfrCompany("COMPANY");
-	mfrCompany.set("Local Projects");
-	c3d.parameter("MANUFACTURER", mfrCompany);
-	ezc3d::ParametersNS::GroupNS::Parameter mfrSoftware("SOFTWARE");
-	mfrSoftware.set("RTLSServer");
-	c3d.parameter("MANUFACTURER", mfrSoftware);
-	ezc3d::ParametersNS::GroupNS::Parameter mfrSoftwareDesc("SOFTWARE_DESCRIPTION");
-	mfrSoftwareDesc.set("Real Time Location System Server");
-	c3d.parameter("MANUFACTURER", mfrSoftwareDesc);
-	ezc3d::ParametersNS::GroupNS::Parameter mfrVersion("VERSION_LABEL");
-	mfrVersion.set("1.0"); // arbitrary
-	c3d.parameter("MANUFACTURER", mfrVersion);
-
-	
-	// Add all points
-	// NAN will stand for absent points
-	int nPoints = take->c3dPointLabels.size();
-	while (!take->empty()) {
-
-		// Create a new c3d frame 
-		ezc3d::DataNS::Frame frame;
-
-		// Create points and populate each with NANs
-		ezc3d::DataNS::Points3dNS::Points points;
-		for (int i = 0; i < nPoints; i++) {
-			ezc3d::DataNS::Points3dNS::Point point;
-			point.set(NAN, NAN, NAN);
-			points.point(point);
-		}
-
-		// Iterate through all contributing systems
-		map<int, RTLSTake::RTLSTakeSystemData>::iterator sys;
-		for (sys = take->data.begin(); sys != take->data.end(); sys++) {
-
-			// Get the queue of frames. Each frame is a vector of TrackableFrames (TF's), since
-			// one system can output multiple TF's each frame (for example, Motive can export
-			// both observer and marker points each frame).
-			queue<vector<RTLSProtocol::TrackableFrame*>>& frameQueue = sys->second.frames;
-			// If the frame is empty, then there are no points left to add.
-			if (frameQueue.empty()) continue;
-			
-			// Get the next set of trackable frames
-			vector<RTLSProtocol::TrackableFrame*>& frameSet = frameQueue.front();
-			// Iterate through all of these frames
-			RTLSProtocol::TrackableFrame* tkFrame;
-			for (int frameIndex = 0; frameIndex < frameSet.size(); frameIndex++) {
-				tkFrame = frameSet[frameIndex];
-
-				// For each frame, iterate through all of its trackables
-				for (int i = 0; i < tkFrame->trackables_size(); i++) {
-					
-					// Get the next trackable in this TF
-					auto& tk = tkFrame->trackables(i);
-
-					// Get the key and access the point corresponding with this key.
-					string key = getTrackableKey(tk);
-					auto& point = points.point(c3dPointLabels2Index[key]); // check for valid index?
-					// Set the position
-					point.set(
-						tk.position().x(), 
-						tk.position().y(), 
-						tk.position().z());
-				}
-			}
-
-			// Pop the front value that we just processed from the queue.
-			sys->second.clearAndPopNextFrame();
-		}
-
-		// Add the points to the frame
-		frame.add(points);
-
-		// Add the frame to the take
-		c3d.frame(frame);
-
-		// Increment the number of frames saved
-		++takeSavingFramesSaved;
-	}
-	
-	// Save the c3d to file
-	ofFilePath::createEnclosingDirectory(take->path);
-	c3d.write(take->path);
+	take->save(&takeSavingFramesSaved);
 
 	// Flag that we are done saving
 	isTakeSaving = false;
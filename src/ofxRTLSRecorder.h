@@ -55,6 +55,14 @@ public:
 	bool isSaving() { return isTakeSaving; }
 	float getSavingPercentageComplete();
 
+	// Sizes of the takes held in memory, for monitoring growth over long runs
+	struct Diagnostics {
+		uint64_t nQueuedTakes = 0;		// takes recording or waiting to be saved
+		uint64_t nRecordingFrames = 0;	// frames in the take being recorded
+		uint64_t nRecordingLabels = 0;	// point labels in the take being recorded
+	};
+	Diagnostics getDiagnostics();
+
 	// Event notified when a recording
 	// begins or ends.
 	ofEvent<ofxRTLSRecordingArgs> recordingEvent;
@@ -91,102 +99,6 @@ private:
 	atomic<bool> flagUnlock = false;
 
 	// Queue holds data that is actively being written to or saved
-	class RTLSTake {
-	public:
-
-		// Frame data from a single system
-		struct RTLSTakeSystemData {
-			queue< vector< RTLSProtocol::TrackableFrame* > > frames;
-			vector< RTLSProtocol::TrackableFrame* > nextFrame;
-			void addNextFrame() {
-				frames.push(nextFrame);
-				nextFrame.clear();
-			}
-			void clearAndPopNextFrame() {
-				if (frames.empty()) return;
-				for (int i = 0; i < frames.front().size(); i++) {
-					frames.front()[i]->Clear();
-					delete frames.front()[i];
-				}
-				frames.front().clear();
-				frames.pop();
-			}
-			void clear() {
-				for (auto f : nextFrame) {
-					f->Clear();
-					delete f;
-				}
-				nextFrame.clear();
-				while (!frames.empty()) {
-					clearAndPopNextFrame();
-				}
-			}
-			int size() { return frames.size(); }
-			bool empty() { return frames.empty(); }
-		};
-
-		// All pieces of data present in this take
-		// Map of system index to a queue of frames
-		map<int, RTLSTakeSystemData > data;
-		bool systemExists(int systemIndex) {
-			return data.find(systemIndex) != data.end();
-		}
-		// Start time of this take
-		uint64_t startTimeMS = 0;
-		// Flag whether we want to save this take
-		bool bFlagSave = false;
-		// What is the global FPS for this take?
-		float fps = -1;
-
-		// Is this take empty?
-		bool empty() {
-			if (data.size() == 0) return true;
-			for (auto it : data) {
-				if (!it.second.empty()) return false;
-			}
-			return true;
-		}
-
-		// Is this take valid?
-		bool valid() {
-			return fps > 0;
-		}
-
-		// Clear all the data in this take
-		void clear() {
-			auto it = data.begin();
-			while (it != data.end()) {
-				it->second.clear();
-				it = data.erase(it);
-			}
-		}
-
-		// What is the number of frames for this take?
-		// Note: This reports the current, not absolute
-		// number of frames. As such, this is only valid is data
-		// has not already been removed in the saving process.
-		int getNumFrames()
-		{
-			int nFrames = 0;
-			for (auto& item : data)
-			{
-				if (item.second.size() > nFrames) nFrames = item.second.size();
-			}
-			return nFrames;
-		}
-		
-		// C3D data structure
-		// This cannot be written in real time because all of the trackable (point)
-		// labels must be collected and written to the c3d header before storing
-		// positions, etc.
-		ezc3d::c3d c3d;
-		// Path to save this c3d file
-		string path = "";
-		// What are all of the present labels that describe the points
-		set<string> c3dPointLabels;
-		// What are the descriptions for each label?
-		map<string, string> c3dPointLabels2Desc;
-	};
 	queue< RTLSTake* > takeQueue;
 	
 	bool saveTake(RTLSTake* take);
@@ -0,0 +1,189 @@
+#include "ofxRTLSSoakMonitor.h"
+
+#if defined(TARGET_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(TARGET_OSX)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+// --------------------------------------------------------------
+ofxRTLSSoakMonitor::ofxRTLSSoakMonitor() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSSoakMonitor::~ofxRTLSSoakMonitor() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSoakMonitor::setup(const ofJson& js) {
+
+	samplePeriodSec = MAX(js.value("samplePeriodSec", samplePeriodSec), 0.001f);
+	warmupSec = MAX(js.value("warmupSec", warmupSec), 0.0f);
+	minSamples = MAX(js.value("minSamples", minSamples), 2);
+	logPath = js.value("logPath", logPath);
+	if (js.find("maxGrowthPerHour") != js.end() && js["maxGrowthPerHour"].is_object()) {
+		maxGrowthPerHour = js["maxGrowthPerHour"];
+	}
+	else {
+		maxGrowthPerHour = ofJson::object();
+	}
+
+	bStarted = false;
+	samples.clear();
+	lastValues.clear();
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSSoakMonitor::update(const map<string, double>& metrics) {
+
+	uint64_t thisTime = ofGetElapsedTimeMillis();
+	if (!bStarted) {
+		bStarted = true;
+		startTimeMS = thisTime;
+	}
+	else if (thisTime - lastSampleTimeMS < uint64_t(samplePeriodSec * 1000.0)) {
+		return false;
+	}
+	lastSampleTimeMS = thisTime;
+
+	map<string, double> values = metrics;
+	values["process.memoryBytes"] = double(getProcessMemoryBytes());
+
+	double elapsedSec = double(thisTime - startTimeMS) / 1000.0;
+	for (auto& it : values) {
+		lastValues[it.first] = it.second;
+		if (elapsedSec >= warmupSec) samples[it.first].push_back(make_pair(elapsedSec / 3600.0, it.second));
+	}
+
+	// Log this sample
+	if (!logPath.empty()) {
+		ofJson js;
+		js["timeSec"] = elapsedSec;
+		js["warm"] = elapsedSec >= warmupSec;
+		for (auto& it : values) js["metrics"][it.first] = it.second;
+		ofstream log(ofToDataPath(logPath), ios::app);
+		log << js.dump() << endl;
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSSoakMonitor::isFailing() {
+
+	for (auto& it : samples) {
+		if (it.second.size() < minSamples) continue;
+		double threshold;
+		if (!getThreshold(it.first, threshold)) continue;
+		if (getGrowthPerHour(it.second) > threshold) return true;
+	}
+	return false;
+}
+
+// --------------------------------------------------------------
+float ofxRTLSSoakMonitor::getElapsedSec() {
+	if (!bStarted) return 0;
+	return float(ofGetElapsedTimeMillis() - startTimeMS) / 1000.0;
+}
+
+// --------------------------------------------------------------
+ofJson ofxRTLSSoakMonitor::getReport() {
+
+	ofJson js;
+	js["elapsedSec"] = getElapsedSec();
+	js["failing"] = false;
+	for (auto& it : lastValues) {
+		ofJson m;
+		m["value"] = it.second;
+		auto s = samples.find(it.first);
+		size_t nSamples = s == samples.end() ? 0 : s->second.size();
+		m["samples"] = nSamples;
+		double threshold;
+		bool bJudged = getThreshold(it.first, threshold) && nSamples >= minSamples;
+		if (nSamples >= 2) m["growthPerHour"] = getGrowthPerHour(s->second);
+		if (bJudged) {
+			m["maxGrowthPerHour"] = threshold;
+			m["pass"] = m["growthPerHour"].get<double>() <= threshold;
+			if (!m["pass"].get<bool>()) js["failing"] = true;
+		}
+		js["metrics"][it.first] = m;
+	}
+	return js;
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSSoakMonitor::getThreshold(const string& metric, double& threshold) {
+
+	if (maxGrowthPerHour.find(metric) != maxGrowthPerHour.end()) {
+		threshold = maxGrowthPerHour[metric];
+		return true;
+	}
+	size_t pos = metric.rfind('.');
+	if (pos != string::npos) {
+		string suffix = "*" + metric.substr(pos);
+		if (maxGrowthPerHour.find(suffix) != maxGrowthPerHour.end()) {
+			threshold = maxGrowthPerHour[suffix];
+			return true;
+		}
+	}
+	if (maxGrowthPerHour.find("*") != maxGrowthPerHour.end()) {
+		threshold = maxGrowthPerHour["*"];
+		return true;
+	}
+	return false;
+}
+
+// --------------------------------------------------------------
+double ofxRTLSSoakMonitor::getGrowthPerHour(const vector< pair<double, double> >& series) {
+
+	if (series.size() < 2) return 0;
+	double meanT = 0;
+	double meanV = 0;
+	for (auto& p : series) {
+		meanT += p.first;
+		meanV += p.second;
+	}
+	meanT /= double(series.size());
+	meanV /= double(series.size());
+	double num = 0;
+	double den = 0;
+	for (auto& p : series) {
+		num += (p.first - meanT) * (p.second - meanV);
+		den += (p.first - meanT) * (p.first - meanT);
+	}
+	if (den <= 0) return 0;
+	return num / den;
+}
+
+// --------------------------------------------------------------
+uint64_t ofxRTLSSoakMonitor::getProcessMemoryBytes() {
+
+#if defined(TARGET_WIN32)
+	PROCESS_MEMORY_COUNTERS_EX pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&pmc, sizeof(pmc))) {
+		return pmc.PrivateUsage;
+	}
+	return 0;
+#elif defined(TARGET_OSX)
+	mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS) {
+		return info.resident_size;
+	}
+	return 0;
+#else
+	// Resident set size from /proc
+	ifstream statm("/proc/self/statm");
+	uint64_t size = 0;
+	uint64_t resident = 0;
+	if (statm >> size >> resident) return resident * uint64_t(sysconf(_SC_PAGESIZE));
+	return 0;
+#endif
+}
+
+// --------------------------------------------------------------
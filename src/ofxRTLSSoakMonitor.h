@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ofMain.h"
+
+// Monitors memory and the sizes of internal structures over long runs and
+// checks that they stop growing. Metrics are sampled periodically. After a
+// warmup period, the growth of each metric is estimated with a least-squares
+// fit over all subsequent samples; the run fails if any metric grows faster
+// than its threshold.
+//
+// Settings are provided with json:
+// {
+//		"samplePeriodSec" : 10,
+//		"warmupSec" : 600,
+//		"minSamples" : 10,				// samples after warmup before growth is judged
+//		"logPath" : "soak.jsonl",		// each sample is appended as a line of json
+//		"maxGrowthPerHour" : {
+//			"process.memoryBytes" : 1048576,
+//			"*.keyMappings" : 100,
+//			"*" : 0
+//		}
+// }
+// Thresholds are matched by exact metric name, then by suffix ("*.name"),
+// then by the default ("*"). Metrics without a threshold are recorded but not
+// judged.
+class ofxRTLSSoakMonitor {
+public:
+
+	ofxRTLSSoakMonitor();
+	~ofxRTLSSoakMonitor();
+
+	void setup(const ofJson& settings);
+
+	// Sample the metrics if a sample is due. The memory of this process 
+	// is added as "process.memoryBytes".
+	// Returns true if a sample was taken.
+	bool update(const map<string, double>& metrics);
+
+	// Has any metric grown faster than its threshold?
+	bool isFailing();
+	// Seconds since monitoring began
+	float getElapsedSec();
+
+	// Get the growth of every metric, with its threshold and verdict
+	ofJson getReport();
+
+	// Get the memory used by this process (bytes), or 0 if unknown
+	static uint64_t getProcessMemoryBytes();
+
+private:
+
+	float samplePeriodSec = 10;
+	float warmupSec = 600;
+	int minSamples = 10;
+	string logPath = "";
+	ofJson maxGrowthPerHour;
+
+	uint64_t startTimeMS = 0;
+	uint64_t lastSampleTimeMS = 0;
+	bool bStarted = false;
+
+	// Samples of each metric after warmup, as pairs of time (hours) and value
+	map<string, vector< pair<double, double> > > samples;
+	// Last value of each metric
+	map<string, double> lastValues;
+
+	// Get the threshold of a metric. Returns false if it has none.
+	bool getThreshold(const string& metric, double& threshold);
+	// Fit the growth (units per hour) of a series of samples
+	double getGrowthPerHour(const vector< pair<double, double> >& series);
+};
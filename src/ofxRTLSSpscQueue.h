@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ofMain.h"
+
+// A bounded queue between a single producer thread and a single consumer
+// thread. Items are passed through a ring buffer; each side only waits
+// (on a condition variable) when the queue is full or empty.
+template<typename T>
+class ofxRTLSSpscQueue {
+public:
+
+	ofxRTLSSpscQueue() {};
+	~ofxRTLSSpscQueue() {};
+
+	// Allocate space for this many items. (Not thread-safe.)
+	void setup(size_t capacity) {
+		buffer.resize(MAX(capacity, size_t(1)) + 1);
+		head = 0;
+		tail = 0;
+		bClosed = false;
+	}
+
+	// Add an item, waiting while the queue is full.
+	// Returns false if the queue is closed.
+	bool push(const T& item) {
+		while (true) {
+			size_t t = tail.load(std::memory_order_relaxed);
+			size_t next = (t + 1) % buffer.size();
+			if (next != head.load(std::memory_order_acquire)) {
+				buffer[t] = item;
+				tail.store(next);
+				notify();
+				return true;
+			}
+			if (bClosed) return false;
+			wait([&] { return bClosed || (tail.load() + 1) % buffer.size() != head.load(); });
+		}
+	}
+
+	// Remove the oldest item, waiting while the queue is empty.
+	// Returns false if the queue is closed.
+	bool pop(T& item) {
+		while (true) {
+			if (tryPop(item)) return true;
+			if (bClosed) return false;
+			wait([&] { return bClosed || tail.load() != head.load(); });
+		}
+	}
+
+	// Remove the oldest item, if there is one
+	bool tryPop(T& item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) return false;
+		item = buffer[h];
+		head.store((h + 1) % buffer.size());
+		notify();
+		return true;
+	}
+
+	size_t size() {
+		size_t h = head.load();
+		size_t t = tail.load();
+		return (t + buffer.size() - h) % buffer.size();
+	}
+
+	// Wake and stop both sides
+	void close() {
+		bClosed = true;
+		std::lock_guard<std::mutex> lk(mutex);
+		cv.notify_all();
+	}
+
+private:
+
+	vector<T> buffer;
+	atomic<size_t> head = 0;	// next item to pop
+	atomic<size_t> tail = 0;	// next slot to push
+	atomic<bool> bClosed = false;
+
+	// The condition variable is only signaled when a side is waiting. A side
+	// registers as waiting before it checks the queue again, and the other
+	// side checks for waiters after updating the queue, so one of them
+	// always sees the other's change.
+	std::mutex mutex;
+	std::condition_variable cv;
+	atomic<int> nWaiting = 0;
+	template<typename Predicate>
+	void wait(Predicate predicate) {
+		std::unique_lock<std::mutex> lk(mutex);
+		nWaiting++;
+		cv.wait(lk, predicate);
+		nWaiting--;
+	}
+	void notify() {
+		if (nWaiting.load() == 0) return;
+		std::lock_guard<std::mutex> lk(mutex);
+		cv.notify_all();
+	}
+};
@@ -0,0 +1,242 @@
+#include "ofxRTLSSynchronizer.h"
+
+// --------------------------------------------------------------
+static inline glm::vec3 getPosition(const Trackable& t) {
+	return glm::vec3(t.position().x(), t.position().y(), t.position().z());
+}
+
+// --------------------------------------------------------------
+static inline void setPosition(Trackable& t, const glm::vec3& p) {
+	Trackable::Position* position = t.mutable_position();
+	position->set_x(p.x);
+	position->set_y(p.y);
+	position->set_z(p.z);
+}
+
+// --------------------------------------------------------------
+ofxRTLSSynchronizer::ofxRTLSSynchronizer() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSSynchronizer::~ofxRTLSSynchronizer() {
+	waitForThread(true);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSynchronizer::setup(const ofJson& settings) {
+
+	fps = settings.value("fps", 60.0f);
+	latencyMicros = uint64_t(MAX(settings.value("latencyMS", 20.0), 0.0) * 1000.0);
+	bufferMicros = uint64_t(MAX(settings.value("bufferMS", 250.0), 0.0) * 1000.0);
+	maxExtrapolationMicros = uint64_t(MAX(settings.value("maxExtrapolationMS", 10.0), 0.0) * 1000.0);
+	staleMicros = uint64_t(MAX(settings.value("staleMS", 100.0), 0.0) * 1000.0);
+	string type = ofToLower(settings.value("trackableType", string("sample")));
+	trackableType = RTLS_TRACKABLE_TYPE_SAMPLE;
+	for (int i = 0; i < NUM_RTLS_TRACKABLE_TYPES; i++) {
+		if (type == ofToLower(getRTLSTrackableTypeDescription(RTLSTrackableType(i)))) trackableType = RTLSTrackableType(i);
+	}
+
+	// Frames must be buffered for at least the latency, or there will be
+	// nothing to interpolate
+	if (bufferMicros < latencyMicros) {
+		ofLogWarning("ofxRTLSSynchronizer") << "The buffer is shorter than the latency. Extending it to " << latencyMicros / 1000 << " ms.";
+		bufferMicros = latencyMicros;
+	}
+
+	RTLSFrameContext c;
+	c.trackableType = trackableType;
+	context = c.toString();
+
+	pacer.setDesiredFPS(fps);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSynchronizer::start() {
+	if (isThreadRunning()) return;
+	pacer.reset();
+	startThread();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSynchronizer::stop() {
+	waitForThread(true);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSynchronizer::clear() {
+	std::lock_guard<std::mutex> lk(mutex);
+	streams.clear();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSynchronizer::frameReceived(ofxRTLSEventArgs& args) {
+
+	if (!isThreadRunning()) return;
+	if (args.trackableType != trackableType) return;
+
+	// Index this frame's trackables by key
+	Snapshot* snapshot = new Snapshot();
+	snapshot->timeMicros = args.timeMicros != 0 ? args.timeMicros : ofGetElapsedTimeMicros();
+	snapshot->frame = args.frame;
+	snapshot->keys.resize(snapshot->frame.trackables_size());
+	for (int i = 0; i < snapshot->frame.trackables_size(); i++) {
+		snapshot->keys[i] = getTrackableKey(snapshot->frame.trackables(i));
+		snapshot->index[snapshot->keys[i]] = i;
+	}
+
+	// Data without a source ID (e.g. played back with no primary source) is
+	// named by its system
+	string sourceID = args.sourceID.empty() ? ofToLower(getRTLSSystemTypeDescription(args.systemType)) : args.sourceID;
+
+	std::lock_guard<std::mutex> lk(mutex);
+	Stream& stream = streams[sourceID];
+	stream.sourceID = sourceID;
+	stream.systemType = args.systemType;
+	// Frames out of order are dropped
+	if (!stream.snapshots.empty() && snapshot->timeMicros <= stream.snapshots.back()->timeMicros) {
+		delete snapshot;
+		return;
+	}
+	stream.snapshots.push_back(shared_ptr<const Snapshot>(snapshot));
+	// Keep the buffer's duration (but always the last two frames)
+	while (stream.snapshots.size() > 2 &&
+		stream.snapshots.front()->timeMicros + bufferMicros < snapshot->timeMicros) {
+		stream.snapshots.pop_front();
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSynchronizer::threadedFunction() {
+
+	while (isThreadRunning()) {
+
+		// Wait until the next frame is due
+		if (!pacer.waitForNextFrame()) continue;
+
+		uint64_t now = ofGetElapsedTimeMicros();
+		if (now <= latencyMicros) continue;
+
+		ofxRTLSSyncArgs args;
+		if (merge(now - latencyMicros, args)) {
+			ofNotifyEvent(newFrameSynchronized, args);
+		}
+	}
+}
+
+// --------------------------------------------------------------
+bool ofxRTLSSynchronizer::merge(uint64_t timeMicros, ofxRTLSSyncArgs& out) {
+
+	// Copy the buffers, so sources can keep adding frames while they are merged
+	vector<Stream> current;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		for (auto it = streams.begin(); it != streams.end(); ) {
+			// Forget sources that have stopped sending data
+			uint64_t latest = it->second.snapshots.back()->timeMicros;
+			if (latest + staleMicros + bufferMicros < timeMicros) {
+				it = streams.erase(it);
+				continue;
+			}
+			current.push_back(it->second);
+			it++;
+		}
+	}
+
+	out.timeMicros = timeMicros;
+	out.frame.set_frame_id(frameID);
+	out.frame.set_timestamp(timeMicros / 1000);
+	out.frame.set_context(context);
+	for (auto& stream : current) {
+		uint64_t latest = stream.snapshots.back()->timeMicros;
+		if (latest + staleMicros < timeMicros) {
+			out.staleSources.push_back(stream.sourceID);
+			continue;
+		}
+		appendStream(stream, timeMicros, out);
+	}
+	if (out.streams.empty()) return false;
+
+	frameID++;
+	return true;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSSynchronizer::appendStream(const Stream& stream, uint64_t timeMicros, ofxRTLSSyncArgs& out) {
+
+	auto& snapshots = stream.snapshots;
+	size_t n = snapshots.size();
+
+	ofxRTLSSyncArgs::Stream s;
+	s.sourceID = stream.sourceID;
+	s.systemType = stream.systemType;
+	s.trackableType = trackableType;
+	s.begin = out.frame.trackables_size();
+	s.latestTimeMicros = snapshots.back()->timeMicros;
+
+	// Find the first frame at or after the common time
+	size_t i = 0;
+	while (i < n && snapshots[i]->timeMicros < timeMicros) i++;
+
+	if (i == n) {
+		// Extrapolate beyond the latest frame, from the velocity between
+		// the last two frames
+		s.mode = ofxRTLSSyncArgs::EXTRAPOLATED;
+		const Snapshot& b = *snapshots[n - 1];
+		const Snapshot* a = n >= 2 ? snapshots[n - 2].get() : NULL;
+		float dt = float(MIN(timeMicros - b.timeMicros, maxExtrapolationMicros));
+		float period = a != NULL ? float(b.timeMicros - a->timeMicros) : 0;
+		for (int k = 0; k < b.frame.trackables_size(); k++) {
+			Trackable* t = out.frame.add_trackables();
+			t->CopyFrom(b.frame.trackables(k));
+			if (a == NULL || period <= 0) continue;
+			auto prev = a->index.find(b.keys[k]);
+			if (prev == a->index.end()) continue;
+			glm::vec3 p = getPosition(b.frame.trackables(k));
+			glm::vec3 v = (p - getPosition(a->frame.trackables(prev->second))) / period;
+			setPosition(*t, p + v * dt);
+		}
+	}
+	else if (i == 0 || snapshots[i]->timeMicros == timeMicros) {
+		// Use the frame at the common time, or hold the oldest frame if
+		// all are later
+		s.mode = snapshots[i]->timeMicros == timeMicros ? ofxRTLSSyncArgs::INTERPOLATED : ofxRTLSSyncArgs::HELD;
+		const Snapshot& b = *snapshots[i];
+		for (int k = 0; k < b.frame.trackables_size(); k++) {
+			out.frame.add_trackables()->CopyFrom(b.frame.trackables(k));
+		}
+	}
+	else {
+		// Interpolate between the frames around the common time. Trackables
+		// are those of the nearer frame.
+		s.mode = ofxRTLSSyncArgs::INTERPOLATED;
+		const Snapshot& a = *snapshots[i - 1];
+		const Snapshot& b = *snapshots[i];
+		float alpha = float(timeMicros - a.timeMicros) / float(b.timeMicros - a.timeMicros);
+		const Snapshot& nearer = alpha < 0.5f ? a : b;
+		const Snapshot& farther = alpha < 0.5f ? b : a;
+		for (int k = 0; k < nearer.frame.trackables_size(); k++) {
+			Trackable* t = out.frame.add_trackables();
+			const Trackable& tn = nearer.frame.trackables(k);
+			t->CopyFrom(tn);
+			auto other = farther.index.find(nearer.keys[k]);
+			if (other == farther.index.end()) continue;
+			const Trackable& ta = alpha < 0.5f ? tn : a.frame.trackables(other->second);
+			const Trackable& tb = alpha < 0.5f ? b.frame.trackables(other->second) : tn;
+			setPosition(*t, glm::mix(getPosition(ta), getPosition(tb), alpha));
+			if (ta.has_orientation() && tb.has_orientation()) {
+				glm::quat qa(ta.orientation().w(), ta.orientation().x(), ta.orientation().y(), ta.orientation().z());
+				glm::quat qb(tb.orientation().w(), tb.orientation().x(), tb.orientation().y(), tb.orientation().z());
+				glm::quat q = glm::slerp(qa, qb, alpha);
+				Trackable::Orientation* orientation = t->mutable_orientation();
+				orientation->set_w(q.w);
+				orientation->set_x(q.x);
+				orientation->set_y(q.y);
+				orientation->set_z(q.z);
+			}
+		}
+	}
+
+	s.end = out.frame.trackables_size();
+	out.streams.push_back(s);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxRTLSEventArgs.h"
+#include "ofxRTLSTrackableKey.h"
+#include "ofxRTLSFramePacer.h"
+
+// Merges the frames of several sources (e.g. Motive and OpenVR), which
+// arrive on different threads at different rates, into single frames at a
+// common time, emitted at a chosen rate.
+//
+// The recent frames of each source are held in a jitter buffer. Each output
+// frame is due at a fixed latency behind the present. For each source, the
+// positions of its trackables at that time are interpolated between the two
+// frames around it, or, if its latest frame is earlier, extrapolated from its
+// last two frames (by at most the extrapolation bound). Sources whose latest
+// frame is older than the staleness bound are left out. Trackables are
+// matched across a source's frames by their keys, and take their other
+// fields from the source's frame nearest the common time.
+//
+// Settings (all optional):
+//	"fps"					rate of the output frames (default 60)
+//	"latencyMS"				delay of the common time behind the present (default 20)
+//	"bufferMS"				duration of each source's jitter buffer (default 250)
+//	"maxExtrapolationMS"	bound on extrapolation (default 10)
+//	"staleMS"				bound on the age of a source's latest frame (default 100)
+//	"trackableType"			type of trackables merged (default "sample")
+class ofxRTLSSynchronizer : private ofThread {
+public:
+
+	ofxRTLSSynchronizer();
+	~ofxRTLSSynchronizer();
+
+	void setup(const ofJson& settings);
+
+	void start();
+	void stop();
+	bool isRunning() { return isThreadRunning(); }
+
+	// Add a frame from a source. Frames are timed by their timeMicros (or
+	// by when they are added, if not set). This can be called from any thread.
+	void frameReceived(ofxRTLSEventArgs& args);
+
+	// This event is notified (on the synchronizer's thread) with each merged frame
+	ofEvent<ofxRTLSSyncArgs> newFrameSynchronized;
+
+	void clear();
+
+	ofxRTLSFramePacer::Stats getPacingStats() { return pacer.getStats(); }
+
+private:
+
+	// Settings (us)
+	float fps = 60;
+	uint64_t latencyMicros = 20000;
+	uint64_t bufferMicros = 250000;
+	uint64_t maxExtrapolationMicros = 10000;
+	uint64_t staleMicros = 100000;
+	RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_SAMPLE;
+
+	// A frame of a source, with its trackables indexed by key
+	struct Snapshot {
+		uint64_t timeMicros = 0;
+		TrackableFrame frame;
+		vector<string> keys;
+		unordered_map<string, int> index;
+	};
+	// The jitter buffer of a source, in order of time
+	struct Stream {
+		string sourceID = "";
+		RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+		deque< shared_ptr<const Snapshot> > snapshots;
+	};
+	map<string, Stream> streams;
+	std::mutex mutex;
+
+	void threadedFunction();
+	ofxRTLSFramePacer pacer;
+
+	// Merge the streams at a time. Returns false if no stream contributed.
+	bool merge(uint64_t timeMicros, ofxRTLSSyncArgs& out);
+	void appendStream(const Stream& stream, uint64_t timeMicros, ofxRTLSSyncArgs& out);
+
+	uint64_t frameID = 0;
+	string context = "";
+};
@@ -1,5 +1,280 @@
 #include "ofxRTLSTake.h"
 
+// --------------------------------------------------------------
+bool RTLSTake::add(int systemIndex, float systemFPS, const RTLSProtocol::TrackableFrame& _frame) {
+
+	// Ensure this system has been approved by the take
+	if (!systemExists(systemIndex)) {
+		// If not, will it?
+		if (fps < 0) fps = systemFPS;
+		else if (abs(fps - systemFPS) > 0.001) {
+			ofLogWarning("RTLSTake") << "Cannot record from multiple systems at once that have different frame rates";
+			return false;
+		}
+		// Take can accept system, so add it
+		data[systemIndex] = RTLSTakeSystemData();
+	}
+
+	// Add this frame to the system data
+	RTLSProtocol::TrackableFrame* frame = new RTLSProtocol::TrackableFrame(_frame);
+	data[systemIndex].nextFrame.push_back(frame);
+	return true;
+}
+
+// --------------------------------------------------------------
+void RTLSTake::update(int systemIndex) {
+
+	// Make sure this system is present in the recording
+	if (!systemExists(systemIndex)) return;
+
+	// Get this system data
+	auto& sysData = data[systemIndex];
+
+	// Include all trackable keys in the label set
+	for (auto& frame : sysData.nextFrame) {
+		for (int i = 0; i < frame->trackables_size(); i++) {
+			auto& tk = frame->trackables(i);
+			string key = getTrackableKey(tk);
+			auto ret = c3dPointLabels.insert(key);
+			
+			// Add a description if it is a new element
+			if (ret.second) {
+
+				// Parse the frame-specific context
+				RTLSFrameContext frameContext;
+				bool bFrameContext = RTLSFrameContext::parse(frame->context(), frameContext);
+				
+				// Parse the trackable-specific context
+				ofJson trackableContext;
+				try {
+					trackableContext = ofJson::parse(frame->trackables(i).context());
+				}
+				catch (const std::exception&) {
+					// Could not parse
+				}
+
+				// Add all information to the descriptions
+				// TODO: Allow both trackable and frame context to pass calibration flags 'm'
+				ofJson js;
+				if (bFrameContext && frameContext.systemType != RTLS_SYSTEM_TYPE_INVALID) js["frame"]["context"]["s"] = int(frameContext.systemType);
+				if (bFrameContext && frameContext.trackableType != RTLS_TRACKABLE_TYPE_INVALID) js["frame"]["context"]["t"] = int(frameContext.trackableType);
+				if (!trackableContext.empty()) js["trackable"]["context"] = trackableContext;				
+				if (!tk.name().empty()) js["trackable"]["name"] = tk.name();
+				if (!tk.cuid().empty()) js["trackable"]["cuid"] = tk.cuid();
+				if (tk.id() != 0) js["trackable"]["id"] = tk.id();
+				c3dPointLabels2Desc[key] = js.dump();
+			}
+		}
+	}
+
+	// Add the vector of frames to the queue and clear the vector
+	sysData.addNextFrame();
+}
+
+// --------------------------------------------------------------
+bool RTLSTake::save(atomic<int>* framesSaved) {
+
+	// Add all point labels
+	for (auto& label : c3dPointLabels) {
+		c3d.point(label);
+	}
+
+	// Create a map from point labels to their index
+	map<string, int> c3dPointLabels2Index;
+	uint64_t counter = 0;
+	for (auto& label : c3dPointLabels) {
+		c3dPointLabels2Index[label] = counter;
+		counter++;
+	}
+	
+	// Set the recording's properties, after adding the points.
+
+	// Point Properties
+	ezc3d::ParametersNS::GroupNS::Parameter pointRate("RATE");
+	pointRate.set(fps);
+	c3d.parameter("POINT", pointRate);
+	ezc3d::ParametersNS::GroupNS::Parameter pointScale("SCALE");
+	pointScale.set(-1.0);
+	c3d.parameter("POINT", pointScale);
+	ezc3d::ParametersNS::GroupNS::Parameter pointUnits("UNITS");
+	pointUnits.set("m");
+	c3d.parameter("POINT", pointUnits);
+	ezc3d::ParametersNS::GroupNS::Parameter pointDescriptions("DESCRIPTIONS");
+	vector<string> pointDesc;
+	for (auto& label : c3dPointLabels) {
+		if (c3dPointLabels2Desc.find(label) != c3dPointLabels2Desc.end()) {
+			pointDesc.push_back(c3dPointLabels2Desc[label]);
+		}
+		else {
+			pointDesc.push_back("");
+		}
+	}
+	pointDescriptions.set(pointDesc);
+	c3d.parameter("POINT", pointDescriptions);
+
+	// Manufacturer Properties
+	ezc3d::ParametersNS::GroupNS::Parameter mfrCompany("COMPANY");
+	mfrCompany.set("Local Projects");
+	c3d.parameter("MANUFACTURER", mfrCompany);
+	ezc3d::ParametersNS::GroupNS::Parameter mfrSoftware("SOFTWARE");
+	mfrSoftware.set("RTLSServer");
+	c3d.parameter("MANUFACTURER", mfrSoftware);
+	ezc3d::ParametersNS::GroupNS::Parameter mfrSoftwareDesc("SOFTWARE_DESCRIPTION");
+	mfrSoftwareDesc.set("Real Time Location System Server");
+	c3d.parameter("MANUFACTURER", mfrSoftwareDesc);
+	ezc3d::ParametersNS::GroupNS::Parameter mfrVersion("VERSION_LABEL");
+	mfrVersion.set("1.0"); // arbitrary
+	c3d.parameter("MANUFACTURER", mfrVersion);
+
+	
+	// Add all points
+	// NAN will stand for absent points
+	int nPoints = c3dPointLabels.size();
+	while (!empty()) {
+
+		// Create a new c3d frame 
+		ezc3d::DataNS::Frame frame;
+
+		// Create points and populate each with NANs
+		ezc3d::DataNS::Points3dNS::Points points;
+		for (int i = 0; i < nPoints; i++) {
+			ezc3d::DataNS::Points3dNS::Point point;
+			point.set(NAN, NAN, NAN);
+			points.point(point);
+		}
+
+		// Iterate through all contributing systems
+		map<int, RTLSTakeSystemData>::iterator sys;
+		for (sys = data.begin(); sys != data.end(); sys++) {
+
+			// Get the queue of frames. Each frame is a vector of TrackableFrames (TF's), since
+			// one system can output multiple TF's each frame (for example, Motive can export
+			// both observer and marker points each frame).
+			queue<vector<RTLSProtocol::TrackableFrame*>>& frameQueue = sys->second.frames;
+			// If the frame is empty, then there are no points left to add.
+			if (frameQueue.empty()) continue;
+			
+			// Get the next set of trackable frames
+			vector<RTLSProtocol::TrackableFrame*>& frameSet = frameQueue.front();
+			// Iterate through all of these frames
+			RTLSProtocol::TrackableFrame* tkFrame;
+			for (int frameIndex = 0; frameIndex < frameSet.size(); frameIndex++) {
+				tkFrame = frameSet[frameIndex];
+
+				// For each frame, iterate through all of its trackables
+				for (int i = 0; i < tkFrame->trackables_size(); i++) {
+					
+					// Get the next trackable in this TF
+					auto& tk = tkFrame->trackables(i);
+
+					// Get the key and access the point corresponding with this key.
+					string key = getTrackableKey(tk);
+					auto& point = points.point(c3dPointLabels2Index[key]); // check for valid index?
+					// Set the position
+					point.set(
+						tk.position().x(), 
+						tk.position().y(), 
+						tk.position().z());
+				}
+			}
+
+			// Pop the front value that we just processed from the queue.
+			sys->second.clearAndPopNextFrame();
+		}
+
+		// Add the points to the frame
+		frame.add(points);
+
+		// Add the frame to the take
+		c3d.frame(frame);
+
+		// Increment the number of frames saved
+		if (framesSaved != NULL) ++(*framesSaved);
+	}
+	
+	// Save the c3d to file
+	ofFilePath::createEnclosingDirectory(path);
+	c3d.write(path);
+
+	return true;
+}
+
+// --------------------------------------------------------------
+bool RTLSPlayerTake::load() {
+
+	// Verify the validity of this take
+	if (path.empty()) return false;
+
+	// Attempt to load the c3d file
+	bool bSuccess = false;
+	try {
+		if (c3d != NULL) { // should not get to this point...
+			delete c3d;
+			c3d = NULL;
+		}
+		c3d = new ezc3d::c3d(path);
+		bSuccess = true;
+	}
+	catch (const std::exception&) {
+		ofLogError("ofxRTLSTake") << "Could not read c3d file \"" << path << "\"";
+	}
+	if (!bSuccess) return false;
+
+	// Make sure this c3d file has been generated by RTLS and
+	// not another program.
+	// Parameters: MANUFACTURER > SOFTWARE > RTLSServer
+	vector<string> values(c3d->parameters().group("MANUFACTURER").parameter("SOFTWARE").valuesAsString());
+	if (values.empty()) return false;
+	string software = ofTrim(ofToLower(values.front()));
+	if (software.compare("rtlsserver") != 0) {
+		ofLogError("ofxRTLSTake") << "Cannot play a c3d file generated by a different utility.";
+		return false;
+	}
+
+	// Try to populate the take with template frames
+	bSuccess = false;
+	try {
+		bSuccess = populateTemplateFrames();
+	}
+	catch (const std::exception&) {
+		bSuccess = false;
+	}
+	if (!bSuccess) {
+		ofLogError("ofxRTLSTake") << "Could not parse take's data.";
+	}
+	return bSuccess;
+}
+
+// --------------------------------------------------------------
+void RTLSPlayerTake::readFrame(Frame& _f, const ezc3d::DataNS::Points3dNS::Points& pts, uint64_t frameIndex) {
+
+	auto& frame = _f.newFrame;
+	auto& refFrame = _f.frame;
+
+	// Prepare the frame for incoming data
+	frame.Clear();
+	frame.CopyFrom(refFrame);
+	frame.clear_trackables();
+	// Set all relevant points, filling the frame with data from the c3d file
+	for (int index = 0; index < _f.dataIndices.size(); index++) {
+		// "index" indicates the index of a trackable in the refFrame
+		// "ptIndex" will indicate the corresponding point in the c3d file's list of points
+		int ptIndex = _f.dataIndices[index];
+		if (pts.point(ptIndex).isValid()) {
+			Trackable* tk = frame.add_trackables();
+			tk->CopyFrom(refFrame.trackables(index));
+			Trackable::Position* position = tk->mutable_position();
+			position->set_x(pts.point(ptIndex).x());
+			position->set_y(pts.point(ptIndex).y());
+			position->set_z(pts.point(ptIndex).z());
+			_f.bNewData = true;
+		}
+	}
+
+	// Set the frame ID
+	frame.set_frame_id(frameIndex);
+}
+
 // --------------------------------------------------------------
 bool RTLSPlayerTake::populateTemplateFrames() {
 	if (c3d == NULL) return false;
@@ -64,7 +64,7 @@ public:
 	// Is this take empty?
 	bool empty() {
 		if (data.size() == 0) return true;
-		for (auto it : data) {
+		for (auto& it : data) {
 			if (!it.second.empty()) return false;
 		}
 		return true;
@@ -84,6 +84,31 @@ public:
 		}
 	}
 
+	// What is the number of frames for this take?
+	// Note: This reports the current, not absolute
+	// number of frames. As such, this is only valid is data
+	// has not already been removed in the saving process.
+	int getNumFrames()
+	{
+		int nFrames = 0;
+		for (auto& item : data)
+		{
+			if (item.second.size() > nFrames) nFrames = item.second.size();
+		}
+		return nFrames;
+	}
+
+	// Add any number of TrackableFrames for a system...
+	// (Returns false if this system cannot be added to the take.)
+	bool add(int systemIndex, float systemFPS, const RTLSProtocol::TrackableFrame& _frame);
+	// ... then complete this system's frame, collecting the labels 
+	// and descriptions of all of its trackables.
+	void update(int systemIndex);
+
+	// Write this take to its path. All frame data is consumed in the process.
+	// Optionally, provide a counter that is incremented as frames are written.
+	bool save(atomic<int>* framesSaved = NULL);
+
 	// C3D data structure
 	// This cannot be written in real time because all of the trackable (point)
 	// labels must be collected and written to the c3d header before storing
@@ -153,6 +178,14 @@ public:
 	map<int, int> dataIndexToFrameIndex;
 	bool populateTemplateFrames();
 
+	// Load this take's c3d file from its path and populate the
+	// template frames. Only files written by RTLS can be loaded.
+	bool load();
+
+	// Fill a frame's newFrame with the data at a given frame index
+	// of the c3d file.
+	void readFrame(Frame& f, const ezc3d::DataNS::Points3dNS::Points& pts, uint64_t frameIndex);
+
 	// Current frame (time) index
 	uint64_t frameCounter = 0;
 };
@@ -1 +1,29 @@
 #include "ofxRTLSTypes.h"
+
+// --------------------------------------------------------------
+string RTLSFrameContext::toString() const {
+
+	ofJson js;
+	js["s"] = int(systemType);
+	js["t"] = int(trackableType);
+	if (!sourceID.empty()) js["i"] = sourceID;
+	return js.dump();
+}
+
+// --------------------------------------------------------------
+bool RTLSFrameContext::parse(const string& context, RTLSFrameContext& out) {
+
+	out = RTLSFrameContext();
+	ofJson js;
+	try {
+		js = ofJson::parse(context);
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+	if (!js.is_object()) return false;
+	if (js.find("s") != js.end() && js["s"].is_number_integer()) out.systemType = RTLSSystemType(js["s"].get<int>());
+	if (js.find("t") != js.end() && js["t"].is_number_integer()) out.trackableType = RTLSTrackableType(js["t"].get<int>());
+	if (js.find("i") != js.end() && js["i"].is_string()) out.sourceID = js["i"].get<string>();
+	return true;
+}
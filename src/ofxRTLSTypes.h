@@ -36,4 +36,19 @@ inline string getRTLSTrackableTypeDescription(RTLSTrackableType trackableType)
 	case RTLS_TRACKABLE_TYPE_OBSERVER: return "Observer";
 	default: return "Invalid";
 	}
-}
\ No newline at end of file
+}
+// The context of a frame, which describes the source of its data. Frames 
+// carry it as a json string (see the README). Sources build their context
+// strings once, so frames are sent without any json work; consumers can 
+// read the typed fields from ofxRTLSEventArgs, or parse the string here.
+struct RTLSFrameContext {
+	RTLSSystemType systemType = RTLS_SYSTEM_TYPE_INVALID;
+	RTLSTrackableType trackableType = RTLS_TRACKABLE_TYPE_INVALID;
+	// ID of the source (empty if unknown, e.g. for played recordings)
+	string sourceID = "";
+
+	// Get the json string of this context
+	string toString() const;
+	// Parse a context string. Returns false if it could not be parsed.
+	static bool parse(const string& context, RTLSFrameContext& out);
+};
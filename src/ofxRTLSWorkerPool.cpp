@@ -0,0 +1,104 @@
+#include "ofxRTLSWorkerPool.h"
+
+// --------------------------------------------------------------
+ofxRTLSWorkerPool::ofxRTLSWorkerPool() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSWorkerPool::~ofxRTLSWorkerPool() {
+	stop();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkerPool::setup(int nThreads) {
+
+	stop();
+
+	if (nThreads <= 0) nThreads = MAX(int(std::thread::hardware_concurrency()), 1);
+	bStop = false;
+	for (int i = 0; i < nThreads - 1; i++) {
+		threads.push_back(std::thread(&ofxRTLSWorkerPool::worker, this));
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkerPool::stop() {
+
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		bStop = true;
+	}
+	cv.notify_all();
+	for (auto& t : threads) t.join();
+	threads.clear();
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkerPool::run(size_t _nChunks, const std::function<void(size_t)>& _job) {
+
+	if (_nChunks == 0) return;
+
+	// Publish the job
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		job = &_job;
+		nChunks = _nChunks;
+		nextChunk = 0;
+		nRemaining = _nChunks;
+		generation++;
+	}
+	if (!threads.empty()) cv.notify_all();
+
+	// Help run it
+	runChunks(&_job, _nChunks);
+
+	// Wait until all chunks have completed and no worker can take another
+	// chunk of this job.
+	std::unique_lock<std::mutex> lk(mutex);
+	cvDone.wait(lk, [this] { return nRemaining == 0 && nActive == 0; });
+	job = NULL;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkerPool::runChunks(const std::function<void(size_t)>* _job, size_t _nChunks) {
+
+	size_t chunk;
+	while ((chunk = nextChunk++) < _nChunks) {
+		(*_job)(chunk);
+		if (--nRemaining == 0) {
+			std::lock_guard<std::mutex> lk(mutex);
+			cvDone.notify_all();
+		}
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkerPool::worker() {
+
+	uint64_t lastGeneration = 0;
+	while (true) {
+
+		const std::function<void(size_t)>* _job = NULL;
+		size_t _nChunks = 0;
+		{
+			std::unique_lock<std::mutex> lk(mutex);
+			cv.wait(lk, [&] { return bStop || (generation != lastGeneration && job != NULL); });
+			if (bStop) return;
+			lastGeneration = generation;
+			_job = job;
+			_nChunks = nChunks;
+			nActive++;
+		}
+
+		runChunks(_job, _nChunks);
+
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			nActive--;
+		}
+		cvDone.notify_all();
+	}
+}
+
+// --------------------------------------------------------------
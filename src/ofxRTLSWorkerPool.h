@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ofMain.h"
+
+// A fixed set of threads that run the chunks of a job in parallel.
+// The thread that calls run() also runs chunks, so no work is handed off
+// when the pool has a single thread.
+class ofxRTLSWorkerPool {
+public:
+
+	ofxRTLSWorkerPool();
+	~ofxRTLSWorkerPool();
+
+	// Start the pool with a total of nThreads threads, including the 
+	// calling thread. (0 uses one thread per core.)
+	void setup(int nThreads = 0);
+	int getNumThreads() { return int(threads.size()) + 1; }
+
+	// Run job(chunk) for every chunk in [0, nChunks) and block until 
+	// all chunks have completed. Chunks may run in any order.
+	void run(size_t nChunks, const std::function<void(size_t)>& job);
+
+	// Stop all threads.
+	void stop();
+
+private:
+
+	vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::condition_variable cvDone;
+	bool bStop = false;
+
+	// The current job
+	uint64_t generation = 0;
+	const std::function<void(size_t)>* job = NULL;
+	size_t nChunks = 0;
+	atomic<size_t> nextChunk = 0;
+	atomic<size_t> nRemaining = 0;
+	// Number of worker threads taking chunks of the current job
+	int nActive = 0;
+
+	void worker();
+	void runChunks(const std::function<void(size_t)>* job, size_t nChunks);
+};
@@ -0,0 +1,209 @@
+#include "ofxRTLSWorkingSet.h"
+
+// --------------------------------------------------------------
+ofxRTLSWorkingSet::ofxRTLSWorkingSet() {
+
+}
+
+// --------------------------------------------------------------
+ofxRTLSWorkingSet::~ofxRTLSWorkingSet() {
+
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::load(RTLSProtocol::TrackableFrame& _frame) {
+
+	frame = &_frame;
+	size_t n = frame->trackables_size();
+	keys.resize(n);
+	keyTypes.resize(n);
+	positions.resize(n);
+	flags.assign(n, 0);
+	sources.resize(n);
+	nRemoved = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		const Trackable& t = frame->trackables(i);
+		keys[i] = getTrackableKey(t, keyTypes[i]);
+		positions[i] = glm::vec3(t.position().x(), t.position().y(), t.position().z());
+		sources[i] = i;
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::writeBack() {
+
+	if (frame == NULL) return;
+
+	compact();
+
+	// Move the remaining trackables to the front of the frame. Sources are
+	// in increasing order, so each is swapped with a removed trackable
+	// that precedes it.
+	int nKept = 0;
+	for (size_t i = 0; i < size(); i++) {
+		if (sources[i] < 0) continue;
+		if (sources[i] != nKept) frame->mutable_trackables()->SwapElements(nKept, sources[i]);
+		sources[i] = nKept++;
+	}
+	while (frame->trackables_size() > nKept) frame->mutable_trackables()->RemoveLast();
+
+	// Write back changes
+	for (size_t i = 0; i < size(); i++) {
+		Trackable* t = NULL;
+		if (sources[i] < 0) {
+			t = frame->add_trackables();
+			sources[i] = frame->trackables_size() - 1;
+			flags[i] |= KEY_CHANGED | POSITION_CHANGED;
+		}
+		else if (flags[i] != 0) {
+			t = frame->mutable_trackables(sources[i]);
+		}
+		if (t == NULL) continue;
+
+		if (flags[i] & KEY_CHANGED) reconcileTrackableWithKey(*t, keys[i]);
+		if (flags[i] & POSITION_CHANGED) {
+			Trackable::Position* position = t->mutable_position();
+			position->set_x(positions[i].x);
+			position->set_y(positions[i].y);
+			position->set_z(positions[i].z);
+		}
+		flags[i] = 0;
+	}
+
+	frame = NULL;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::toFrame(RTLSProtocol::TrackableFrame& out) {
+
+	out.Clear();
+	for (size_t i = 0; i < size(); i++) {
+		if (isRemoved(i)) continue;
+		Trackable* t = out.add_trackables();
+		reconcileTrackableWithKey(*t, keys[i]);
+		Trackable::Position* position = t->mutable_position();
+		position->set_x(positions[i].x);
+		position->set_y(positions[i].y);
+		position->set_z(positions[i].z);
+	}
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::clear() {
+
+	keys.clear();
+	keyTypes.clear();
+	positions.clear();
+	flags.clear();
+	sources.clear();
+	nRemoved = 0;
+	frame = NULL;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::swap(ofxRTLSWorkingSet& other) {
+
+	keys.swap(other.keys);
+	keyTypes.swap(other.keyTypes);
+	positions.swap(other.positions);
+	flags.swap(other.flags);
+	sources.swap(other.sources);
+	std::swap(nRemoved, other.nRemoved);
+	std::swap(frame, other.frame);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::copyFrom(ofxRTLSWorkingSet& other) {
+
+	size_t n = other.getNumActive();
+	keys.resize(n);
+	keyTypes.resize(n);
+	positions.resize(n);
+	flags.assign(n, 0);
+	sources.assign(n, -1);
+	nRemoved = 0;
+	frame = NULL;
+
+	size_t j = 0;
+	for (size_t i = 0; i < other.size(); i++) {
+		if (other.isRemoved(i)) continue;
+		keys[j] = other.keys[i];
+		keyTypes[j] = other.keyTypes[i];
+		positions[j] = other.positions[i];
+		j++;
+	}
+}
+
+// --------------------------------------------------------------
+Trackable* ofxRTLSWorkingSet::getSource(size_t i) {
+
+	if (frame == NULL || sources[i] < 0) return NULL;
+	return frame->mutable_trackables(sources[i]);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::setKey(size_t i, const string& key) {
+
+	keys[i] = key;
+	keyTypes[i] = getTrackableKeyType(key);
+	flags[i] |= KEY_CHANGED;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::setPosition(size_t i, const glm::vec3& position) {
+
+	positions[i] = position;
+	flags[i] |= POSITION_CHANGED;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::remove(size_t i) {
+
+	if (flags[i] & REMOVED) return;
+	flags[i] |= REMOVED;
+	nRemoved++;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::add(const string& key, const glm::vec3& position) {
+
+	keys.push_back(key);
+	keyTypes.push_back(getTrackableKeyType(key));
+	positions.push_back(position);
+	flags.push_back(KEY_CHANGED | POSITION_CHANGED);
+	sources.push_back(-1);
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::compact() {
+
+	if (nRemoved == 0) return;
+
+	size_t nKept = 0;
+	for (size_t i = 0; i < size(); i++) {
+		if (flags[i] & REMOVED) continue;
+		if (i != nKept) {
+			keys[nKept].swap(keys[i]);
+			keyTypes[nKept] = keyTypes[i];
+			positions[nKept] = positions[i];
+			flags[nKept] = flags[i];
+			sources[nKept] = sources[i];
+		}
+		nKept++;
+	}
+	keys.resize(nKept);
+	keyTypes.resize(nKept);
+	positions.resize(nKept);
+	flags.resize(nKept);
+	sources.resize(nKept);
+	nRemoved = 0;
+}
+
+// --------------------------------------------------------------
+void ofxRTLSWorkingSet::updateKeyFromSource(size_t i) {
+
+	Trackable* t = getSource(i);
+	if (t == NULL) return;
+	keys[i] = getTrackableKey(*t, keyTypes[i]);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ofMain.h"
+#include "Trackable.pb.h"
+using namespace RTLSProtocol;
+#include "ofxRTLSTrackableKey.h"
+
+// The per-frame working set of a postprocessor. When a frame is loaded,
+// the key, key type and position of each trackable are read once into
+// contiguous arrays (structure-of-arrays). Postprocessing stages then operate
+// on these arrays, and the frame is compacted and updated once, when the
+// working set is written back.
+// Notes:
+// -	Rows are kept in the order of the frame's trackables. Rows added by
+//		stages (e.g. filters that persist trackables) follow.
+// -	Removed rows are only flagged until the working set is compacted,
+//		so row indices stay valid within a stage.
+// -	All other fields of a trackable (e.g. its context) remain in the frame.
+//		Stages that change them directly should refresh the row's key
+//		with updateKeyFromSource().
+class ofxRTLSWorkingSet {
+public:
+
+	ofxRTLSWorkingSet();
+	~ofxRTLSWorkingSet();
+
+	// Read the trackables of a frame. The frame must outlive the working set
+	// until it is written back.
+	void load(RTLSProtocol::TrackableFrame& frame);
+	// Compact the frame and write back keys and positions that have changed.
+	void writeBack();
+	// Fill a frame with a trackable for each row (only keys and positions are set)
+	void toFrame(RTLSProtocol::TrackableFrame& frame);
+
+	size_t size() { return keys.size(); }
+	// Number of rows that have not been removed
+	size_t getNumActive() { return keys.size() - nRemoved; }
+	bool empty() { return keys.empty(); }
+	void clear();
+	// Swap all rows with another working set (reusing each other's memory)
+	void swap(ofxRTLSWorkingSet& other);
+	// Copy the keys and positions of another working set's rows that have 
+	// not been removed (without a frame to write back to)
+	void copyFrom(ofxRTLSWorkingSet& other);
+
+	const string& getKey(size_t i) { return keys[i]; }
+	TrackableKeyType getKeyType(size_t i) { return keyTypes[i]; }
+	const glm::vec3& getPosition(size_t i) { return positions[i]; }
+	bool isRemoved(size_t i) { return flags[i] & REMOVED; }
+	// Get the trackable of this row in the loaded frame (NULL if the row was added)
+	Trackable* getSource(size_t i);
+
+	void setKey(size_t i, const string& key);
+	void setPosition(size_t i, const glm::vec3& position);
+	// Flag a row as removed
+	void remove(size_t i);
+	// Add a row with a key and position
+	void add(const string& key, const glm::vec3& position);
+	// Remove flagged rows from the arrays, keeping the order of all other rows.
+	// (The frame itself is only compacted when written back.)
+	void compact();
+	// Read the key of a row from its trackable again
+	void updateKeyFromSource(size_t i);
+
+private:
+
+	enum Flags : uint8_t {
+		REMOVED = 1 << 0,
+		KEY_CHANGED = 1 << 1,
+		POSITION_CHANGED = 1 << 2
+	};
+
+	vector<string> keys;
+	vector<TrackableKeyType> keyTypes;
+	vector<glm::vec3> positions;
+	vector<uint8_t> flags;
+	// Index of each row's trackable in the frame (-1 if added)
+	vector<int> sources;
+	size_t nRemoved = 0;
+
+	RTLSProtocol::TrackableFrame* frame = NULL;
+};